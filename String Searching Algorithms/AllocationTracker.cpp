@@ -0,0 +1,127 @@
+#include "AllocationTracker.h"
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+
+// The counts for each thread. They're plain integers, so they're ready before anything else runs and nothing needs allocating to use them.
+static thread_local uint64_t allocationCount = 0;
+static thread_local uint64_t freeCount = 0;
+static thread_local uint64_t allocatedBytes = 0;
+
+// Allocates memory the way operator new has to: asking for 0 bytes still gives a unique pointer, and if there's no memory the new handler is called
+// to free some up, and std::bad_alloc is thrown if there isn't one. Returns nullptr instead of throwing if 'nothrow' is set.
+static void* allocate(std::size_t size, bool nothrow)
+{
+	allocationCount++;
+	allocatedBytes += size;
+
+	if (size == 0)
+	{
+		size = 1;
+	}
+	for (;;)
+	{
+		void* memory = std::malloc(size);
+		if (memory != nullptr)
+		{
+			return memory;
+		}
+
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+		{
+			if (nothrow)
+			{
+				return nullptr;
+			}
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+static void release(void* memory)
+{
+	if (memory != nullptr)
+	{
+		freeCount++;
+		std::free(memory);
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate(size, false);
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate(size, false);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size, true);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size, true);
+}
+
+void operator delete(void* memory) noexcept
+{
+	release(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	release(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	release(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	release(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	release(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	release(memory);
+}
+
+AllocationTracker::AllocationTracker()
+{
+	start();
+}
+
+AllocationTracker::~AllocationTracker()
+{
+}
+
+AllocationStats AllocationTracker::current()
+{
+	AllocationStats stats = { allocationCount, freeCount, allocatedBytes };
+	return stats;
+}
+
+void AllocationTracker::start()
+{
+	started = current();
+}
+
+AllocationStats AllocationTracker::stop() const
+{
+	AllocationStats now = current();
+	AllocationStats stats = { now.allocations - started.allocations, now.frees - started.frees, now.bytes - started.bytes };
+	return stats;
+}
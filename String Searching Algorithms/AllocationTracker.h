@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// The memory allocations made between AllocationTracker's start() and stop().
+struct AllocationStats
+{
+	uint64_t allocations;
+	uint64_t frees;
+	uint64_t bytes;
+};
+
+// Counts every call to the global operator new and operator delete, so it can be seen how much memory a search asks for each time it runs.
+// AllocationTracker.cpp replaces the global operators, so the counts are always kept once it's linked in. They're kept separately for each thread,
+// which means a worker thread or a background merge allocating at the same time doesn't get counted against the search being measured.
+// Only allocations that go through operator new are seen. Anything that calls malloc() directly, such as the C library's own buffers, isn't counted.
+class AllocationTracker
+{
+public:
+	// Constructor and destructor.
+	AllocationTracker();
+	~AllocationTracker();
+
+	// Remembers the counts so far on this thread, and returns how many allocations, frees and bytes there have been on this thread since then.
+	void start();
+	AllocationStats stop() const;
+
+	// The totals on this thread since it started.
+	static AllocationStats current();
+
+private:
+	AllocationStats started;
+};
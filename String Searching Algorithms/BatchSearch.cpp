@@ -0,0 +1,332 @@
+#include "BatchSearch.h"
+#include "CompiledPattern.h"
+#include "DoubleArrayTrie.h"
+#include "WorkerPool.h"
+#include "ThreadArena.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+using the_clock = std::chrono::steady_clock;
+
+// Roughly how many times more work a step of the automaton is than a step of Boyer-Moore, which is used when choosing the mode.
+static const size_t automatonCost = 8;
+
+// Chunks of text aren't made smaller than this, so that the overlap and the per-task work stay small compared to the search.
+static const size_t minimumChunk = 1 << 20;
+
+// A task that searches the whole text for a range of the keywords.
+class PatternTask :
+	public Task
+{
+public:
+	PatternTask(BatchSearch* b, const char* t, size_t l, int f, int e, size_t* m)
+	{
+		batch = b;
+		text = t;
+		length = l;
+		first = f;
+		end = e;
+		matches = m;
+	};
+
+	void run()
+	{
+		// The match list comes from the thread's pool, so it keeps the room it grew to in the thread's earlier tasks.
+		PooledBuffer offsets;
+		CompiledPattern pattern;
+		size_t found = 0;
+		for (int p = first; p < end; p++)
+		{
+			offsets->clear();
+			pattern.compile(batch->getPatterns()[p]);
+			pattern.findAll(text, length, *offsets);
+			found += offsets->size();
+
+			// Each keyword's results go to the file as soon as they are ready, rather than waiting for the whole batch.
+			if (!offsets->empty())
+			{
+				batch->writePattern(p, *offsets);
+			}
+		}
+		*matches = found;
+	};
+
+private:
+	BatchSearch* batch;
+	const char* text;
+	size_t length;
+	int first;
+	int end;
+	size_t* matches;
+};
+
+// A task that searches one chunk of the text for every keyword.
+class ChunkTask :
+	public Task
+{
+public:
+	ChunkTask(const DoubleArrayTrie* a, const char* t, size_t l, size_t s, size_t e, std::vector<MultiMatch>* r)
+	{
+		automaton = a;
+		text = t;
+		length = l;
+		start = s;
+		end = e;
+		results = r;
+	};
+
+	void run()
+	{
+		// Carry on past the end of the chunk by the length of the longest keyword, so that keywords that cross into the next chunk aren't missed.
+		// Only matches that start inside this chunk are kept, so nothing is found twice.
+		size_t overlap = automaton->getLongestKeyword() > 0 ? size_t(automaton->getLongestKeyword() - 1) : 0;
+		size_t stop = std::min(length, end + overlap);
+		automaton->search(text + start, stop - start, *results);
+
+		size_t kept = 0;
+		for (size_t i = 0; i < results->size(); i++)
+		{
+			MultiMatch m = (*results)[i];
+			if (m.position < end - start)
+			{
+				m.position += start;
+				(*results)[kept++] = m;
+			}
+		}
+		results->resize(kept);
+	};
+
+private:
+	const DoubleArrayTrie* automaton;
+	const char* text;
+	size_t length;
+	size_t start;
+	size_t end;
+	std::vector<MultiMatch>* results;
+};
+
+BatchSearch::BatchSearch()
+{
+	binary = true;
+}
+
+BatchSearch::~BatchSearch()
+{
+}
+
+bool BatchSearch::loadPatterns(const std::string& filename)
+{
+	std::ifstream ifs(filename);
+	if (!ifs)
+	{
+		return false;
+	}
+
+	patterns.clear();
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		if (!line.empty())
+		{
+			patterns.push_back(line);
+		}
+	}
+	return true;
+}
+
+BatchMode BatchSearch::chooseMode(size_t textLength) const
+{
+	// Boyer-Moore looks at about one character in every keyword-length characters, so the cost of searching for each keyword separately
+	// is the sum of textLength / keyLength. The automaton looks at every character once, whatever the number of keywords.
+	double separateCost = 0;
+	for (const std::string& p : patterns)
+	{
+		separateCost += double(textLength) / double(std::max<size_t>(1, std::min<size_t>(p.length(), 256)));
+	}
+	double automatonTotal = double(textLength) * automatonCost;
+
+	return separateCost <= automatonTotal ? BatchMode::PatternParallel : BatchMode::TextParallel;
+}
+
+void BatchSearch::writePattern(int pattern, const std::vector<size_t>& offsets)
+{
+	std::lock_guard<std::mutex> lock(outputMutex);
+	if (binary)
+	{
+		binaryOutput.writePattern(pattern, patterns[pattern], offsets);
+		return;
+	}
+
+	output << pattern << '\t' << offsets.size() << '\t';
+	for (size_t i = 0; i < offsets.size(); i++)
+	{
+		if (i > 0)
+		{
+			output << ' ';
+		}
+		output << offsets[i];
+	}
+	output << '\n';
+}
+
+size_t BatchSearch::runPatternParallel(const char* t, size_t length, int threads)
+{
+	// Split the keywords into a few more groups than there are threads, so that a thread that finishes early can pick up another group.
+	int groups = std::min(int(patterns.size()), threads * 4);
+	std::vector<size_t> matches(groups, 0);
+
+	WorkerPool pool;
+	pool.start(threads);
+	for (int g = 0; g < groups; g++)
+	{
+		int first = int(patterns.size() * g / groups);
+		int end = int(patterns.size() * (g + 1) / groups);
+		pool.add_task(new PatternTask(this, t, length, first, end, &matches[g]));
+	}
+	pool.wait();
+	pool.stop();
+
+	size_t total = 0;
+	for (size_t m : matches)
+	{
+		total += m;
+	}
+	return total;
+}
+
+size_t BatchSearch::runTextParallel(const char* t, size_t length, int threads)
+{
+	DoubleArrayTrie automaton;
+	automaton.build(patterns);
+
+	size_t chunks = std::max<size_t>(1, std::min<size_t>(size_t(threads) * 4, length / minimumChunk));
+	std::vector<std::vector<MultiMatch>> chunkResults(chunks);
+
+	WorkerPool pool;
+	pool.start(threads);
+	for (size_t c = 0; c < chunks; c++)
+	{
+		pool.add_task(new ChunkTask(&automaton, t, length, length * c / chunks, length * (c + 1) / chunks, &chunkResults[c]));
+	}
+	pool.wait();
+	pool.stop();
+
+	// Group the matches by keyword. Going through the chunks in order keeps each keyword's positions in order.
+	std::vector<size_t> counts(patterns.size() + 1, 0);
+	size_t total = 0;
+	for (const std::vector<MultiMatch>& r : chunkResults)
+	{
+		for (const MultiMatch& m : r)
+		{
+			counts[m.pattern + 1]++;
+		}
+		total += r.size();
+	}
+	for (size_t p = 1; p < counts.size(); p++)
+	{
+		counts[p] += counts[p - 1];
+	}
+
+	std::vector<size_t> offsets(total);
+	std::vector<size_t> next(counts.begin(), counts.end() - 1);
+	for (const std::vector<MultiMatch>& r : chunkResults)
+	{
+		for (const MultiMatch& m : r)
+		{
+			offsets[next[m.pattern]++] = m.position;
+		}
+	}
+
+	// The automaton only reports the first copy of a repeated keyword, so copies get the same results as the first one.
+	std::vector<int> firstCopy(patterns.size());
+	std::unordered_map<std::string, int> seen;
+	for (int p = 0; p < int(patterns.size()); p++)
+	{
+		firstCopy[p] = seen.emplace(patterns[p], p).first->second;
+	}
+
+	std::vector<size_t> single;
+	for (int p = 0; p < int(patterns.size()); p++)
+	{
+		int source = firstCopy[p];
+		if (counts[source + 1] == counts[source])
+		{
+			continue;
+		}
+		single.assign(offsets.begin() + counts[source], offsets.begin() + counts[source + 1]);
+		writePattern(p, single);
+		if (source != p)
+		{
+			total += single.size();
+		}
+	}
+	return total;
+}
+
+BatchStats BatchSearch::run(const char* t, size_t length, const std::string& outputFile, int threads)
+{
+	BatchStats stats;
+	stats.mode = chooseMode(length);
+	stats.patterns = patterns.size();
+	stats.textBytes = length;
+	stats.matches = 0;
+	stats.seconds = 0;
+	stats.written = false;
+
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+
+	the_clock::time_point startTime = the_clock::now();
+
+	binary = outputFile.length() < 4 || outputFile.compare(outputFile.length() - 4, 4, ".txt") != 0;
+	if (binary)
+	{
+		stats.written = binaryOutput.open(outputFile, length);
+	}
+	else
+	{
+		output.open(outputFile, std::ios::binary | std::ios::trunc);
+		output << "# patterns " << patterns.size() << " text-bytes " << length << '\n';
+		stats.written = bool(output);
+	}
+
+	// There's no point searching if the results can't be kept.
+	if (!stats.written)
+	{
+		output.close();
+		output.clear();
+		return stats;
+	}
+
+	if (!patterns.empty())
+	{
+		if (stats.mode == BatchMode::PatternParallel)
+		{
+			stats.matches = runPatternParallel(t, length, threads);
+		}
+		else
+		{
+			stats.matches = runTextParallel(t, length, threads);
+		}
+	}
+	if (binary)
+	{
+		stats.written = binaryOutput.close();
+	}
+	else
+	{
+		stats.written = bool(output);
+		output.close();
+		stats.written = stats.written && !output.fail();
+	}
+
+	stats.seconds = std::chrono::duration<double>(the_clock::now() - startTime).count();
+	return stats;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <cstddef>
+#include "SearchTypes.h"
+#include "ResultFile.h"
+
+// The two ways a batch of keywords can be split between threads.
+enum class BatchMode
+{
+	PatternParallel,	// Each thread takes some of the keywords and searches the whole text for each of them with Boyer-Moore.
+	TextParallel		// Each thread takes a chunk of the text and searches it for every keyword at once with the Aho-Corasick automaton.
+};
+
+// Totals from running a batch, for working out throughput.
+struct BatchStats
+{
+	BatchMode mode;
+	size_t patterns;
+	size_t matches;
+	size_t textBytes;
+	double seconds;
+
+	// Whether the results file could be created and written. If it couldn't be created, nothing is searched.
+	bool written;
+
+	double queriesPerSecond() const { return seconds > 0 ? patterns / seconds : 0; };
+	double gigabytesPerSecond() const { return seconds > 0 ? textBytes / seconds / 1e9 : 0; };
+};
+
+// Searches one text for a whole file of keywords, using every core.
+// With only a few keywords it's quickest to give each thread its own keywords and let Boyer-Moore skip through the text,
+// but with thousands of keywords that means thousands of passes over the text, so instead the text is split up and each chunk gets one pass with the automaton.
+// Results are written to the output file as they are found. By default this is the binary result file format (see ResultWriter), which is much smaller than text
+// for large result sets. If the output file name ends in .txt a text file is written instead, with one line per keyword: the keyword's index, the number of matches, then the match positions.
+class BatchSearch
+{
+public:
+	// Constructor and destructor.
+	BatchSearch();
+	~BatchSearch();
+
+	// Loads the keywords from a file, one per line. Returns false if the file couldn't be opened.
+	bool loadPatterns(const std::string& filename);
+	void setPatterns(const std::vector<std::string>& p) { patterns = p; };
+	const std::vector<std::string>& getPatterns() const { return patterns; };
+
+	// Picks the mode that should be quickest for this many keywords and this size of text.
+	BatchMode chooseMode(size_t textLength) const;
+
+	// Searches the text for every keyword and writes the results to the output file. The stats say whether the results were written.
+	BatchStats run(const char* t, size_t length, const std::string& outputFile, int threads);
+
+	// Writes one keyword's results to the output. Called from the worker threads, so only one can write at a time.
+	void writePattern(int pattern, const std::vector<size_t>& offsets);
+
+protected:
+	// Searches for the keywords on separate threads, each searching the whole text.
+	size_t runPatternParallel(const char* t, size_t length, int threads);
+
+	// Searches chunks of the text on separate threads, each looking for all of the keywords.
+	size_t runTextParallel(const char* t, size_t length, int threads);
+
+	std::vector<std::string> patterns;
+
+	// The results file, and a mutex so that only one thread writes to it at a time.
+	bool binary;
+	ResultWriter binaryOutput;
+	std::ofstream output;
+	std::mutex outputMutex;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// ASCII case folding used by the case-insensitive searches. Only 'A' to 'Z' are changed, so every character stays one byte
+// and a match in folded text is at exactly the same position as in the original text.
+inline unsigned char foldCase(unsigned char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+// Gives the other case of a letter, or the same character if it isn't a letter.
+inline unsigned char otherCase(unsigned char c)
+{
+	if (c >= 'A' && c <= 'Z')
+	{
+		return (unsigned char)(c + ('a' - 'A'));
+	}
+	if (c >= 'a' && c <= 'z')
+	{
+		return (unsigned char)(c - ('a' - 'A'));
+	}
+	return c;
+}
@@ -0,0 +1,99 @@
+#include "CompiledPattern.h"
+#include "CaseFolding.h"
+#include <cstring>
+
+CompiledPattern::CompiledPattern()
+{
+	compile("");
+}
+
+CompiledPattern::CompiledPattern(const std::string& kw, bool ignoreCase)
+{
+	compile(kw, ignoreCase);
+}
+
+CompiledPattern::~CompiledPattern()
+{
+}
+
+void CompiledPattern::compile(const std::string& kw, bool ignoreCase)
+{
+	keyword = kw;
+	caseless = ignoreCase;
+	size_t keyLength = keyword.length();
+
+	if (caseless)
+	{
+		for (char& c : keyword)
+		{
+			c = char(foldCase((unsigned char)c));
+		}
+	}
+
+	// If the character isn't in the keyword, it can skip the whole word.
+	for (int i = 0; i < 256; i++)
+	{
+		skip[i] = keyLength;
+	}
+
+	// If the character is in the keyword, it can skip forward the rest of the keyword's length. The last character is left out so that the skip is never 0.
+	for (size_t i = 0; i + 1 < keyLength; i++)
+	{
+		unsigned char c = (unsigned char)keyword[i];
+		skip[c] = (keyLength - 1) - i;
+		if (caseless)
+		{
+			skip[otherCase(c)] = (keyLength - 1) - i;
+		}
+	}
+}
+
+bool CompiledPattern::matchesAt(const char* t) const
+{
+	if (!caseless)
+	{
+		return memcmp(t, keyword.data(), keyword.length()) == 0;
+	}
+
+	// Fold each character of the text as it's compared rather than making a folded copy.
+	for (size_t j = 0; j < keyword.length(); j++)
+	{
+		if (foldCase((unsigned char)t[j]) != (unsigned char)keyword[j])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t CompiledPattern::find(const char* t, size_t length, size_t from) const
+{
+	size_t keyLength = keyword.length();
+	if (keyLength == 0 || length < keyLength)
+	{
+		return npos;
+	}
+
+	size_t last = keyLength - 1;
+	unsigned char lastChar = (unsigned char)keyword[last];
+	for (size_t i = from; i <= length - keyLength; )
+	{
+		unsigned char c = (unsigned char)t[i + last];
+
+		// Only compare the rest of the keyword if the last character matches.
+		if ((caseless ? foldCase(c) : c) == lastChar && matchesAt(t + i))
+		{
+			return i;
+		}
+		i += skip[c];
+	}
+	return npos;
+}
+
+void CompiledPattern::findAll(const char* t, size_t length, std::vector<size_t>& results) const
+{
+	for (size_t i = find(t, length, 0); i != npos; i = find(t, length, i + 1))
+	{
+		results.push_back(i);
+	}
+}
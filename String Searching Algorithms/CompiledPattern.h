@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// A keyword that has been prepared for the Boyer-Moore (Horspool) search once, so that it can be searched for over and over without building the skip table each time.
+// It works on a pointer and a length, so the text doesn't need to be copied into a std::string first.
+// If the pattern is case-insensitive, the keyword is stored in lower case and both cases of each letter are put in the skip table, so that the text never needs to be folded.
+class CompiledPattern
+{
+public:
+	// Returned by find() when there are no more matches.
+	static const size_t npos = size_t(-1);
+
+	// Constructors and destructor.
+	CompiledPattern();
+	CompiledPattern(const std::string& kw, bool ignoreCase = false);
+	~CompiledPattern();
+
+	// Builds the skip table for a keyword.
+	void compile(const std::string& kw, bool ignoreCase = false);
+
+	// Returns the position of the first match at or after 'from', or npos if there isn't one.
+	size_t find(const char* t, size_t length, size_t from = 0) const;
+
+	// Adds the position of every match in the text to the results.
+	void findAll(const char* t, size_t length, std::vector<size_t>& results) const;
+
+	// Checks whether the keyword is at a position, without using the skip table.
+	bool matchesAt(const char* t) const;
+
+	const std::string& getKeyword() const { return keyword; };
+	size_t length() const { return keyword.length(); };
+	bool getIgnoreCase() const { return caseless; };
+
+protected:
+	// The keyword, in lower case if the pattern is case-insensitive.
+	std::string keyword;
+	bool caseless;
+
+	// How far to move forward when a character is under the last position of the keyword. Using size_t means the table works for keywords of any length.
+	size_t skip[256];
+};
@@ -0,0 +1,426 @@
+#include "CompressedReader.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+CompressedReader::CompressedReader()
+{
+	format = CompressionFormat::None;
+	writeIndex = 0;
+	readIndex = 0;
+	ready = 0;
+	holding = false;
+	finished = true;
+	stopping = false;
+	error = false;
+}
+
+CompressedReader::~CompressedReader()
+{
+	close();
+}
+
+bool CompressedReader::supports(CompressionFormat f)
+{
+	switch (f)
+	{
+	case CompressionFormat::Gzip:
+#ifdef USE_ZLIB
+		return true;
+#else
+		return false;
+#endif
+	case CompressionFormat::Zstd:
+#ifdef USE_ZSTD
+		return true;
+#else
+		return false;
+#endif
+	default:
+		return true;
+	}
+}
+
+CompressionFormat CompressedReader::detectFormat(const std::string& filename)
+{
+	std::ifstream ifs(filename, std::ios::binary);
+	unsigned char magic[4] = { 0, 0, 0, 0 };
+	ifs.read(reinterpret_cast<char*>(magic), sizeof(magic));
+	size_t got = size_t(ifs.gcount());
+
+	if (got >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+	{
+		return CompressionFormat::Gzip;
+	}
+	if (got >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+	{
+		return CompressionFormat::Zstd;
+	}
+	return CompressionFormat::None;
+}
+
+bool CompressedReader::open(const std::string& name, size_t bufferSize, int bufferCount)
+{
+	close();
+
+	if (!std::ifstream(name, std::ios::binary))
+	{
+		return false;
+	}
+	format = detectFormat(name);
+	if (!supports(format))
+	{
+		return false;
+	}
+
+	// At least two buffers are needed, so that one can be filled while the other is being searched.
+	if (bufferCount < 2)
+	{
+		bufferCount = 2;
+	}
+	if (bufferSize == 0)
+	{
+		bufferSize = 1;
+	}
+
+	filename = name;
+	buffers.assign(bufferCount, std::vector<char>(bufferSize));
+	lengths.assign(bufferCount, 0);
+	writeIndex = 0;
+	readIndex = 0;
+	ready = 0;
+	holding = false;
+	finished = false;
+	stopping = false;
+	error = false;
+
+	producer = std::thread(&CompressedReader::produce, this);
+	return true;
+}
+
+void CompressedReader::close()
+{
+	if (producer.joinable())
+	{
+		{
+			std::unique_lock<std::mutex> lock(ringMutex);
+			stopping = true;
+		}
+		bufferFreed.notify_all();
+		producer.join();
+	}
+	buffers.clear();
+	lengths.clear();
+	ready = 0;
+	holding = false;
+	finished = true;
+}
+
+bool CompressedReader::next(const char*& data, size_t& length)
+{
+	std::unique_lock<std::mutex> lock(ringMutex);
+
+	// The block handed out last time is finished with, so the background thread can fill it again.
+	if (holding)
+	{
+		holding = false;
+		readIndex = (readIndex + 1) % int(buffers.size());
+		bufferFreed.notify_one();
+	}
+
+	while (ready == 0 && !finished)
+	{
+		bufferFilled.wait(lock);
+	}
+	if (ready == 0)
+	{
+		return false;
+	}
+
+	data = buffers[readIndex].data();
+	length = lengths[readIndex];
+	ready--;
+	holding = true;
+	return true;
+}
+
+std::vector<char>* CompressedReader::emptyBuffer()
+{
+	std::unique_lock<std::mutex> lock(ringMutex);
+	while (!stopping && ready + (holding ? 1 : 0) >= int(buffers.size()))
+	{
+		bufferFreed.wait(lock);
+	}
+	if (stopping)
+	{
+		return nullptr;
+	}
+
+	// Only the background thread touches this buffer until it's published, so it can be filled without holding the lock.
+	return &buffers[writeIndex];
+}
+
+void CompressedReader::publish(size_t length)
+{
+	{
+		std::unique_lock<std::mutex> lock(ringMutex);
+		lengths[writeIndex] = length;
+		writeIndex = (writeIndex + 1) % int(buffers.size());
+		ready++;
+	}
+	bufferFilled.notify_one();
+}
+
+void CompressedReader::produce()
+{
+	switch (format)
+	{
+	case CompressionFormat::Gzip:
+		produceGzip();
+		break;
+	case CompressionFormat::Zstd:
+		produceZstd();
+		break;
+	default:
+		producePlain();
+		break;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(ringMutex);
+		finished = true;
+	}
+	bufferFilled.notify_all();
+}
+
+void CompressedReader::producePlain()
+{
+	std::ifstream ifs(filename, std::ios::binary);
+	while (ifs)
+	{
+		std::vector<char>* buffer = emptyBuffer();
+		if (buffer == nullptr)
+		{
+			return;
+		}
+		ifs.read(buffer->data(), buffer->size());
+		size_t got = size_t(ifs.gcount());
+		if (got > 0)
+		{
+			publish(got);
+		}
+	}
+	if (ifs.bad())
+	{
+		error = true;
+	}
+}
+
+#ifdef USE_ZLIB
+void CompressedReader::produceGzip()
+{
+	gzFile gz = gzopen(filename.c_str(), "rb");
+	if (gz == nullptr)
+	{
+		error = true;
+		return;
+	}
+	gzbuffer(gz, 1 << 17);
+
+	// gzread() carries on into the next member if several gzip files have been joined together, the same as gunzip does.
+	bool done = false;
+	while (!done)
+	{
+		std::vector<char>* buffer = emptyBuffer();
+		if (buffer == nullptr)
+		{
+			break;
+		}
+
+		size_t filled = 0;
+		while (filled < buffer->size())
+		{
+			unsigned request = unsigned(std::min(buffer->size() - filled, size_t(1) << 30));
+			int got = gzread(gz, buffer->data() + filled, request);
+			if (got < 0)
+			{
+				error = true;
+				done = true;
+				break;
+			}
+			if (got == 0)
+			{
+				done = true;
+				break;
+			}
+			filled += size_t(got);
+		}
+		if (filled > 0)
+		{
+			publish(filled);
+		}
+	}
+	gzclose(gz);
+}
+#else
+void CompressedReader::produceGzip()
+{
+	error = true;
+}
+#endif
+
+#ifdef USE_ZSTD
+void CompressedReader::produceZstd()
+{
+	std::ifstream ifs(filename, std::ios::binary);
+	ZSTD_DStream* stream = ZSTD_createDStream();
+	if (!ifs || stream == nullptr)
+	{
+		error = true;
+		ZSTD_freeDStream(stream);
+		return;
+	}
+	ZSTD_initDStream(stream);
+
+	std::vector<char> input(ZSTD_DStreamInSize());
+	ZSTD_inBuffer in = { input.data(), 0, 0 };
+	std::vector<char>* buffer = emptyBuffer();
+	ZSTD_outBuffer out = { buffer ? buffer->data() : nullptr, buffer ? buffer->size() : 0, 0 };
+	size_t lastResult = 0;
+
+	while (buffer != nullptr)
+	{
+		// Read more compressed data once the last lot has all been used.
+		if (in.pos == in.size)
+		{
+			ifs.read(input.data(), input.size());
+			in.size = size_t(ifs.gcount());
+			in.pos = 0;
+			if (in.size == 0)
+			{
+				break;
+			}
+		}
+
+		// A result of 0 means a frame has just finished. The stream starts on the next frame by itself if there is one.
+		lastResult = ZSTD_decompressStream(stream, &out, &in);
+		if (ZSTD_isError(lastResult))
+		{
+			error = true;
+			break;
+		}
+
+		if (out.pos == out.size)
+		{
+			publish(out.pos);
+			buffer = emptyBuffer();
+			out = { buffer ? buffer->data() : nullptr, buffer ? buffer->size() : 0, 0 };
+		}
+	}
+
+	// Flush whatever is left, which needs more calls if the output buffer filled up right at the end of the input.
+	while (buffer != nullptr && !error && lastResult != 0)
+	{
+		size_t before = out.pos;
+		lastResult = ZSTD_decompressStream(stream, &out, &in);
+		if (ZSTD_isError(lastResult))
+		{
+			error = true;
+			break;
+		}
+		if (out.pos == out.size)
+		{
+			publish(out.pos);
+			buffer = emptyBuffer();
+			out = { buffer ? buffer->data() : nullptr, buffer ? buffer->size() : 0, 0 };
+		}
+		else if (out.pos == before)
+		{
+			// No progress with all of the input used means the file was cut short.
+			error = true;
+			break;
+		}
+	}
+
+	if (buffer != nullptr && out.pos > 0)
+	{
+		publish(out.pos);
+	}
+	ZSTD_freeDStream(stream);
+}
+#else
+void CompressedReader::produceZstd()
+{
+	error = true;
+}
+#endif
+
+bool compressFile(const std::string& input, const std::string& output, CompressionFormat format)
+{
+	std::ifstream ifs(input, std::ios::binary);
+	if (!ifs)
+	{
+		return false;
+	}
+	std::string text((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+	if (format == CompressionFormat::Gzip)
+	{
+#ifdef USE_ZLIB
+		gzFile gz = gzopen(output.c_str(), "wb6");
+		if (gz == nullptr)
+		{
+			return false;
+		}
+		bool ok = text.empty() || gzwrite(gz, text.data(), unsigned(text.length())) == int(text.length());
+		return gzclose(gz) == Z_OK && ok;
+#else
+		return false;
+#endif
+	}
+
+	if (format == CompressionFormat::Zstd)
+	{
+#ifdef USE_ZSTD
+		std::vector<char> compressed(ZSTD_compressBound(text.length()));
+		size_t size = ZSTD_compress(compressed.data(), compressed.size(), text.data(), text.length(), 3);
+		if (ZSTD_isError(size))
+		{
+			return false;
+		}
+		std::ofstream ofs(output, std::ios::binary | std::ios::trunc);
+		ofs.write(compressed.data(), size);
+		return bool(ofs);
+#else
+		return false;
+#endif
+	}
+
+	std::ofstream ofs(output, std::ios::binary | std::ios::trunc);
+	ofs << text;
+	return bool(ofs);
+}
+
+bool decompressFile(const std::string& input, const std::string& output)
+{
+	CompressedReader reader;
+	if (!reader.open(input))
+	{
+		return false;
+	}
+	std::ofstream ofs(output, std::ios::binary | std::ios::trunc);
+	const char* data;
+	size_t length;
+	while (reader.next(data, length))
+	{
+		ofs.write(data, length);
+	}
+	return bool(ofs) && !reader.hadError();
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// gzip support needs zlib and zstd support needs libzstd. Define USE_ZLIB and/or USE_ZSTD and link the library to turn them on.
+// Without them, files in that format can't be opened, but uncompressed files can still be read through the same pipeline.
+
+// The formats that CompressedReader can recognise from the first bytes of a file.
+enum class CompressionFormat
+{
+	None,
+	Gzip,
+	Zstd
+};
+
+// Reads a file that may be compressed and hands out the decompressed text in blocks.
+// The decompression runs on its own thread and fills a ring of buffers ahead of the caller, so the search on the calling thread and the decompression
+// run at the same time on different cores, and the decompressed text is never written to disk.
+// Blocks are handed out in order but a match can be split across two of them, so they should be searched with something that carries state from one block
+// to the next, such as IncrementalSearch::feed().
+class CompressedReader
+{
+public:
+	// Constructor and destructor.
+	CompressedReader();
+	~CompressedReader();
+
+	// Opens a file and starts decompressing it in the background. Returns false if the file can't be opened, or it's in a format that wasn't compiled in.
+	bool open(const std::string& filename, size_t bufferSize = 1 << 20, int bufferCount = 4);
+
+	// Gets the next block of decompressed text. The block stays valid until the next call to next() or close(). Returns false at the end of the file or after an error.
+	bool next(const char*& data, size_t& length);
+
+	// Stops the background thread and closes the file.
+	void close();
+
+	CompressionFormat getFormat() const { return format; };
+
+	// Whether the decompression stopped because the file was damaged or couldn't be read.
+	bool hadError() const { return error; };
+
+	// Whether a format is supported in this build.
+	static bool supports(CompressionFormat f);
+
+	// Works out the format of a file from its first few bytes.
+	static CompressionFormat detectFormat(const std::string& filename);
+
+protected:
+	// Runs on the background thread and decompresses the whole file into the ring.
+	void produce();
+	void producePlain();
+	void produceGzip();
+	void produceZstd();
+
+	// Waits for a buffer that the reader isn't using and returns it, or returns nullptr if the reader has been closed.
+	std::vector<char>* emptyBuffer();
+
+	// Passes the buffer returned by emptyBuffer() to the reader, holding 'length' bytes.
+	void publish(size_t length);
+
+	std::string filename;
+	CompressionFormat format;
+
+	// The ring of buffers. The background thread fills them starting at writeIndex, and next() hands them out starting at readIndex.
+	std::vector<std::vector<char>> buffers;
+	std::vector<size_t> lengths;
+	int writeIndex;
+	int readIndex;
+
+	// How many buffers are full and waiting for next(), and whether the caller is still using the last one it was given.
+	int ready;
+	bool holding;
+
+	// Set when the background thread has finished, when it should give up early, and when it found a problem with the file.
+	bool finished;
+	bool stopping;
+	std::atomic<bool> error;
+
+	std::mutex ringMutex;
+	std::condition_variable bufferFilled;
+	std::condition_variable bufferFreed;
+	std::thread producer;
+};
+
+// Compresses a file, used for making test data. Returns false if the format isn't supported in this build or the files couldn't be used.
+bool compressFile(const std::string& input, const std::string& output, CompressionFormat format);
+
+// Decompresses a whole file to disk, which is what has to be done to search a compressed file without CompressedReader.
+bool decompressFile(const std::string& input, const std::string& output);
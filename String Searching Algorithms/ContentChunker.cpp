@@ -0,0 +1,310 @@
+#include "ContentChunker.h"
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include "RollingHash.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
+
+// Data shorter than this isn't worth splitting between threads.
+static const size_t minimumParallel = 1 << 22;
+
+// A task that finds every position from 'start' up to but not including 'end' where the hash of the window ending there allows a cut.
+class CutTask :
+	public Task
+{
+public:
+	CutTask(const ContentChunker* c, const char* d, size_t s, size_t e, std::vector<size_t>* r)
+	{
+		chunker = c;
+		data = d;
+		start = s;
+		end = e;
+		results = r;
+	};
+
+	void run()
+	{
+		size_t window = chunker->window;
+		size_t first = std::max(start, window);
+		if (first >= end)
+		{
+			return;
+		}
+
+		RollingHash hash(window);
+		uint64_t h = hash.init(data + first - window);
+		const int shift = 64 - chunker->cutBits;
+		for (size_t p = first; ; )
+		{
+			if ((h >> shift) == 0)
+			{
+				results->push_back(p);
+			}
+			if (++p >= end)
+			{
+				break;
+			}
+			h = hash.roll((unsigned char)data[p - 1 - window], (unsigned char)data[p - 1]);
+		}
+	};
+
+private:
+	const ContentChunker* chunker;
+	const char* data;
+	size_t start;
+	size_t end;
+	std::vector<size_t>* results;
+};
+
+// A task that fingerprints a range of the chunks.
+class FingerprintTask :
+	public Task
+{
+public:
+	FingerprintTask(const char* d, std::vector<Chunk>* c, size_t f, size_t e)
+	{
+		data = d;
+		chunks = c;
+		first = f;
+		end = e;
+	};
+
+	void run()
+	{
+		for (size_t i = first; i < end; i++)
+		{
+			Chunk& c = (*chunks)[i];
+			c.fingerprint = ContentChunker::fingerprint(data + c.offset, c.length);
+		}
+	};
+
+private:
+	const char* data;
+	std::vector<Chunk>* chunks;
+	size_t first;
+	size_t end;
+};
+
+ContentChunker::ContentChunker(size_t minSize, size_t averageSize, size_t maxSize, size_t windowSize)
+{
+	window = windowSize == 0 ? 1 : windowSize;
+	setSizes(minSize, averageSize, maxSize);
+}
+
+ContentChunker::~ContentChunker()
+{
+}
+
+void ContentChunker::setSizes(size_t minSize, size_t averageSize, size_t maxSize)
+{
+	// The window has to fit inside the shortest chunk, since the hash isn't looked at until it has a full window of the chunk's own bytes.
+	minimum = minSize < window ? window : minSize;
+	maximum = maxSize < minimum ? minimum : maxSize;
+
+	// A cut needs cutBits bits of the hash to be zero, which happens once every 2^cutBits bytes on average.
+	cutBits = 0;
+	while (cutBits < 63 && (size_t(1) << (cutBits + 1)) <= averageSize)
+	{
+		cutBits++;
+	}
+}
+
+size_t ContentChunker::findCut(const char* data, size_t start, size_t length) const
+{
+	size_t remaining = length - start;
+	if (remaining <= minimum)
+	{
+		return length;
+	}
+	size_t end = remaining > maximum ? start + maximum : length;
+
+	// Nothing before minSize can be a cut, so the hash starts on the window that finishes there. This skips most of the hashing for the short chunks.
+	RollingHash hash(window);
+	size_t i = start + minimum - window;
+	uint64_t h = hash.init(data + i);
+	const int shift = 64 - cutBits;
+	for (i += window; ; i++)
+	{
+		// The top bits of the polynomial hash depend on every byte in the window, unlike the bottom bits, so those are the ones that are checked.
+		if (cutBits == 0 || (h >> shift) == 0)
+		{
+			return i;
+		}
+		if (i >= end)
+		{
+			return end;
+		}
+		h = hash.roll((unsigned char)data[i - window], (unsigned char)data[i]);
+	}
+}
+
+uint64_t ContentChunker::fingerprint(const char* data, size_t length)
+{
+	// Mixes in 8 bytes at a time with a multiply and shifts, then the leftover bytes, then the length.
+	const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+	uint64_t h = 0xCBF29CE484222325ULL;
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		h = (h ^ word) * multiplier;
+		h ^= h >> 29;
+	}
+	uint64_t last = 0;
+	memcpy(&last, data + i, length - i);
+	h = (h ^ last ^ (uint64_t(length) << 56)) * multiplier;
+	h ^= h >> 32;
+	h *= multiplier;
+	h ^= h >> 29;
+	return h;
+}
+
+void ContentChunker::findCutsParallel(const char* data, size_t length, int threads, std::vector<size_t>& cuts) const
+{
+	// The positions are where a chunk would end, so they go from 1 up to and including the length.
+	size_t parts = size_t(threads) * 4;
+	std::vector<std::vector<size_t>> candidates(parts);
+
+	WorkerPool pool;
+	pool.start(threads);
+	for (size_t p = 0; p < parts; p++)
+	{
+		pool.add_task(new CutTask(this, data, 1 + length * p / parts, 1 + length * (p + 1) / parts, &candidates[p]));
+	}
+	pool.wait();
+	pool.stop();
+
+	// Go through the candidates in order and pick the same ones that findCut() would: the first one at least minSize after the start of the chunk,
+	// or the end of the chunk if there isn't one before maxSize.
+	size_t start = 0;
+	size_t part = 0;
+	size_t next = 0;
+	while (start < length)
+	{
+		size_t end = length;
+		if (length - start > minimum)
+		{
+			size_t limit = std::min(start + maximum, length);
+			end = limit;
+			for (; part < parts; part++, next = 0)
+			{
+				const std::vector<size_t>& c = candidates[part];
+				while (next < c.size() && c[next] < start + minimum)
+				{
+					next++;
+				}
+				if (next < c.size())
+				{
+					end = std::min(c[next], limit);
+					break;
+				}
+			}
+		}
+		cuts.push_back(end);
+		start = end;
+	}
+}
+
+std::vector<Chunk> ContentChunker::chunk(const char* data, size_t length, int threads) const
+{
+	std::vector<Chunk> chunks;
+	if (length == 0)
+	{
+		return chunks;
+	}
+	bool parallel = threads > 1 && length >= minimumParallel && cutBits > 0;
+
+	// Find where each chunk ends.
+	std::vector<size_t> cuts;
+	cuts.reserve(length / (minimum + (size_t(1) << cutBits)) + 1);
+	if (parallel)
+	{
+		findCutsParallel(data, length, threads, cuts);
+	}
+	else
+	{
+		for (size_t start = 0; start < length; start = cuts.back())
+		{
+			cuts.push_back(findCut(data, start, length));
+		}
+	}
+
+	chunks.resize(cuts.size());
+	size_t start = 0;
+	for (size_t i = 0; i < cuts.size(); i++)
+	{
+		chunks[i].offset = start;
+		chunks[i].length = uint32_t(cuts[i] - start);
+		chunks[i].duplicateOf = -1;
+		start = cuts[i];
+	}
+
+	// Fingerprint the chunks.
+	if (parallel)
+	{
+		WorkerPool pool;
+		pool.start(threads);
+		size_t groups = size_t(threads) * 4;
+		for (size_t g = 0; g < groups; g++)
+		{
+			pool.add_task(new FingerprintTask(data, &chunks, chunks.size() * g / groups, chunks.size() * (g + 1) / groups));
+		}
+		pool.wait();
+		pool.stop();
+	}
+	else
+	{
+		FingerprintTask(data, &chunks, 0, chunks.size()).run();
+	}
+
+	// The first chunk seen with each fingerprint. A matching fingerprint is checked against the real bytes, so a collision can't make two different chunks look the same.
+	std::unordered_map<uint64_t, int64_t> firstChunk;
+	firstChunk.reserve(chunks.size());
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		Chunk& c = chunks[i];
+		auto found = firstChunk.find(c.fingerprint);
+		if (found == firstChunk.end())
+		{
+			firstChunk[c.fingerprint] = int64_t(i);
+		}
+		else
+		{
+			const Chunk& first = chunks[size_t(found->second)];
+			if (first.length == c.length && memcmp(data + first.offset, data + c.offset, c.length) == 0)
+			{
+				c.duplicateOf = found->second;
+			}
+		}
+	}
+	return chunks;
+}
+
+bool ContentChunker::chunkFile(const std::string& filename, std::vector<Chunk>& chunks, int threads) const
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+	chunks = chunk(file.data(), file.size(), threads);
+	return true;
+}
+
+DedupStats ContentChunker::summarise(const std::vector<Chunk>& chunks)
+{
+	DedupStats stats = { 0, 0, 0, 0 };
+	for (const Chunk& c : chunks)
+	{
+		stats.chunks++;
+		stats.totalBytes += c.length;
+		if (c.duplicateOf < 0)
+		{
+			stats.uniqueChunks++;
+			stats.uniqueBytes += c.length;
+		}
+	}
+	return stats;
+}
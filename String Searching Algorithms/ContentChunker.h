@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// A piece of the input cut out by ContentChunker.
+struct Chunk
+{
+	uint64_t offset;
+	uint32_t length;
+	uint64_t fingerprint;
+
+	// The index of the first chunk with the same contents, or -1 if this is the first one.
+	int64_t duplicateOf;
+};
+
+// Totals for a list of chunks.
+struct DedupStats
+{
+	size_t chunks;
+	size_t uniqueChunks;
+	uint64_t totalBytes;
+	uint64_t uniqueBytes;
+
+	// How many times smaller the data would be if each chunk was only stored once.
+	double ratio() const { return uniqueBytes == 0 ? 1.0 : double(totalBytes) / double(uniqueBytes); };
+};
+
+// Content-defined chunking, as used by rsync and backup tools for finding repeated data.
+// The rolling hash from the Rabin-Karp search slides over the input, and a chunk ends wherever the hash of the last few bytes has its top bits all zero.
+// Because the cut points depend only on the bytes near them, inserting or deleting something only changes the chunks around it, and the rest of the chunks
+// come out the same as before, so they are found to be duplicates.
+// Each chunk gets a 64-bit fingerprint, and chunks with the same fingerprint are compared byte by byte before being reported as duplicates.
+class ContentChunker
+{
+public:
+	// The sizes are in bytes. Chunks are never shorter than minSize (apart from the last one) or longer than maxSize,
+	// and are on average about minSize + averageSize long. averageSize is rounded down to a power of two.
+	ContentChunker(size_t minSize = 2048, size_t averageSize = 8192, size_t maxSize = 65536, size_t window = 48);
+	~ContentChunker();
+
+	void setSizes(size_t minSize, size_t averageSize, size_t maxSize);
+
+	// Cuts the data into chunks, fingerprints them and marks the duplicates.
+	// With more than one thread, the search for cut points and the fingerprinting are split between them. The chunks come out exactly the same either way.
+	std::vector<Chunk> chunk(const char* data, size_t length, int threads = 1) const;
+
+	// Maps a file into memory and chunks it. Returns false if the file couldn't be opened.
+	bool chunkFile(const std::string& filename, std::vector<Chunk>& chunks, int threads = 1) const;
+
+	// Adds up the chunks and the bytes that are left once duplicates are removed.
+	static DedupStats summarise(const std::vector<Chunk>& chunks);
+
+	// The fingerprint used for each chunk. Reads 8 bytes at a time, so it's much faster than the rolling hash.
+	static uint64_t fingerprint(const char* data, size_t length);
+
+protected:
+	// The task that looks for cut points in part of the data needs the sizes.
+	friend class CutTask;
+
+	// Finds where the chunk starting at 'start' ends.
+	size_t findCut(const char* data, size_t start, size_t length) const;
+
+	// Finds the ends of all of the chunks on several threads. Each thread finds every position in its part of the data where the hash allows a cut,
+	// which only depends on the bytes in the window, and then the chunk sizes are applied to the list in one quick pass.
+	void findCutsParallel(const char* data, size_t length, int threads, std::vector<size_t>& cuts) const;
+
+	size_t minimum;
+	size_t maximum;
+	size_t window;
+
+	// The number of top bits of the hash that have to be zero for a cut.
+	int cutBits;
+};
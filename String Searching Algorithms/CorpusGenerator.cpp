@@ -0,0 +1,158 @@
+#include "CorpusGenerator.h"
+#include <algorithm>
+
+// How many different words the Zipf text uses.
+static const size_t vocabularySize = 50000;
+
+CorpusGenerator::CorpusGenerator(uint64_t seed) : random(seed)
+{
+}
+
+CorpusGenerator::~CorpusGenerator()
+{
+}
+
+const char* CorpusGenerator::kindName(CorpusKind kind)
+{
+	switch (kind)
+	{
+	case CorpusKind::Uniform:
+		return "Uniform";
+	case CorpusKind::Zipf:
+		return "Zipf";
+	case CorpusKind::DNA:
+		return "DNA";
+	default:
+		return "Periodic";
+	}
+}
+
+void CorpusGenerator::buildVocabulary()
+{
+	// Word lengths roughly as they are in English: mostly 2 to 7 letters, with common words tending to be shorter.
+	// The letters are weighted by how often they're used in English, so the text has a realistic mix of characters.
+	static const char letters[] = "eeeeeeeeeeeetttttttttaaaaaaaaooooooooiiiiiiinnnnnnnsssssshhhhhhrrrrrrddddlllluuucccmmmwwffggyyppbbvkjxqz";
+	const size_t letterCount = sizeof(letters) - 1;
+	std::uniform_int_distribution<size_t> pickLetter(0, letterCount - 1);
+
+	vocabulary.resize(vocabularySize);
+	cumulative.resize(vocabularySize);
+	double total = 0;
+	for (size_t rank = 0; rank < vocabularySize; rank++)
+	{
+		size_t longest = std::min<size_t>(14, 3 + rank / 200);
+		std::uniform_int_distribution<size_t> pickLength(1, longest);
+		std::string& word = vocabulary[rank];
+		word.resize(pickLength(random));
+		for (char& c : word)
+		{
+			c = letters[pickLetter(random)];
+		}
+		total += 1.0 / double(rank + 1);
+		cumulative[rank] = total;
+	}
+}
+
+std::string CorpusGenerator::generate(CorpusKind kind, size_t length, int alphabet)
+{
+	std::string text(length, 'a');
+	switch (kind)
+	{
+	case CorpusKind::Uniform:
+	{
+		// Take 8 characters out of each 64-bit random number, since calling the generator for every character would take longer than most of the searches.
+		alphabet = std::max(1, std::min(alphabet, 256));
+		for (size_t i = 0; i < length; )
+		{
+			uint64_t bits = random();
+			for (int j = 0; j < 8 && i < length; j++, i++)
+			{
+				unsigned value = unsigned(bits & 0xFF);
+				bits >>= 8;
+				text[i] = char(alphabet == 256 ? value : 'a' + value % unsigned(alphabet));
+			}
+		}
+		break;
+	}
+	case CorpusKind::DNA:
+	{
+		static const char bases[4] = { 'A', 'C', 'G', 'T' };
+		for (size_t i = 0; i < length; )
+		{
+			uint64_t bits = random();
+			for (int j = 0; j < 32 && i < length; j++, i++)
+			{
+				text[i] = bases[bits & 3];
+				bits >>= 2;
+			}
+		}
+		break;
+	}
+	case CorpusKind::Zipf:
+	{
+		if (vocabulary.empty())
+		{
+			buildVocabulary();
+		}
+		std::uniform_real_distribution<double> pick(0.0, cumulative.back());
+		std::uniform_int_distribution<int> punctuation(0, 99);
+		size_t i = 0;
+		bool sentenceStart = true;
+		while (i < length)
+		{
+			const std::string& word = vocabulary[std::lower_bound(cumulative.begin(), cumulative.end(), pick(random)) - cumulative.begin()];
+			for (size_t j = 0; j < word.length() && i < length; j++, i++)
+			{
+				text[i] = (j == 0 && sentenceStart) ? char(word[j] - 'a' + 'A') : word[j];
+			}
+			sentenceStart = false;
+
+			// End most words with a space, and some with a full stop, comma or new line.
+			int p = punctuation(random);
+			if (p < 6 && i < length)
+			{
+				text[i++] = '.';
+				sentenceStart = true;
+			}
+			else if (p < 12 && i < length)
+			{
+				text[i++] = ',';
+			}
+			if (i < length)
+			{
+				text[i++] = p < 2 ? '\n' : ' ';
+			}
+		}
+		break;
+	}
+	case CorpusKind::Periodic:
+	{
+		size_t period = size_t(std::max(alphabet, 1));
+		for (size_t i = period - 1; i < length; i += period)
+		{
+			text[i] = 'b';
+		}
+		break;
+	}
+	}
+	return text;
+}
+
+std::string CorpusGenerator::pattern(CorpusKind kind, const std::string& text, size_t length)
+{
+	if (kind == CorpusKind::Periodic)
+	{
+		std::string kw(length, 'a');
+		kw[0] = 'b';
+		return kw;
+	}
+	if (length > text.length())
+	{
+		return text;
+	}
+
+	// Copy it from somewhere in the first 64KB, so that the smaller texts made from the start of this one have it too, down to that size.
+	size_t window = std::min(text.length(), size_t(1) << 16);
+	std::uniform_int_distribution<size_t> pick(0, length <= window ? window - length : 0);
+	return text.substr(pick(random), length);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+
+// The kinds of text that CorpusGenerator can make.
+enum class CorpusKind
+{
+	Uniform,	// Every character equally likely, from an alphabet of a chosen size.
+	Zipf,		// English-like words, where the n-th most common word turns up about 1/n as often as the most common one.
+	DNA,		// Random A, C, G and T.
+	Periodic	// Long runs of 'a' with a 'b' every so often, which makes searches that compare from the end of the keyword do the most work.
+};
+
+// Makes test texts of any size, and keywords to search them for, so that the searches can be timed on more than the three texts that come with the program.
+// The same seed always gives the same text, so results from different runs can be compared.
+class CorpusGenerator
+{
+public:
+	// Constructor and destructor.
+	CorpusGenerator(uint64_t seed = 1);
+	~CorpusGenerator();
+
+	// Makes a text of the given length. 'alphabet' is the number of different characters for Uniform text (from 'a' onwards, and all 256 byte values at 256),
+	// and the distance between each 'b' for Periodic text. It's ignored for the other kinds.
+	std::string generate(CorpusKind kind, size_t length, int alphabet = 26);
+
+	// Makes a keyword of the given length for a text made by generate(). For Periodic text it's a 'b' followed by 'a's, which agrees with the text from the end backwards
+	// almost everywhere, so a search that compares from the end of the keyword does nearly a whole keyword of work at each position before it can move on by one.
+	// For the others it's copied from a random place near the start of the text, so it occurs at least once.
+	std::string pattern(CorpusKind kind, const std::string& text, size_t length);
+
+	// The name of a kind, for the results.
+	static const char* kindName(CorpusKind kind);
+
+protected:
+	// Fills in the Zipf vocabulary and the running totals used to pick a word.
+	void buildVocabulary();
+
+	std::mt19937_64 random;
+
+	// The made up words for Zipf text, most common first, and the running total of their weights.
+	std::vector<std::string> vocabulary;
+	std::vector<double> cumulative;
+};
@@ -0,0 +1,159 @@
+#include "CountTable.h"
+#include <cstring>
+#include "CaseFolding.h"
+#include "RollingHash.h"
+
+// Scrambles the bits of a 64-bit number (the finaliser from splitmix64), so that the low bits used for the slot depend on the whole key.
+static inline uint64_t mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+}
+
+CountTable::CountTable(bool ignoreCase)
+{
+	caseless = ignoreCase;
+	clear();
+}
+
+CountTable::~CountTable()
+{
+}
+
+void CountTable::clear()
+{
+	entries.assign(1024, CountEntry{ 0, 0, nullptr, 0, 0 });
+	mask = entries.size() - 1;
+	count = 0;
+}
+
+uint64_t CountTable::hashFromPrefix(uint64_t prefix, uint32_t length)
+{
+	return mix(prefix ^ (uint64_t(length) << 59));
+}
+
+uint64_t CountTable::hashFromPolynomial(uint64_t polynomial, uint32_t length)
+{
+	return mix(polynomial + length);
+}
+
+uint64_t CountTable::hashKey(const char* key, uint32_t length, bool ignoreCase, uint64_t& prefix)
+{
+	prefix = 0;
+	uint64_t polynomial = 0;
+	for (uint32_t i = 0; i < length; i++)
+	{
+		unsigned char c = (unsigned char)key[i];
+		if (ignoreCase)
+		{
+			c = foldCase(c);
+		}
+		if (i < 8)
+		{
+			prefix |= uint64_t(c) << (i * 8);
+		}
+		polynomial = polynomial * RollingHash::multiplier + c;
+	}
+	return length <= 8 ? hashFromPrefix(prefix, length) : hashFromPolynomial(polynomial, length);
+}
+
+bool CountTable::matches(const CountEntry& e, const char* key, uint32_t length, uint64_t hash, uint64_t prefix) const
+{
+	if (e.hash != hash || e.length != length || e.prefix != prefix)
+	{
+		return false;
+	}
+	if (length <= 8)
+	{
+		return true;
+	}
+	if (!caseless)
+	{
+		return memcmp(e.key + 8, key + 8, length - 8) == 0;
+	}
+	for (uint32_t i = 8; i < length; i++)
+	{
+		if (foldCase((unsigned char)e.key[i]) != foldCase((unsigned char)key[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void CountTable::grow()
+{
+	std::vector<CountEntry> old;
+	old.swap(entries);
+	entries.assign(old.size() * 2, CountEntry{ 0, 0, nullptr, 0, 0 });
+	mask = entries.size() - 1;
+	for (const CountEntry& e : old)
+	{
+		if (e.count != 0)
+		{
+			size_t slot = slotFor(e.hash);
+			while (entries[slot].count != 0)
+			{
+				slot = (slot + 1) & mask;
+			}
+			entries[slot] = e;
+		}
+	}
+}
+
+void CountTable::add(const char* key, uint32_t length, uint64_t hash, uint64_t prefix, uint64_t amount)
+{
+	size_t slot = slotFor(hash);
+	while (entries[slot].count != 0)
+	{
+		if (matches(entries[slot], key, length, hash, prefix))
+		{
+			entries[slot].count += amount;
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	entries[slot] = CountEntry{ hash, prefix, key, length, amount };
+	count++;
+
+	// Keep the table at most half full so that probe sequences stay short. Growing moves everything, so the new key is already in its place afterwards.
+	if (count * 2 > entries.size())
+	{
+		grow();
+	}
+}
+
+uint64_t CountTable::find(const char* key, uint32_t length, uint64_t hash, uint64_t prefix) const
+{
+	size_t slot = slotFor(hash);
+	while (entries[slot].count != 0)
+	{
+		if (matches(entries[slot], key, length, hash, prefix))
+		{
+			return entries[slot].count;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return 0;
+}
+
+void CountTable::merge(const CountTable& other)
+{
+	for (const CountEntry& e : other.entries)
+	{
+		if (e.count != 0)
+		{
+			add(e.key, e.length, e.hash, e.prefix, e.count);
+		}
+	}
+}
+
+size_t CountTable::memoryUsage() const
+{
+	return entries.capacity() * sizeof(CountEntry);
+}
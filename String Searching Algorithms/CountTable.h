@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// One slot of a CountTable. The key itself isn't copied: 'key' points into the text that was counted, so the text has to outlive the table.
+// The first 8 bytes of the key are also kept in 'prefix', so keys of up to 8 bytes (such as short words and n-grams) can be compared without looking at the text.
+struct CountEntry
+{
+	uint64_t hash;
+	uint64_t prefix;
+	const char* key;
+	uint32_t length;
+	uint64_t count;
+};
+
+// An open-addressing hash table that counts how many times each string occurs, in the same style as FingerprintSet: one flat array with linear probing.
+// Each thread gets its own table while counting, so there is no locking, and the tables are merged at the end.
+class CountTable
+{
+public:
+	// Constructor and destructor. With ignoreCase, keys that only differ in the case of their letters count as the same key.
+	CountTable(bool ignoreCase = false);
+	~CountTable();
+
+	// Empties the table.
+	void clear();
+
+	// Works out the hash and prefix of a key. Keys up to 8 bytes are hashed from their prefix alone; longer keys use the polynomial hash from RollingHash,
+	// so a caller that is rolling that hash along the text can pass its value in without hashing the key again.
+	static uint64_t hashKey(const char* key, uint32_t length, bool ignoreCase, uint64_t& prefix);
+	static uint64_t hashFromPrefix(uint64_t prefix, uint32_t length);
+	static uint64_t hashFromPolynomial(uint64_t polynomial, uint32_t length);
+
+	// Adds 'amount' to the count for a key, adding the key if it isn't in the table yet.
+	void add(const char* key, uint32_t length, uint64_t hash, uint64_t prefix, uint64_t amount = 1);
+
+	// Returns the count for a key, or 0 if it isn't in the table.
+	uint64_t find(const char* key, uint32_t length, uint64_t hash, uint64_t prefix) const;
+
+	// Adds all of the counts from another table to this one.
+	void merge(const CountTable& other);
+
+	// The slots of the table. Empty slots have a count of 0.
+	const std::vector<CountEntry>& getEntries() const { return entries; };
+
+	// The number of different keys.
+	size_t size() const { return count; };
+
+	bool getIgnoreCase() const { return caseless; };
+
+	// The number of bytes used by the table.
+	size_t memoryUsage() const;
+
+private:
+	// Whether a slot holds the given key.
+	bool matches(const CountEntry& e, const char* key, uint32_t length, uint64_t hash, uint64_t prefix) const;
+
+	// Doubles the size of the table.
+	void grow();
+
+	size_t slotFor(uint64_t hash) const { return size_t(hash & mask); };
+
+	std::vector<CountEntry> entries;
+	size_t mask;
+	size_t count;
+	bool caseless;
+};
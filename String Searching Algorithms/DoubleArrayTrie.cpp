@@ -0,0 +1,475 @@
+#include "DoubleArrayTrie.h"
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <cstring>
+
+// The file starts with this header, followed by the five state arrays, padding up to an 8 byte boundary, the keyword offsets and finally the keyword text.
+// The arrays are written in the machine's own byte order, so a file has to be built on the same kind of machine that loads it.
+struct DoubleArrayHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t stateCount;
+	uint32_t keywordCount;
+	uint32_t longestKeyword;
+	uint64_t textSize;
+};
+
+static const char doubleArrayMagic[8] = { 'D', 'A', 'T', 'R', 'I', 'E', 'A', 'C' };
+static const uint32_t doubleArrayVersion = 1;
+
+// Slots in the check array that aren't being used by a state. The root's check value is never a real state either.
+static const int32_t freeSlot = -1;
+static const int32_t rootCheck = -2;
+
+DoubleArrayTrie::DoubleArrayTrie()
+{
+	base = nullptr;
+	check = nullptr;
+	fail = nullptr;
+	output = nullptr;
+	outputLink = nullptr;
+	keywordOffsets = nullptr;
+	keywordText = nullptr;
+	stateCount = 0;
+	keywordCount = 0;
+	longestKeyword = 0;
+	firstFree = -1;
+	lastFree = -1;
+
+	// An empty dictionary still needs valid offsets so that the getters are safe to call.
+	ownedOffsets.push_back(0);
+	keywordOffsets = ownedOffsets.data();
+}
+
+DoubleArrayTrie::~DoubleArrayTrie()
+{
+}
+
+void DoubleArrayTrie::reserveSlots(int32_t size)
+{
+	int32_t oldSize = int32_t(ownedCheck.size());
+	if (size <= oldSize)
+	{
+		return;
+	}
+
+	// Grow by at least double so that the arrays aren't reallocated for every state.
+	int32_t newSize = std::max(size, oldSize * 2);
+	ownedBase.resize(newSize, 0);
+	ownedCheck.resize(newSize, freeSlot);
+	ownedFail.resize(newSize, 0);
+	ownedOutput.resize(newSize, -1);
+	ownedOutputLink.resize(newSize, -1);
+	nextFree.resize(newSize, -1);
+	prevFree.resize(newSize, -1);
+
+	// Add the new slots onto the end of the free list.
+	for (int32_t i = oldSize; i < newSize; i++)
+	{
+		prevFree[i] = lastFree;
+		nextFree[i] = -1;
+		if (lastFree == -1)
+		{
+			firstFree = i;
+		}
+		else
+		{
+			nextFree[lastFree] = i;
+		}
+		lastFree = i;
+	}
+}
+
+void DoubleArrayTrie::useSlot(int32_t slot)
+{
+	// Unlink the slot from the free list.
+	int32_t previous = prevFree[slot];
+	int32_t next = nextFree[slot];
+	if (previous == -1)
+	{
+		firstFree = next;
+	}
+	else
+	{
+		nextFree[previous] = next;
+	}
+	if (next == -1)
+	{
+		lastFree = previous;
+	}
+	else
+	{
+		prevFree[next] = previous;
+	}
+}
+
+int32_t DoubleArrayTrie::findBase(const std::vector<unsigned char>& chars)
+{
+	// Only free slots are looked at, rather than every position in the array, so the search doesn't slow down as the front of the array fills up.
+	// A free slot is tried as the home of the first character, and the base is accepted if every other character also lands on a free slot.
+	int32_t size = int32_t(ownedCheck.size());
+	for (int32_t slot = firstFree; slot != -1; slot = nextFree[slot])
+	{
+		int32_t b = slot - chars[0];
+		if (b < 1)
+		{
+			continue;
+		}
+
+		bool fits = true;
+		for (size_t i = 1; i < chars.size(); i++)
+		{
+			int32_t t = b + chars[i];
+			if (t < size && ownedCheck[t] != freeSlot)
+			{
+				fits = false;
+				break;
+			}
+		}
+
+		if (fits)
+		{
+			return b;
+		}
+	}
+
+	// Nothing fits in the existing array, so the children go just past the end of it.
+	return std::max(1, size - int32_t(chars[0]));
+}
+
+void DoubleArrayTrie::build(const std::vector<std::string>& keywords)
+{
+	file.close();
+
+	// Store the keyword text in the order it was given, so that the pattern numbers match the caller's list.
+	keywordCount = uint32_t(keywords.size());
+	longestKeyword = 0;
+	ownedOffsets.assign(1, 0);
+	ownedText.clear();
+	for (const std::string& k : keywords)
+	{
+		ownedText += k;
+		ownedOffsets.push_back(ownedText.size());
+		longestKeyword = std::max(longestKeyword, int(k.length()));
+	}
+
+	// The trie is built straight from the sorted keywords. Keywords that share a prefix end up next to each other,
+	// so the children of a state are always a run of keywords that all have the same character at that depth.
+	std::vector<int> order;
+	order.reserve(keywords.size());
+	for (int i = 0; i < int(keywords.size()); i++)
+	{
+		if (!keywords[i].empty())
+		{
+			order.push_back(i);
+		}
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int x, int y) { return keywords[x] < keywords[y]; });
+
+	ownedBase.clear();
+	ownedCheck.clear();
+	ownedFail.clear();
+	ownedOutput.clear();
+	ownedOutputLink.clear();
+	nextFree.clear();
+	prevFree.clear();
+	firstFree = -1;
+	lastFree = -1;
+
+	reserveSlots(512);
+	useSlot(0);
+	ownedCheck[0] = rootCheck;
+
+	// Each entry in the queue is a state and the run of sorted keywords that pass through it. Going through the states in breadth-first order means
+	// that every state closer to the root already has its transitions when a state's fail link is worked out.
+	struct Pending
+	{
+		int32_t state;
+		size_t first;
+		size_t last;
+		size_t depth;
+	};
+	std::deque<Pending> queue;
+	queue.push_back({ 0, 0, order.size(), 0 });
+
+	std::vector<unsigned char> chars;
+	std::vector<size_t> runStarts;
+
+	while (!queue.empty())
+	{
+		Pending p = queue.front();
+		queue.pop_front();
+
+		// Find the distinct characters that follow this state. Keywords that end here come first in the run and have no next character.
+		chars.clear();
+		runStarts.clear();
+		for (size_t i = p.first; i < p.last; i++)
+		{
+			const std::string& k = keywords[order[i]];
+			if (k.length() <= p.depth)
+			{
+				continue;
+			}
+			unsigned char c = (unsigned char)k[p.depth];
+			if (chars.empty() || chars.back() != c)
+			{
+				chars.push_back(c);
+				runStarts.push_back(i);
+			}
+		}
+		runStarts.push_back(p.last);
+
+		if (chars.empty())
+		{
+			continue;
+		}
+
+		int32_t b = findBase(chars);
+		reserveSlots(b + 256);
+		ownedBase[p.state] = b;
+
+		// Claim every child slot before working out fail links, so that a child can fall back to a sibling.
+		for (unsigned char c : chars)
+		{
+			useSlot(b + c);
+			ownedCheck[b + c] = p.state;
+		}
+
+		for (size_t j = 0; j < chars.size(); j++)
+		{
+			unsigned char c = chars[j];
+			int32_t t = b + c;
+
+			// The first keyword in the run is the shortest, so if it ends here this state outputs it. Duplicates are skipped by only setting the output once.
+			const std::string& shortest = keywords[order[runStarts[j]]];
+			if (shortest.length() == p.depth + 1)
+			{
+				ownedOutput[t] = order[runStarts[j]];
+			}
+
+			// The fail link is the longest proper suffix of this state that is also a state, found by following the parent's fail links.
+			int32_t f = 0;
+			if (p.state != 0)
+			{
+				int32_t s = ownedFail[p.state];
+				while (true)
+				{
+					int32_t next = ownedBase[s] + c;
+					if (next < int32_t(ownedCheck.size()) && ownedCheck[next] == s)
+					{
+						f = next;
+						break;
+					}
+					if (s == 0)
+					{
+						break;
+					}
+					s = ownedFail[s];
+				}
+			}
+			ownedFail[t] = f;
+			ownedOutputLink[t] = ownedOutput[f] >= 0 ? f : ownedOutputLink[f];
+
+			queue.push_back({ t, runStarts[j], runStarts[j + 1], p.depth + 1 });
+		}
+	}
+
+	// Trim the arrays to the last slot that can be reached. Every state's transitions need base + 255 to be inside the array, and a leaf with a base of 0 needs slots 0 to 255.
+	int32_t needed = 256;
+	for (int32_t s = 0; s < int32_t(ownedCheck.size()); s++)
+	{
+		if (ownedCheck[s] != freeSlot && ownedBase[s] > 0)
+		{
+			needed = std::max(needed, ownedBase[s] + 256);
+		}
+	}
+	ownedBase.resize(needed);
+	ownedCheck.resize(needed);
+	ownedFail.resize(needed);
+	ownedOutput.resize(needed);
+	ownedOutputLink.resize(needed);
+	ownedBase.shrink_to_fit();
+	ownedCheck.shrink_to_fit();
+	ownedFail.shrink_to_fit();
+	ownedOutput.shrink_to_fit();
+	ownedOutputLink.shrink_to_fit();
+
+	// The free list is only used while building.
+	std::vector<int32_t>().swap(nextFree);
+	std::vector<int32_t>().swap(prevFree);
+
+	stateCount = uint32_t(needed);
+	pointAtOwnedArrays();
+}
+
+void DoubleArrayTrie::pointAtOwnedArrays()
+{
+	base = ownedBase.data();
+	check = ownedCheck.data();
+	fail = ownedFail.data();
+	output = ownedOutput.data();
+	outputLink = ownedOutputLink.data();
+	keywordOffsets = ownedOffsets.data();
+	keywordText = ownedText.data();
+}
+
+bool DoubleArrayTrie::save(const std::string& filename) const
+{
+	std::ofstream ofs(filename, std::ios::binary);
+	if (!ofs)
+	{
+		return false;
+	}
+
+	DoubleArrayHeader header;
+	memcpy(header.magic, doubleArrayMagic, sizeof(header.magic));
+	header.version = doubleArrayVersion;
+	header.stateCount = stateCount;
+	header.keywordCount = keywordCount;
+	header.longestKeyword = uint32_t(longestKeyword);
+	header.textSize = keywordOffsets[keywordCount];
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	ofs.write(reinterpret_cast<const char*>(base), stateCount * sizeof(int32_t));
+	ofs.write(reinterpret_cast<const char*>(check), stateCount * sizeof(int32_t));
+	ofs.write(reinterpret_cast<const char*>(fail), stateCount * sizeof(int32_t));
+	ofs.write(reinterpret_cast<const char*>(output), stateCount * sizeof(int32_t));
+	ofs.write(reinterpret_cast<const char*>(outputLink), stateCount * sizeof(int32_t));
+
+	// Pad so that the 64-bit offsets are aligned when the file is mapped.
+	size_t written = sizeof(header) + 5 * size_t(stateCount) * sizeof(int32_t);
+	const char padding[8] = {};
+	ofs.write(padding, (8 - written % 8) % 8);
+
+	ofs.write(reinterpret_cast<const char*>(keywordOffsets), (size_t(keywordCount) + 1) * sizeof(uint64_t));
+	ofs.write(keywordText, header.textSize);
+
+	return bool(ofs);
+}
+
+bool DoubleArrayTrie::load(const std::string& filename)
+{
+	// Map and check the new file on its own first. If anything is wrong with it, it's unmapped again here and the dictionary that was already loaded is left as it was.
+	MappedFile mapped;
+	if (!mapped.open(filename))
+	{
+		return false;
+	}
+
+	const char* data = mapped.data();
+	size_t size = mapped.size();
+
+	// Check the header before trusting any of the sizes in it.
+	if (size < sizeof(DoubleArrayHeader))
+	{
+		return false;
+	}
+	DoubleArrayHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, doubleArrayMagic, sizeof(header.magic)) != 0 || header.version != doubleArrayVersion || header.stateCount < 256)
+	{
+		return false;
+	}
+
+	size_t arrays = sizeof(header) + 5 * size_t(header.stateCount) * sizeof(int32_t);
+	size_t offsetsStart = arrays + (8 - arrays % 8) % 8;
+	size_t textStart = offsetsStart + (size_t(header.keywordCount) + 1) * sizeof(uint64_t);
+	if (size < textStart || size - textStart < header.textSize)
+	{
+		return false;
+	}
+
+	// The new file is good, so it takes the place of the old one. The old mapping is unmapped when 'mapped' goes out of scope, after the pointers have moved off it.
+	file.swap(mapped);
+
+	// Use the arrays straight out of the mapping. Nothing is copied, so loading takes the same time whatever the size of the dictionary.
+	const int32_t* arrayStart = reinterpret_cast<const int32_t*>(data + sizeof(header));
+	base = arrayStart;
+	check = arrayStart + header.stateCount;
+	fail = arrayStart + 2 * size_t(header.stateCount);
+	output = arrayStart + 3 * size_t(header.stateCount);
+	outputLink = arrayStart + 4 * size_t(header.stateCount);
+	keywordOffsets = reinterpret_cast<const uint64_t*>(data + offsetsStart);
+	keywordText = data + textStart;
+	stateCount = header.stateCount;
+	keywordCount = header.keywordCount;
+	longestKeyword = int(header.longestKeyword);
+
+	// Free anything left over from an earlier build.
+	std::vector<int32_t>().swap(ownedBase);
+	std::vector<int32_t>().swap(ownedCheck);
+	std::vector<int32_t>().swap(ownedFail);
+	std::vector<int32_t>().swap(ownedOutput);
+	std::vector<int32_t>().swap(ownedOutputLink);
+	std::string().swap(ownedText);
+
+	return true;
+}
+
+int32_t DoubleArrayTrie::step(int32_t state, unsigned char c) const
+{
+	// Follow fail links until a state with a transition on this character is found, or we are back at the root.
+	while (true)
+	{
+		int32_t t = base[state] + c;
+		if (check[t] == state)
+		{
+			return t;
+		}
+		if (state == 0)
+		{
+			return 0;
+		}
+		state = fail[state];
+	}
+}
+
+void DoubleArrayTrie::collect(int32_t state, size_t end, std::vector<MultiMatch>& results) const
+{
+	int32_t s = output[state] >= 0 ? state : outputLink[state];
+	while (s != -1)
+	{
+		int k = output[s];
+		results.push_back({ end - getKeywordLength(k), k });
+		s = outputLink[s];
+	}
+}
+
+void DoubleArrayTrie::search(const char* t, size_t length, std::vector<MultiMatch>& results) const
+{
+	if (stateCount == 0)
+	{
+		return;
+	}
+
+	int32_t state = 0;
+	for (size_t i = 0; i < length; i++)
+	{
+		state = step(state, (unsigned char)t[i]);
+
+		// Most states have no output at all, so check that before calling collect().
+		if (output[state] >= 0 || outputLink[state] >= 0)
+		{
+			collect(state, i + 1, results);
+		}
+	}
+}
+
+std::vector<MultiMatch> DoubleArrayTrie::search(const std::string& t) const
+{
+	std::vector<MultiMatch> results;
+	search(t.data(), t.length(), results);
+	return results;
+}
+
+std::string DoubleArrayTrie::getKeyword(int k) const
+{
+	return std::string(keywordText + keywordOffsets[k], getKeywordLength(k));
+}
+
+size_t DoubleArrayTrie::memoryUsage() const
+{
+	return 5 * size_t(stateCount) * sizeof(int32_t) + (size_t(keywordCount) + 1) * sizeof(uint64_t) + size_t(keywordOffsets[keywordCount]);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "SearchTypes.h"
+#include "MappedFile.h"
+
+// A double-array Aho-Corasick automaton for searching for a large dictionary of keywords in a single pass through the text.
+// A pointer-based trie needs a separate node with its own child list for every state, which gets very large and is scattered all over memory.
+// A double-array trie stores the whole automaton in a handful of flat integer arrays instead: the transition from state s on character c goes to state base[s] + c, and it is only valid if check[base[s] + c] == s.
+// Because the arrays are flat, they can be written straight to a file and mapped back into memory at startup without rebuilding anything.
+class DoubleArrayTrie
+{
+public:
+	// Constructor and destructor.
+	DoubleArrayTrie();
+	~DoubleArrayTrie();
+
+	// Builds the automaton from a list of keywords. The index of each keyword in the list is the pattern number reported in the matches.
+	// Empty keywords are ignored, and if a keyword appears more than once only its first index is reported.
+	void build(const std::vector<std::string>& keywords);
+
+	// Writes the automaton to a flat file that can be loaded with load(). Returns false if the file couldn't be written.
+	bool save(const std::string& filename) const;
+
+	// Maps a file written by save() into memory and uses the arrays in place. Returns false if the file is missing or isn't a valid automaton file,
+	// in which case the dictionary that was there before is kept.
+	bool load(const std::string& filename);
+
+	// Finds every occurance of every keyword in the text and adds them to the results in the order they end in the text.
+	void search(const char* t, size_t length, std::vector<MultiMatch>& results) const;
+	std::vector<MultiMatch> search(const std::string& t) const;
+
+	// Follows a single character from a state. Used by search(), and by callers that need to keep the automaton state between blocks of text.
+	int32_t step(int32_t state, unsigned char c) const;
+
+	// Reports every keyword that ends at the given state. 'end' is the position in the text just after the last character that was read.
+	void collect(int32_t state, size_t end, std::vector<MultiMatch>& results) const;
+
+	// Information about the loaded dictionary.
+	int getKeywordCount() const { return int(keywordCount); };
+	int getStateCount() const { return int(stateCount); };
+	std::string getKeyword(int k) const;
+	size_t getKeywordLength(int k) const { return size_t(keywordOffsets[k + 1] - keywordOffsets[k]); };
+	int getLongestKeyword() const { return longestKeyword; };
+
+	// The number of bytes used by the arrays and the keyword text.
+	size_t memoryUsage() const;
+
+protected:
+	// Finds a base value where every character in 'chars' lands on an unused slot.
+	int32_t findBase(const std::vector<unsigned char>& chars);
+
+	// Makes sure the arrays are large enough to hold the given slot, adding the new slots to the free list.
+	void reserveSlots(int32_t size);
+
+	// Marks a slot as used and removes it from the free list.
+	void useSlot(int32_t slot);
+
+	// Points the array pointers at the vectors after building.
+	void pointAtOwnedArrays();
+
+	// Arrays that make up the automaton. They either point into the owned vectors below, or into the mapped file.
+	// base and check hold the transitions, fail holds the state to fall back to when there is no transition, output holds the keyword that ends at a state (or -1),
+	// and outputLink points to the next state down the fail chain that also has an output, so that keywords that are suffixes of other keywords are found too.
+	const int32_t* base;
+	const int32_t* check;
+	const int32_t* fail;
+	const int32_t* output;
+	const int32_t* outputLink;
+	const uint64_t* keywordOffsets;
+	const char* keywordText;
+
+	uint32_t stateCount;
+	uint32_t keywordCount;
+	int longestKeyword;
+
+	// Storage used when the automaton was built in this process rather than loaded from a file.
+	std::vector<int32_t> ownedBase;
+	std::vector<int32_t> ownedCheck;
+	std::vector<int32_t> ownedFail;
+	std::vector<int32_t> ownedOutput;
+	std::vector<int32_t> ownedOutputLink;
+	std::vector<uint64_t> ownedOffsets;
+	std::string ownedText;
+
+	// Doubly linked list of unused slots, only needed while building.
+	std::vector<int32_t> nextFree;
+	std::vector<int32_t> prevFree;
+	int32_t firstFree;
+	int32_t lastFree;
+
+	// The file the arrays point into after load().
+	MappedFile file;
+};
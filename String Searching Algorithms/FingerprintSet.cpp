@@ -0,0 +1,86 @@
+#include "FingerprintSet.h"
+
+FingerprintSet::FingerprintSet()
+{
+	reset(0);
+}
+
+FingerprintSet::~FingerprintSet()
+{
+}
+
+void FingerprintSet::reset(size_t expected)
+{
+	// Round up to a power of two so that a mask can be used instead of a modulo.
+	size_t capacity = 16;
+	while (capacity < expected * 2)
+	{
+		capacity *= 2;
+	}
+
+	fingerprints.assign(capacity, 0);
+	patterns.assign(capacity, -1);
+	mask = capacity - 1;
+	count = 0;
+	sameFingerprint.clear();
+}
+
+void FingerprintSet::insert(uint64_t fingerprint, int pattern)
+{
+	if (pattern >= int(sameFingerprint.size()))
+	{
+		sameFingerprint.resize(pattern + 1, -1);
+	}
+
+	// If the table is getting full, rebuild it at double the size.
+	if ((count + 1) * 2 > mask + 1)
+	{
+		std::vector<uint64_t> oldFingerprints;
+		std::vector<int> oldPatterns;
+		oldFingerprints.swap(fingerprints);
+		oldPatterns.swap(patterns);
+		size_t capacity = (mask + 1) * 2;
+		fingerprints.assign(capacity, 0);
+		patterns.assign(capacity, -1);
+		mask = capacity - 1;
+		for (size_t i = 0; i < oldPatterns.size(); i++)
+		{
+			if (oldPatterns[i] != -1)
+			{
+				size_t slot = slotFor(oldFingerprints[i]);
+				while (patterns[slot] != -1)
+				{
+					slot = (slot + 1) & mask;
+				}
+				fingerprints[slot] = oldFingerprints[i];
+				patterns[slot] = oldPatterns[i];
+			}
+		}
+	}
+
+	size_t slot = slotFor(fingerprint);
+	while (patterns[slot] != -1)
+	{
+		if (fingerprints[slot] == fingerprint)
+		{
+			// Already in the table, so add the pattern to the end of the chain so that they stay in order.
+			int p = patterns[slot];
+			while (sameFingerprint[p] != -1)
+			{
+				p = sameFingerprint[p];
+			}
+			sameFingerprint[p] = pattern;
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	fingerprints[slot] = fingerprint;
+	patterns[slot] = pattern;
+	count++;
+}
+
+size_t FingerprintSet::memoryUsage() const
+{
+	return fingerprints.size() * sizeof(uint64_t) + patterns.size() * sizeof(int) + sameFingerprint.size() * sizeof(int);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// An open-addressing hash set of 64-bit fingerprints, each linked to one or more pattern numbers.
+// All the fingerprints live in one flat array and a collision just moves on to the next slot (linear probing), so a lookup is usually a single cache line
+// rather than following pointers through the buckets of a std::unordered_map.
+class FingerprintSet
+{
+public:
+	// Constructor and destructor.
+	FingerprintSet();
+	~FingerprintSet();
+
+	// Empties the set and sizes the table for the given number of fingerprints. The table is kept at most half full so that probe sequences stay short.
+	void reset(size_t expected);
+
+	// Adds a fingerprint for a pattern. Several patterns can share a fingerprint, either because they are the same text or because their hashes collide.
+	void insert(uint64_t fingerprint, int pattern);
+
+	// Returns the first pattern with this fingerprint, or -1 if there isn't one.
+	int find(uint64_t fingerprint) const
+	{
+		size_t slot = slotFor(fingerprint);
+		while (patterns[slot] != -1)
+		{
+			if (fingerprints[slot] == fingerprint)
+			{
+				return patterns[slot];
+			}
+			slot = (slot + 1) & mask;
+		}
+		return -1;
+	}
+
+	// Returns the next pattern that shares a fingerprint with the given one, or -1 at the end of the chain.
+	int next(int pattern) const { return sameFingerprint[pattern]; };
+
+	size_t size() const { return count; };
+
+	// The number of bytes used by the table.
+	size_t memoryUsage() const;
+
+private:
+	// Mixes the high bits into the low bits before masking, since the low bits of a polynomial hash depend only on the last few characters.
+	size_t slotFor(uint64_t fingerprint) const
+	{
+		return size_t((fingerprint ^ (fingerprint >> 29) ^ (fingerprint >> 47)) & mask);
+	}
+
+	// The table itself. An empty slot has a pattern of -1.
+	std::vector<uint64_t> fingerprints;
+	std::vector<int> patterns;
+	size_t mask;
+	size_t count;
+
+	// For each pattern number, the next pattern with the same fingerprint.
+	std::vector<int> sameFingerprint;
+};
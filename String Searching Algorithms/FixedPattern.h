@@ -0,0 +1,116 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// A Boyer-Moore (Horspool) skip table that can be filled in at compile time.
+struct FixedSkipTable
+{
+	size_t skip[256];
+};
+
+// Compares the characters of a FixedPattern with the text one at a time. Each character is its own template, so the compiler ends up with a
+// straight line of comparisons against constants for the exact length of the keyword, with no loop and no keyword to load from memory.
+template <size_t Index, char... Rest>
+struct FixedCompare;
+
+template <size_t Index>
+struct FixedCompare<Index>
+{
+	static bool matches(const char*) { return true; };
+};
+
+template <size_t Index, char First, char... Rest>
+struct FixedCompare<Index, First, Rest...>
+{
+	static bool matches(const char* t) { return t[Index] == First && FixedCompare<Index + 1, Rest...>::matches(t); };
+};
+
+// Builds the same table CompiledPattern::compile() does, but at compile time: the whole keyword length for a character that isn't in the keyword, otherwise the distance from
+// the character's last place in the keyword to the end. The last character is left out so that the skip is never 0.
+template <char... Chars>
+constexpr FixedSkipTable buildFixedSkipTable()
+{
+	const char keyword[] = { Chars... };
+	const size_t keyLength = sizeof...(Chars);
+	FixedSkipTable built = {};
+	for (int i = 0; i < 256; i++)
+	{
+		built.skip[i] = keyLength;
+	}
+	for (size_t i = 0; i + 1 < keyLength; i++)
+	{
+		built.skip[(unsigned char)keyword[i]] = (keyLength - 1) - i;
+	}
+	return built;
+}
+
+// A keyword that is known when the program is built, such as a fixed marker in a log file, given as its characters:
+//
+//     typedef FixedPattern<'E', 'R', 'R', 'O', 'R'> ErrorMarker;
+//     size_t first = ErrorMarker::find(text, length);
+//
+// It searches the same way as CompiledPattern, but the skip table is worked out by the compiler rather than when the program runs, and checking for a match
+// is unrolled for the keyword's exact length. There's nothing to set up at run time, so everything is static and there are no objects to make.
+template <char... Chars>
+class FixedPattern
+{
+public:
+	static_assert(sizeof...(Chars) > 0, "A FixedPattern needs at least one character.");
+
+	// Returned by find() when there are no more matches.
+	static const size_t npos = size_t(-1);
+
+	static constexpr size_t keyLength = sizeof...(Chars);
+
+	// Returns the position of the first match at or after 'from', or npos if there isn't one.
+	static size_t find(const char* t, size_t length, size_t from = 0)
+	{
+		if (length < keyLength)
+		{
+			return npos;
+		}
+
+		const unsigned char lastChar = (unsigned char)keyword[keyLength - 1];
+		for (size_t i = from; i <= length - keyLength; )
+		{
+			unsigned char c = (unsigned char)t[i + keyLength - 1];
+
+			// Only compare the rest of the keyword if the last character matches.
+			if (c == lastChar && matchesAt(t + i))
+			{
+				return i;
+			}
+			i += table.skip[c];
+		}
+		return npos;
+	};
+
+	// Adds the position of every match in the text to the results.
+	static void findAll(const char* t, size_t length, std::vector<size_t>& results)
+	{
+		for (size_t i = find(t, length, 0); i != npos; i = find(t, length, i + 1))
+		{
+			results.push_back(i);
+		}
+	};
+
+	// Checks whether the keyword is at a position, without using the skip table.
+	static bool matchesAt(const char* t) { return FixedCompare<0, Chars...>::matches(t); };
+
+	static std::string getKeyword() { return std::string(keyword, keyLength); };
+
+private:
+	static constexpr char keyword[keyLength] = { Chars... };
+	static constexpr FixedSkipTable table = buildFixedSkipTable<Chars...>();
+};
+
+// The constants have to be defined outside the class as well, since find() uses them as arrays.
+template <char... Chars>
+constexpr size_t FixedPattern<Chars...>::keyLength;
+
+template <char... Chars>
+constexpr char FixedPattern<Chars...>::keyword[];
+
+template <char... Chars>
+constexpr FixedSkipTable FixedPattern<Chars...>::table;
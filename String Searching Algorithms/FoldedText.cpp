@@ -0,0 +1,34 @@
+#include "FoldedText.h"
+#include "CaseFolding.h"
+
+FoldedText::FoldedText()
+{
+}
+
+FoldedText::~FoldedText()
+{
+}
+
+void FoldedText::build(const char* t, size_t length)
+{
+	folded.resize(length);
+	for (size_t i = 0; i < length; i++)
+	{
+		folded[i] = char(foldCase((unsigned char)t[i]));
+	}
+}
+
+std::vector<size_t> FoldedText::search(const std::string& kw) const
+{
+	// The keyword is folded when it's compiled, then it is searched for case-sensitively in the folded text.
+	std::string foldedKeyword = kw;
+	for (char& c : foldedKeyword)
+	{
+		c = char(foldCase((unsigned char)c));
+	}
+
+	CompiledPattern pattern(foldedKeyword);
+	std::vector<size_t> results;
+	pattern.findAll(folded.data(), folded.size(), results);
+	return results;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "CompiledPattern.h"
+
+// A lower case "shadow" copy of a text, for texts that are searched case-insensitively many times.
+// Folding the whole text once means each search afterwards is a normal case-sensitive search, at the cost of keeping a second copy of the text in memory.
+// ASCII folding keeps every character the same size, so positions found in the shadow copy are the same as in the original text.
+class FoldedText
+{
+public:
+	// Constructor and destructor.
+	FoldedText();
+	~FoldedText();
+
+	// Makes the folded copy of a text.
+	void build(const char* t, size_t length);
+	void build(const std::string& t) { build(t.data(), t.length()); };
+
+	// Finds every case-insensitive match of a keyword.
+	std::vector<size_t> search(const std::string& kw) const;
+
+	// The folded text.
+	const char* data() const { return folded.data(); };
+	size_t size() const { return folded.size(); };
+
+	// The extra memory used by the shadow copy, in bytes.
+	size_t memoryUsage() const { return folded.capacity(); };
+
+protected:
+	std::string folded;
+};
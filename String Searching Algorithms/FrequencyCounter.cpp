@@ -0,0 +1,365 @@
+#include "FrequencyCounter.h"
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include "CaseFolding.h"
+#include "CompiledPattern.h"
+#include "RollingHash.h"
+#include "WorkerPool.h"
+#include "WordBreaks.h"
+
+// A task that counts the words in one part of the text.
+class WordCountTask :
+	public Task
+{
+public:
+	WordCountTask(const char* t, size_t l, size_t s, size_t e, CountTable* c)
+	{
+		text = t;
+		length = l;
+		start = s;
+		end = e;
+		counts = c;
+	};
+
+	void run()
+	{
+		FrequencyCounter::countWordsIn(text, length, start, end, *counts);
+	};
+
+private:
+	const char* text;
+	size_t length;
+	size_t start;
+	size_t end;
+	CountTable* counts;
+};
+
+// A task that counts the n-grams in one part of the text.
+class NGramCountTask :
+	public Task
+{
+public:
+	NGramCountTask(const char* t, size_t l, int g, size_t s, size_t e, CountTable* c)
+	{
+		text = t;
+		length = l;
+		n = g;
+		start = s;
+		end = e;
+		counts = c;
+	};
+
+	void run()
+	{
+		FrequencyCounter::countNGramsIn(text, length, n, start, end, *counts);
+	};
+
+private:
+	const char* text;
+	size_t length;
+	int n;
+	size_t start;
+	size_t end;
+	CountTable* counts;
+};
+
+FrequencyCounter::FrequencyCounter()
+{
+	total = 0;
+	text = nullptr;
+	textLength = 0;
+	gramLength = 0;
+	words = true;
+}
+
+FrequencyCounter::~FrequencyCounter()
+{
+}
+
+void FrequencyCounter::countWordsIn(const char* t, size_t length, size_t start, size_t end, CountTable& counts)
+{
+	const bool caseless = counts.getIgnoreCase();
+	size_t i = start;
+
+	// A word that started in the previous part belongs to that part.
+	if (i > 0 && isWordCharacter((unsigned char)t[i - 1]))
+	{
+		while (i < length && isWordCharacter((unsigned char)t[i]))
+		{
+			i++;
+		}
+	}
+
+	while (i < end)
+	{
+		while (i < end && !isWordCharacter((unsigned char)t[i]))
+		{
+			i++;
+		}
+		if (i >= end)
+		{
+			break;
+		}
+
+		// Work out the hash while reading the word, so each character is only looked at once.
+		size_t wordStart = i;
+		uint64_t prefix = 0;
+		uint64_t polynomial = 0;
+		while (i < length && isWordCharacter((unsigned char)t[i]))
+		{
+			unsigned char c = (unsigned char)t[i];
+			if (caseless)
+			{
+				c = foldCase(c);
+			}
+			if (i - wordStart < 8)
+			{
+				prefix |= uint64_t(c) << ((i - wordStart) * 8);
+			}
+			polynomial = polynomial * RollingHash::multiplier + c;
+			i++;
+		}
+
+		uint32_t wordLength = uint32_t(i - wordStart);
+		uint64_t hash = wordLength <= 8 ? CountTable::hashFromPrefix(prefix, wordLength) : CountTable::hashFromPolynomial(polynomial, wordLength);
+		counts.add(t + wordStart, wordLength, hash, prefix);
+	}
+}
+
+void FrequencyCounter::countNGramsIn(const char* t, size_t length, int n, size_t start, size_t end, CountTable& counts)
+{
+	if (length < size_t(n))
+	{
+		return;
+	}
+	end = std::min(end, length - n + 1);
+	if (start >= end)
+	{
+		return;
+	}
+
+	if (n <= 8)
+	{
+		// The whole n-gram fits in the prefix, which slides along a character at a time.
+		uint64_t prefix = 0;
+		for (int j = 0; j < n; j++)
+		{
+			prefix |= uint64_t((unsigned char)t[start + j]) << (j * 8);
+		}
+		const int topShift = (n - 1) * 8;
+		for (size_t p = start; ; )
+		{
+			counts.add(t + p, uint32_t(n), CountTable::hashFromPrefix(prefix, uint32_t(n)), prefix);
+			if (++p >= end)
+			{
+				break;
+			}
+			prefix = n == 8 ? prefix >> 8 : (prefix >> 8) & ((uint64_t(1) << topShift) - 1);
+			prefix |= uint64_t((unsigned char)t[p + n - 1]) << topShift;
+		}
+	}
+	else
+	{
+		// Longer n-grams use the rolling hash, and the prefix is just the first 8 bytes.
+		RollingHash hash = RollingHash(size_t(n));
+		hash.init(t + start);
+		for (size_t p = start; ; )
+		{
+			uint64_t prefix;
+			memcpy(&prefix, t + p, sizeof(prefix));
+			counts.add(t + p, uint32_t(n), CountTable::hashFromPolynomial(hash.value(), uint32_t(n)), prefix);
+			if (++p >= end)
+			{
+				break;
+			}
+			hash.roll((unsigned char)t[p - 1], (unsigned char)t[p + n - 1]);
+		}
+	}
+}
+
+void FrequencyCounter::mergeTables(std::vector<CountTable>& tables)
+{
+	// Start from the biggest table so that the fewest keys have to be added again.
+	size_t biggest = 0;
+	for (size_t i = 1; i < tables.size(); i++)
+	{
+		if (tables[i].size() > tables[biggest].size())
+		{
+			biggest = i;
+		}
+	}
+	std::swap(table, tables[biggest]);
+	for (size_t i = 0; i < tables.size(); i++)
+	{
+		if (i != biggest)
+		{
+			table.merge(tables[i]);
+		}
+	}
+
+	total = 0;
+	for (const CountEntry& e : table.getEntries())
+	{
+		total += e.count;
+	}
+}
+
+void FrequencyCounter::countWords(const char* t, size_t length, int threads, bool ignoreCase)
+{
+	text = t;
+	textLength = length;
+	words = true;
+	gramLength = 0;
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+
+	std::vector<CountTable> tables(threads, CountTable(ignoreCase));
+	if (threads == 1)
+	{
+		countWordsIn(t, length, 0, length, tables[0]);
+	}
+	else
+	{
+		WorkerPool pool;
+		pool.start(threads);
+		for (int i = 0; i < threads; i++)
+		{
+			pool.add_task(new WordCountTask(t, length, length * i / threads, length * (i + 1) / threads, &tables[i]));
+		}
+		pool.wait();
+		pool.stop();
+	}
+	mergeTables(tables);
+}
+
+void FrequencyCounter::countNGrams(const char* t, size_t length, int n, int threads)
+{
+	text = t;
+	textLength = length;
+	words = false;
+	gramLength = n < 1 ? 1 : n;
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+
+	std::vector<CountTable> tables(threads, CountTable(false));
+	if (threads == 1)
+	{
+		countNGramsIn(t, length, gramLength, 0, length, tables[0]);
+	}
+	else
+	{
+		WorkerPool pool;
+		pool.start(threads);
+		for (int i = 0; i < threads; i++)
+		{
+			pool.add_task(new NGramCountTask(t, length, gramLength, length * i / threads, length * (i + 1) / threads, &tables[i]));
+		}
+		pool.wait();
+		pool.stop();
+	}
+	mergeTables(tables);
+}
+
+std::vector<FrequencyEntry> FrequencyCounter::topK(size_t k) const
+{
+	const std::vector<CountEntry>& entries = table.getEntries();
+	const bool caseless = table.getIgnoreCase();
+
+	// Whether entry a is less common than entry b. Between equal counts, the one that comes later alphabetically counts as less common.
+	auto lessCommon = [&](size_t a, size_t b)
+	{
+		const CountEntry& x = entries[a];
+		const CountEntry& y = entries[b];
+		if (x.count != y.count)
+		{
+			return x.count < y.count;
+		}
+		uint32_t shorter = std::min(x.length, y.length);
+		for (uint32_t i = 0; i < shorter; i++)
+		{
+			unsigned char cx = (unsigned char)x.key[i];
+			unsigned char cy = (unsigned char)y.key[i];
+			if (caseless)
+			{
+				cx = foldCase(cx);
+				cy = foldCase(cy);
+			}
+			if (cx != cy)
+			{
+				return cx > cy;
+			}
+		}
+		return x.length > y.length;
+	};
+
+	// A heap of the k most common so far, with the least common of them on top so it can be swapped out when something more common comes along.
+	auto moreCommon = [&](size_t a, size_t b) { return lessCommon(b, a); };
+	std::priority_queue<size_t, std::vector<size_t>, decltype(moreCommon)> heap(moreCommon);
+	if (k > 0)
+	{
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			if (entries[i].count == 0)
+			{
+				continue;
+			}
+			if (heap.size() < k)
+			{
+				heap.push(i);
+			}
+			else if (lessCommon(heap.top(), i))
+			{
+				heap.pop();
+				heap.push(i);
+			}
+		}
+	}
+
+	// The heap gives them least common first, so fill the results in from the back.
+	std::vector<FrequencyEntry> results(heap.size());
+	for (size_t r = results.size(); r > 0; r--)
+	{
+		const CountEntry& e = entries[heap.top()];
+		heap.pop();
+		std::string key(e.key, e.length);
+		if (caseless)
+		{
+			for (char& c : key)
+			{
+				c = char(foldCase((unsigned char)c));
+			}
+		}
+		results[r - 1] = { key, e.count };
+	}
+	return results;
+}
+
+uint64_t FrequencyCounter::count(const std::string& key) const
+{
+	if (key.empty())
+	{
+		return 0;
+	}
+
+	// An n-gram of a different length wasn't counted, so count it with the Boyer-Moore search, including overlapping matches.
+	if (!words && key.length() != size_t(gramLength))
+	{
+		CompiledPattern pattern;
+		pattern.compile(key);
+		uint64_t found = 0;
+		for (size_t i = pattern.find(text, textLength); i != CompiledPattern::npos; i = pattern.find(text, textLength, i + 1))
+		{
+			found++;
+		}
+		return found;
+	}
+
+	uint64_t prefix;
+	uint64_t hash = CountTable::hashKey(key.data(), uint32_t(key.length()), table.getIgnoreCase(), prefix);
+	return table.find(key.data(), uint32_t(key.length()), hash, prefix);
+}
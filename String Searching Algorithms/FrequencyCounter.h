@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "CountTable.h"
+
+// A word or n-gram and the number of times it occurs.
+struct FrequencyEntry
+{
+	std::string text;
+	uint64_t count;
+};
+
+// Counts every word, or every n characters, in a text, and finds the most common ones.
+// The text is split into one part per thread and each thread counts its part into its own CountTable, so the threads never wait for each other.
+// The tables are then merged into one. Words are runs of letters and digits (and any bytes above 127, so UTF-8 letters stay inside their words).
+//
+// The table points into the counted text rather than copying the words, so the text has to stay the same and stay in memory while the counter is used.
+class FrequencyCounter
+{
+public:
+	// Constructor and destructor.
+	FrequencyCounter();
+	~FrequencyCounter();
+
+	// Counts the words in a text. With ignoreCase, "Shrek" and "shrek" count as the same word.
+	void countWords(const char* t, size_t length, int threads = 1, bool ignoreCase = false);
+
+	// Counts every run of n characters in a text, including overlapping ones.
+	void countNGrams(const char* t, size_t length, int n, int threads = 1);
+
+	// Returns the k most common words or n-grams, most common first. Ties are put in alphabetical order.
+	std::vector<FrequencyEntry> topK(size_t k) const;
+
+	// Returns how many times a word or n-gram occurs. An n-gram of a different length from the one that was counted is found by searching the text instead.
+	uint64_t count(const std::string& key) const;
+
+	// The number of different words or n-grams, and the total number counted.
+	size_t getDistinct() const { return table.size(); };
+	uint64_t getTotal() const { return total; };
+
+	// The number of bytes used by the table.
+	size_t memoryUsage() const { return table.memoryUsage(); };
+
+protected:
+	// The tasks that count a part of the text on the worker threads.
+	friend class WordCountTask;
+	friend class NGramCountTask;
+
+	// Counts the words that start between 'start' and 'end'. A word that carries on past 'end' is counted here, and skipped by the part that comes next.
+	static void countWordsIn(const char* t, size_t length, size_t start, size_t end, CountTable& counts);
+
+	// Counts the n-grams that start between 'start' and 'end'.
+	static void countNGramsIn(const char* t, size_t length, int n, size_t start, size_t end, CountTable& counts);
+
+	// Merges the tables from each thread into 'table' and adds up the total.
+	void mergeTables(std::vector<CountTable>& tables);
+
+	CountTable table;
+	uint64_t total;
+
+	// What was counted last, needed for looking up keys afterwards.
+	const char* text;
+	size_t textLength;
+	int gramLength;
+	bool words;
+};
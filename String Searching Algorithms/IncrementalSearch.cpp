@@ -0,0 +1,372 @@
+#include "IncrementalSearch.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+static const char stateMagic[4] = { 'S', 'S', 'I', 'S' };
+static const uint32_t stateVersion = 1;
+
+// How much of a file is read at a time by scanFile().
+static const size_t readSize = 1 << 20;
+
+IncrementalSearch::IncrementalSearch()
+{
+	mode = IncrementalMode::BoyerMoore;
+	offset = 0;
+	windowStart = 0;
+	keyHash = 0;
+	state = 0;
+}
+
+IncrementalSearch::~IncrementalSearch()
+{
+}
+
+void IncrementalSearch::start(const std::string& kw, IncrementalMode m)
+{
+	mode = m;
+	keywords.assign(1, kw);
+	offset = 0;
+	tail.clear();
+	window.clear();
+	windowStart = 0;
+	state = 0;
+	prepare();
+}
+
+void IncrementalSearch::start(const std::vector<std::string>& kws)
+{
+	mode = IncrementalMode::AhoCorasick;
+	keywords = kws;
+	offset = 0;
+	tail.clear();
+	window.clear();
+	windowStart = 0;
+	state = 0;
+	prepare();
+}
+
+void IncrementalSearch::prepare()
+{
+	if (mode == IncrementalMode::AhoCorasick)
+	{
+		automaton.build(keywords);
+		return;
+	}
+
+	const std::string& kw = keywords.empty() ? std::string() : keywords[0];
+	if (mode == IncrementalMode::BoyerMoore)
+	{
+		pattern.compile(kw);
+	}
+	else
+	{
+		rollingHash.setWindow(kw.length());
+		keyHash = RollingHash::hashOf(kw.data(), kw.length());
+
+		// Put the hash back to where it was when the state was saved, with the window's oldest byte first.
+		if (!kw.empty() && window.length() == kw.length())
+		{
+			std::string ordered = window.substr(windowStart) + window.substr(0, windowStart);
+			rollingHash.init(ordered.data());
+		}
+	}
+}
+
+void IncrementalSearch::feed(const char* data, size_t length, std::vector<MultiMatch>& results)
+{
+	if (keywords.empty())
+	{
+		offset += length;
+		return;
+	}
+
+	switch (mode)
+	{
+	case IncrementalMode::BoyerMoore:
+		feedBoyerMoore(data, length, results);
+		break;
+	case IncrementalMode::RabinKarp:
+		feedRabinKarp(data, length, results);
+		break;
+	case IncrementalMode::AhoCorasick:
+		feedAhoCorasick(data, length, results);
+		break;
+	}
+	offset += length;
+}
+
+void IncrementalSearch::feedBoyerMoore(const char* data, size_t length, std::vector<MultiMatch>& results)
+{
+	size_t keyLength = pattern.length();
+	if (keyLength == 0)
+	{
+		return;
+	}
+
+	// First search the join between the old text and the new text: the saved tail followed by the start of the new text.
+	// Only matches that start in the tail are taken from here, since the rest of the new text is searched below without copying it.
+	if (!tail.empty())
+	{
+		junction = tail;
+		junction.append(data, std::min(length, keyLength - 1));
+		for (size_t i = pattern.find(junction.data(), junction.length()); i != CompiledPattern::npos && i < tail.length(); i = pattern.find(junction.data(), junction.length(), i + 1))
+		{
+			results.push_back({ size_t(offset - tail.length() + i), 0 });
+		}
+	}
+
+	for (size_t i = pattern.find(data, length); i != CompiledPattern::npos; i = pattern.find(data, length, i + 1))
+	{
+		results.push_back({ size_t(offset + i), 0 });
+	}
+
+	// Keep the last keyLength - 1 bytes. A whole match can't fit in them, so nothing in the tail is ever reported twice.
+	size_t keep = keyLength - 1;
+	if (length >= keep)
+	{
+		tail.assign(data + length - keep, keep);
+	}
+	else
+	{
+		tail.append(data, length);
+		if (tail.length() > keep)
+		{
+			tail.erase(0, tail.length() - keep);
+		}
+	}
+}
+
+void IncrementalSearch::feedRabinKarp(const char* data, size_t length, std::vector<MultiMatch>& results)
+{
+	const std::string& kw = keywords[0];
+	size_t keyLength = kw.length();
+	if (keyLength == 0)
+	{
+		return;
+	}
+
+	for (size_t j = 0; j < length; j++)
+	{
+		unsigned char c = (unsigned char)data[j];
+
+		// Fill the window up to the keyword's length before there's anything to compare.
+		if (window.length() < keyLength)
+		{
+			window += char(c);
+			if (window.length() < keyLength)
+			{
+				continue;
+			}
+			rollingHash.init(window.data());
+			windowStart = 0;
+		}
+		else
+		{
+			// Replace the oldest byte in the ring with the new one and roll the hash forward.
+			rollingHash.roll((unsigned char)window[windowStart], c);
+			window[windowStart] = char(c);
+			windowStart = (windowStart + 1) % keyLength;
+		}
+
+		// The window ends at the byte just added, so a match starts keyLength - 1 bytes before it.
+		if (rollingHash.value() == keyHash)
+		{
+			size_t firstPart = keyLength - windowStart;
+			if (memcmp(window.data() + windowStart, kw.data(), firstPart) == 0 && memcmp(window.data(), kw.data() + firstPart, windowStart) == 0)
+			{
+				results.push_back({ size_t(offset + j + 1 - keyLength), 0 });
+			}
+		}
+	}
+}
+
+void IncrementalSearch::feedAhoCorasick(const char* data, size_t length, std::vector<MultiMatch>& results)
+{
+	if (automaton.getStateCount() == 0)
+	{
+		return;
+	}
+
+	// The automaton state already holds everything about a match in progress, so it just carries on from where it stopped.
+	for (size_t i = 0; i < length; i++)
+	{
+		state = automaton.step(state, (unsigned char)data[i]);
+		automaton.collect(state, size_t(offset + i + 1), results);
+	}
+}
+
+size_t IncrementalSearch::scanFile(const std::string& filename, std::vector<MultiMatch>& results)
+{
+	std::ifstream ifs(filename, std::ios::binary);
+	if (!ifs)
+	{
+		return 0;
+	}
+
+	ifs.seekg(0, std::ios::end);
+	uint64_t size = uint64_t(ifs.tellg());
+
+	// A file that has got shorter has been truncated or replaced, so the old state doesn't apply to it any more.
+	if (size < offset)
+	{
+		if (mode == IncrementalMode::AhoCorasick)
+		{
+			start(std::vector<std::string>(keywords));
+		}
+		else
+		{
+			start(std::string(keywords.empty() ? "" : keywords[0]), mode);
+		}
+	}
+
+	ifs.seekg(std::streamoff(offset));
+	std::vector<char> buffer(readSize);
+	size_t scanned = 0;
+	while (ifs)
+	{
+		ifs.read(buffer.data(), buffer.size());
+		size_t got = size_t(ifs.gcount());
+		if (got == 0)
+		{
+			break;
+		}
+		feed(buffer.data(), got, results);
+		scanned += got;
+	}
+	return scanned;
+}
+
+// Helpers for writing and reading the state file.
+static void writeString(std::ofstream& ofs, const std::string& s)
+{
+	uint32_t length = uint32_t(s.length());
+	ofs.write(reinterpret_cast<const char*>(&length), sizeof(length));
+	ofs.write(s.data(), length);
+}
+
+// A string can't be longer than the file it's in, so a corrupt length is caught before any memory is allocated for it.
+static bool readString(std::ifstream& ifs, std::string& s, uint64_t fileSize)
+{
+	uint32_t length;
+	if (!ifs.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > fileSize)
+	{
+		return false;
+	}
+	s.resize(length);
+	return length == 0 || bool(ifs.read(&s[0], length));
+}
+
+bool IncrementalSearch::saveState(const std::string& filename) const
+{
+	std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+	if (!ofs)
+	{
+		return false;
+	}
+
+	// The ring is saved oldest byte first, so that loading it doesn't need to know where it started.
+	std::string orderedWindow = window.substr(windowStart) + window.substr(0, windowStart);
+	uint8_t savedMode = uint8_t(mode);
+	uint32_t keywordCount = uint32_t(keywords.size());
+	uint64_t hash = rollingHash.value();
+
+	ofs.write(stateMagic, sizeof(stateMagic));
+	ofs.write(reinterpret_cast<const char*>(&stateVersion), sizeof(stateVersion));
+	ofs.write(reinterpret_cast<const char*>(&savedMode), sizeof(savedMode));
+	ofs.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+	ofs.write(reinterpret_cast<const char*>(&keywordCount), sizeof(keywordCount));
+	for (const std::string& k : keywords)
+	{
+		writeString(ofs, k);
+	}
+	writeString(ofs, tail);
+	writeString(ofs, orderedWindow);
+	ofs.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+	ofs.write(reinterpret_cast<const char*>(&state), sizeof(state));
+	return bool(ofs);
+}
+
+bool IncrementalSearch::loadState(const std::string& filename)
+{
+	std::ifstream ifs(filename, std::ios::binary);
+	if (!ifs)
+	{
+		return false;
+	}
+	ifs.seekg(0, std::ios::end);
+	uint64_t fileSize = uint64_t(ifs.tellg());
+	ifs.seekg(0, std::ios::beg);
+
+	// Everything is read into locals first, and the search is only changed once the whole file has been read and checked, so a failed load leaves it as it was.
+	// Each keyword takes at least the four bytes of its length, so there can't be more of them than a quarter of the file.
+	char magic[4];
+	uint32_t version;
+	uint8_t savedMode;
+	uint64_t savedOffset;
+	uint32_t keywordCount;
+	if (!ifs.read(magic, sizeof(magic)) || memcmp(magic, stateMagic, sizeof(magic)) != 0 ||
+		!ifs.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != stateVersion ||
+		!ifs.read(reinterpret_cast<char*>(&savedMode), sizeof(savedMode)) || savedMode > uint8_t(IncrementalMode::AhoCorasick) ||
+		!ifs.read(reinterpret_cast<char*>(&savedOffset), sizeof(savedOffset)) ||
+		!ifs.read(reinterpret_cast<char*>(&keywordCount), sizeof(keywordCount)) || keywordCount > fileSize / sizeof(uint32_t))
+	{
+		return false;
+	}
+
+	IncrementalMode savedSearch = IncrementalMode(savedMode);
+	std::vector<std::string> savedKeywords(keywordCount);
+	for (std::string& k : savedKeywords)
+	{
+		if (!readString(ifs, k, fileSize))
+		{
+			return false;
+		}
+	}
+
+	std::string savedTail, savedWindow;
+	uint64_t hash;
+	int32_t savedState;
+	if (!readString(ifs, savedTail, fileSize) || !readString(ifs, savedWindow, fileSize) ||
+		!ifs.read(reinterpret_cast<char*>(&hash), sizeof(hash)) ||
+		!ifs.read(reinterpret_cast<char*>(&savedState), sizeof(savedState)))
+	{
+		return false;
+	}
+
+	// The saved window is oldest byte first, so hashing it straight through should give the saved rolling hash.
+	if (savedSearch == IncrementalMode::RabinKarp && !savedKeywords.empty() && savedWindow.length() == savedKeywords[0].length() &&
+		RollingHash::hashOf(savedWindow.data(), savedWindow.length()) != hash)
+	{
+		return false;
+	}
+
+	// The automaton state can only be checked against the automaton, so it's built here. If the state doesn't fit, the automaton is built again for the old keywords.
+	if (savedSearch == IncrementalMode::AhoCorasick)
+	{
+		automaton.build(savedKeywords);
+		if (savedState < 0 || savedState >= automaton.getStateCount())
+		{
+			if (mode == IncrementalMode::AhoCorasick)
+			{
+				automaton.build(keywords);
+			}
+			return false;
+		}
+	}
+
+	mode = savedSearch;
+	keywords.swap(savedKeywords);
+	offset = savedOffset;
+	tail.swap(savedTail);
+	window.swap(savedWindow);
+	windowStart = 0;
+	state = savedState;
+
+	// The automaton has already been built above, so only the other modes need preparing.
+	if (mode != IncrementalMode::AhoCorasick)
+	{
+		prepare();
+	}
+	return true;
+}
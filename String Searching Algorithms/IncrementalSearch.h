@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "SearchTypes.h"
+#include "CompiledPattern.h"
+#include "RollingHash.h"
+#include "DoubleArrayTrie.h"
+
+// The algorithms that an incremental search can use.
+enum class IncrementalMode
+{
+	BoyerMoore,
+	RabinKarp,
+	AhoCorasick
+};
+
+// A search that can be carried on from where it left off when more text is added to the end, such as a log file that is still being written to.
+// It remembers how far through the text it has got and whatever part of a match might be in progress at the end of the text:
+// the last keyLength - 1 characters for Boyer-Moore, the rolling hash and its window for Rabin-Karp, or the automaton state for Aho-Corasick.
+// New text is then searched in time proportional to its own length rather than the length of the whole file. The state can be saved to a file and loaded again later.
+class IncrementalSearch
+{
+public:
+	// Constructor and destructor.
+	IncrementalSearch();
+	~IncrementalSearch();
+
+	// Starts a new search for a single keyword, from the beginning of the text.
+	void start(const std::string& kw, IncrementalMode mode);
+
+	// Starts a new search for several keywords with the Aho-Corasick automaton, from the beginning of the text.
+	void start(const std::vector<std::string>& kws);
+
+	// Searches the next part of the text. Matches are reported with their position from the start of the whole text, including matches that started in an earlier part.
+	void feed(const char* data, size_t length, std::vector<MultiMatch>& results);
+
+	// Searches whatever has been added to a file since the last call. If the file has got shorter it's assumed to have been replaced, and the search starts again from the beginning.
+	// Returns the number of new bytes that were searched.
+	size_t scanFile(const std::string& filename, std::vector<MultiMatch>& results);
+
+	// Saves and loads everything needed to carry on the search. Returns false if the file couldn't be written or read. A load that fails leaves the search as it was.
+	bool saveState(const std::string& filename) const;
+	bool loadState(const std::string& filename);
+
+	// How many bytes of text have been searched so far.
+	uint64_t getOffset() const { return offset; };
+	IncrementalMode getMode() const { return mode; };
+	const std::vector<std::string>& getKeywords() const { return keywords; };
+
+protected:
+	// The search for each mode.
+	void feedBoyerMoore(const char* data, size_t length, std::vector<MultiMatch>& results);
+	void feedRabinKarp(const char* data, size_t length, std::vector<MultiMatch>& results);
+	void feedAhoCorasick(const char* data, size_t length, std::vector<MultiMatch>& results);
+
+	// Builds the pattern, hash or automaton for the keywords after start() or loadState().
+	void prepare();
+
+	IncrementalMode mode;
+	std::vector<std::string> keywords;
+
+	// How many bytes have been searched.
+	uint64_t offset;
+
+	// Boyer-Moore: the compiled keyword and the last keyLength - 1 bytes of text, which could be the start of a match that finishes in the next part.
+	CompiledPattern pattern;
+	std::string tail;
+	std::string junction;
+
+	// Rabin-Karp: the last keyLength bytes of text, kept in a ring so that the oldest byte can be replaced without moving the others, and the rolling hash over them.
+	std::string window;
+	size_t windowStart;
+	RollingHash rollingHash;
+	uint64_t keyHash;
+
+	// Aho-Corasick: the automaton and the state it was left in.
+	DoubleArrayTrie automaton;
+	int32_t state;
+};
@@ -0,0 +1,361 @@
+#include "IndexSegment.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+// The file starts with this header on a page of its own, followed by the document starts, the text, the suffix array, the 3-gram directory and the postings,
+// each one padded out to the next page boundary. The numbers are written in the machine's own byte order, so a file has to be built on the same kind of machine that loads it.
+// Any change to the layout needs a new version number, so that old files are turned away instead of being misread.
+struct SegmentHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t pageSize;
+	uint64_t documentCount;
+	uint64_t textSize;
+	uint64_t gramCount;
+	uint64_t postingCount;
+	uint64_t documentsStart;
+	uint64_t textStart;
+	uint64_t suffixArrayStart;
+	uint64_t gramsStart;
+	uint64_t postingsStart;
+	uint64_t fileSize;
+};
+
+static const char segmentMagic[8] = { 'S', 'S', 'I', 'X', 'S', 'E', 'G', 0 };
+static const uint32_t segmentVersion = 1;
+static const uint64_t pageSize = 4096;
+
+// Rounds a size up to a whole number of pages.
+static uint64_t pageAlign(uint64_t size)
+{
+	return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+// Packs 3 characters into a number.
+static uint32_t packGram(const char* t)
+{
+	return (uint32_t((unsigned char)t[0]) << 16) | (uint32_t((unsigned char)t[1]) << 8) | uint32_t((unsigned char)t[2]);
+}
+
+// Builds the suffix array by prefix doubling: the suffixes are first sorted by their first character, then by their first 2, 4, 8... characters,
+// using the order from the last round to sort each pair of halves with two counting sorts. It stops as soon as every suffix has its own place.
+static void buildSuffixArray(const char* t, uint32_t n, std::vector<uint32_t>& sa)
+{
+	sa.resize(n);
+	if (n == 0)
+	{
+		return;
+	}
+
+	std::vector<uint32_t> rank(n);
+	std::vector<uint32_t> order(n);
+	std::vector<uint32_t> counts(std::max<size_t>(256, n) + 1);
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		counts[(unsigned char)t[i]]++;
+	}
+	for (size_t c = 1; c < 256; c++)
+	{
+		counts[c] += counts[c - 1];
+	}
+	for (uint32_t i = n; i > 0; i--)
+	{
+		sa[--counts[(unsigned char)t[i - 1]]] = i - 1;
+	}
+	rank[sa[0]] = 0;
+	for (uint32_t i = 1; i < n; i++)
+	{
+		rank[sa[i]] = rank[sa[i - 1]] + (t[sa[i]] != t[sa[i - 1]] ? 1 : 0);
+	}
+	uint32_t classes = rank[sa[n - 1]] + 1;
+
+	for (uint32_t k = 1; classes < n; k *= 2)
+	{
+		// Order by the second half: suffixes too short to have one come first, then the rest in the order of the suffix k further on.
+		uint32_t j = 0;
+		for (uint32_t i = k < n ? n - k : 0; i < n; i++)
+		{
+			order[j++] = i;
+		}
+		for (uint32_t i = 0; i < n; i++)
+		{
+			if (sa[i] >= k)
+			{
+				order[j++] = sa[i] - k;
+			}
+		}
+
+		// Then a stable sort by the first half.
+		std::fill(counts.begin(), counts.begin() + classes, 0);
+		for (uint32_t i = 0; i < n; i++)
+		{
+			counts[rank[i]]++;
+		}
+		for (uint32_t c = 1; c < classes; c++)
+		{
+			counts[c] += counts[c - 1];
+		}
+		for (uint32_t i = n; i > 0; i--)
+		{
+			uint32_t s = order[i - 1];
+			sa[--counts[rank[s]]] = s;
+		}
+
+		// Suffixes get the same rank only if both halves matched. 'order' is finished with, so it holds the new ranks.
+		order[sa[0]] = 0;
+		for (uint32_t i = 1; i < n; i++)
+		{
+			uint32_t previous = sa[i - 1];
+			uint32_t current = sa[i];
+			bool previousShort = previous + k >= n;
+			bool currentShort = current + k >= n;
+			bool same = rank[previous] == rank[current] && previousShort == currentShort && (previousShort || rank[previous + k] == rank[current + k]);
+			order[current] = order[previous] + (same ? 0 : 1);
+		}
+		rank.swap(order);
+		classes = rank[sa[n - 1]] + 1;
+	}
+}
+
+IndexSegment::IndexSegment()
+{
+	documentStarts = nullptr;
+	text = nullptr;
+	suffixArray = nullptr;
+	grams = nullptr;
+	postings = nullptr;
+	documentCount = 0;
+	textSize = 0;
+	gramCount = 0;
+}
+
+IndexSegment::~IndexSegment()
+{
+	close();
+}
+
+bool IndexSegment::write(const std::string& filename, const char* t, size_t length, const std::vector<uint64_t>& starts)
+{
+	if (length >= UINT32_MAX || starts.empty() || starts.back() != length)
+	{
+		return false;
+	}
+	uint32_t n = uint32_t(length);
+
+	std::vector<uint32_t> sa;
+	buildSuffixArray(t, n, sa);
+
+	// Sort every 3-gram by its characters and then its position, which groups the positions of each 3-gram together in order.
+	std::vector<uint64_t> pairs;
+	if (n >= 3)
+	{
+		pairs.resize(n - 2);
+		for (uint32_t i = 0; i + 2 < n; i++)
+		{
+			pairs[i] = (uint64_t(packGram(t + i)) << 32) | i;
+		}
+		std::sort(pairs.begin(), pairs.end());
+	}
+	std::vector<GramEntry> directory;
+	std::vector<uint32_t> positions(pairs.size());
+	for (size_t i = 0; i < pairs.size(); i++)
+	{
+		uint32_t gram = uint32_t(pairs[i] >> 32);
+		if (directory.empty() || directory.back().gram != gram)
+		{
+			directory.push_back(GramEntry{ gram, 0, i });
+		}
+		directory.back().count++;
+		positions[i] = uint32_t(pairs[i]);
+	}
+	std::vector<uint64_t>().swap(pairs);
+
+	SegmentHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, segmentMagic, sizeof(header.magic));
+	header.version = segmentVersion;
+	header.pageSize = uint32_t(pageSize);
+	header.documentCount = starts.size() - 1;
+	header.textSize = length;
+	header.gramCount = directory.size();
+	header.postingCount = positions.size();
+	header.documentsStart = pageSize;
+	header.textStart = header.documentsStart + pageAlign(starts.size() * sizeof(uint64_t));
+	header.suffixArrayStart = header.textStart + pageAlign(length);
+	header.gramsStart = header.suffixArrayStart + pageAlign(sa.size() * sizeof(uint32_t));
+	header.postingsStart = header.gramsStart + pageAlign(directory.size() * sizeof(GramEntry));
+	header.fileSize = header.postingsStart + pageAlign(positions.size() * sizeof(uint32_t));
+
+	std::ofstream ofs(filename, std::ios::binary);
+	if (!ofs)
+	{
+		return false;
+	}
+
+	// Writes a section and pads it to the start of the next one.
+	const std::vector<char> padding(size_t(pageSize), 0);
+	uint64_t written = 0;
+	auto section = [&](const void* data, uint64_t bytes)
+	{
+		ofs.write(static_cast<const char*>(data), std::streamsize(bytes));
+		written += bytes;
+		ofs.write(padding.data(), std::streamsize(pageAlign(written) - written));
+		written = pageAlign(written);
+	};
+	section(&header, sizeof(header));
+	section(starts.data(), starts.size() * sizeof(uint64_t));
+	section(t, length);
+	section(sa.data(), sa.size() * sizeof(uint32_t));
+	section(directory.data(), directory.size() * sizeof(GramEntry));
+	section(positions.data(), positions.size() * sizeof(uint32_t));
+
+	return bool(ofs);
+}
+
+bool IndexSegment::open(const std::string& filename)
+{
+	close();
+	if (!file.open(filename))
+	{
+		return false;
+	}
+
+	// Check the header and that every section fits inside the file before trusting any of it.
+	const char* data = file.data();
+	size_t size = file.size();
+	SegmentHeader header;
+	if (size < sizeof(header))
+	{
+		file.close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, segmentMagic, sizeof(header.magic)) != 0 || header.version != segmentVersion || header.pageSize != pageSize || header.fileSize > size
+		|| header.textSize >= UINT32_MAX
+		|| header.textStart < header.documentsStart + (header.documentCount + 1) * sizeof(uint64_t)
+		|| header.suffixArrayStart < header.textStart + header.textSize
+		|| header.gramsStart < header.suffixArrayStart + header.textSize * sizeof(uint32_t)
+		|| header.postingsStart < header.gramsStart + header.gramCount * sizeof(GramEntry)
+		|| header.fileSize < header.postingsStart + header.postingCount * sizeof(uint32_t))
+	{
+		file.close();
+		return false;
+	}
+
+	documentStarts = reinterpret_cast<const uint64_t*>(data + header.documentsStart);
+	text = data + header.textStart;
+	suffixArray = reinterpret_cast<const uint32_t*>(data + header.suffixArrayStart);
+	grams = reinterpret_cast<const GramEntry*>(data + header.gramsStart);
+	postings = reinterpret_cast<const uint32_t*>(data + header.postingsStart);
+	documentCount = header.documentCount;
+	textSize = header.textSize;
+	gramCount = header.gramCount;
+	return true;
+}
+
+void IndexSegment::close()
+{
+	file.close();
+	documentStarts = nullptr;
+	text = nullptr;
+	suffixArray = nullptr;
+	grams = nullptr;
+	postings = nullptr;
+	documentCount = 0;
+	textSize = 0;
+	gramCount = 0;
+}
+
+void IndexSegment::addMatches(std::vector<uint32_t>& positions, size_t length, uint64_t firstDocument, std::vector<IndexMatch>& results) const
+{
+	std::sort(positions.begin(), positions.end());
+
+	// The positions are in order, so the document they're in only ever moves forwards.
+	uint64_t d = 0;
+	for (uint32_t p : positions)
+	{
+		while (documentStarts[d + 1] <= p)
+		{
+			d++;
+		}
+		if (p + length <= documentStarts[d + 1])
+		{
+			results.push_back(IndexMatch{ firstDocument + d, p - documentStarts[d] });
+		}
+	}
+}
+
+void IndexSegment::find(const char* pattern, size_t length, uint64_t firstDocument, std::vector<IndexMatch>& results) const
+{
+	if (length == 0 || textSize == 0)
+	{
+		return;
+	}
+
+	// Compares the suffix starting at p with the keyword, only as far as the keyword's length, so every suffix that starts with the keyword compares as equal.
+	auto compare = [&](uint32_t p)
+	{
+		size_t left = size_t(textSize - p);
+		int c = memcmp(text + p, pattern, std::min(left, length));
+		if (c != 0)
+		{
+			return c;
+		}
+		return left < length ? -1 : 0;
+	};
+
+	const uint32_t* end = suffixArray + textSize;
+	const uint32_t* first = std::lower_bound(suffixArray, end, 0, [&](uint32_t p, int) { return compare(p) < 0; });
+	const uint32_t* last = std::upper_bound(first, end, 0, [&](int, uint32_t p) { return compare(p) > 0; });
+
+	std::vector<uint32_t> positions(first, last);
+	addMatches(positions, length, firstDocument, results);
+}
+
+const IndexSegment::GramEntry* IndexSegment::findGram(uint32_t gram) const
+{
+	const GramEntry* end = grams + gramCount;
+	const GramEntry* found = std::lower_bound(grams, end, gram, [](const GramEntry& e, uint32_t g) { return e.gram < g; });
+	return found != end && found->gram == gram ? found : nullptr;
+}
+
+void IndexSegment::findByNGrams(const char* pattern, size_t length, uint64_t firstDocument, std::vector<IndexMatch>& results) const
+{
+	if (length < 3)
+	{
+		find(pattern, length, firstDocument, results);
+		return;
+	}
+
+	// Pick the 3-gram of the keyword with the fewest positions. If any of them doesn't occur at all, neither does the keyword.
+	const GramEntry* rarest = nullptr;
+	size_t rarestOffset = 0;
+	for (size_t i = 0; i + 3 <= length; i++)
+	{
+		const GramEntry* entry = findGram(packGram(pattern + i));
+		if (entry == nullptr)
+		{
+			return;
+		}
+		if (rarest == nullptr || entry->count < rarest->count)
+		{
+			rarest = entry;
+			rarestOffset = i;
+		}
+	}
+
+	// Check the keyword at each place the rarest 3-gram puts it. The postings are already in order.
+	std::vector<uint32_t> positions;
+	for (uint32_t i = 0; i < rarest->count; i++)
+	{
+		uint32_t p = postings[rarest->start + i];
+		if (p >= rarestOffset && p - rarestOffset + length <= textSize && memcmp(text + p - rarestOffset, pattern, length) == 0)
+		{
+			positions.push_back(uint32_t(p - rarestOffset));
+		}
+	}
+	addMatches(positions, length, firstDocument, results);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "MappedFile.h"
+
+// An occurance found through an index: which document it's in, and where it starts in that document.
+struct IndexMatch
+{
+	uint64_t document;
+	uint64_t position;
+};
+
+// One file of an on-disk index, holding a group of documents together with a suffix array and the positions of every 3-gram in them.
+// Everything is stored as flat arrays that each start on a 4096 byte page boundary, so the file is mapped into memory and searched in place the moment it's opened,
+// without reading or rebuilding anything. Only the pages a search actually touches get loaded by the operating system.
+//
+// The suffix array lists every position in the text in the alphabetical order of the text that starts there, so all of the occurances of a keyword are next to each other
+// and can be found with two binary searches. The 3-gram postings list where each run of 3 characters occurs, so a keyword can also be found by checking
+// the positions of its rarest 3-gram.
+//
+// A segment is never changed once it's written. New documents go into new segments, and segments are combined by writing a new one (see SegmentedIndex).
+class IndexSegment
+{
+public:
+	// Constructor and destructor. The destructor unmaps the file if it's still open.
+	IndexSegment();
+	~IndexSegment();
+
+	// Builds the index for a text holding one or more documents and writes it to a file. 'documentStarts' has the position where each document starts,
+	// followed by the length of the text. Returns false if the file couldn't be written, or the text is too long for 32-bit positions.
+	static bool write(const std::string& filename, const char* text, size_t length, const std::vector<uint64_t>& documentStarts);
+
+	// Maps a file written by write(). Returns false if the file is missing, or isn't a segment file of this version.
+	bool open(const std::string& filename);
+	void close();
+
+	// Finds every occurance of a keyword with the suffix array, adding them to the results in document order. 'firstDocument' is added to the document numbers.
+	void find(const char* pattern, size_t length, uint64_t firstDocument, std::vector<IndexMatch>& results) const;
+
+	// Finds every occurance of a keyword by checking the positions of its rarest 3-gram. Keywords shorter than 3 characters use the suffix array instead.
+	void findByNGrams(const char* pattern, size_t length, uint64_t firstDocument, std::vector<IndexMatch>& results) const;
+
+	// The documents held in the segment, straight out of the mapped file.
+	uint64_t getDocumentCount() const { return documentCount; };
+	uint64_t getTextSize() const { return textSize; };
+	const char* getText() const { return text; };
+	const uint64_t* getDocumentStarts() const { return documentStarts; };
+	std::string getDocument(uint64_t d) const { return std::string(text + documentStarts[d], size_t(documentStarts[d + 1] - documentStarts[d])); };
+
+	size_t fileSize() const { return file.size(); };
+	bool isOpen() const { return file.isOpen(); };
+
+protected:
+	// One entry in the 3-gram directory: the 3 characters packed into a number, how many times they occur, and where their positions start in the postings.
+	struct GramEntry
+	{
+		uint32_t gram;
+		uint32_t count;
+		uint64_t start;
+	};
+
+	// Sorts the positions found in the text, works out which document each is in, and drops any that run past the end of their document.
+	void addMatches(std::vector<uint32_t>& positions, size_t length, uint64_t firstDocument, std::vector<IndexMatch>& results) const;
+
+	// Looks up a 3-gram in the directory, returning nullptr if it doesn't occur.
+	const GramEntry* findGram(uint32_t gram) const;
+
+	// Pointers to each section of the mapped file.
+	const uint64_t* documentStarts;
+	const char* text;
+	const uint32_t* suffixArray;
+	const GramEntry* grams;
+	const uint32_t* postings;
+
+	uint64_t documentCount;
+	uint64_t textSize;
+	uint64_t gramCount;
+
+	MappedFile file;
+};
@@ -0,0 +1,149 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	fileData = nullptr;
+	fileSize = 0;
+	opened = false;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(file, &length))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	fileSize = size_t(length.QuadPart);
+	opened = true;
+
+	// Windows refuses to map an empty file, so there's nothing more to do.
+	if (fileSize == 0)
+	{
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	fileData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (fileData == nullptr)
+	{
+		close();
+		return false;
+	}
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	fileSize = size_t(info.st_size);
+	opened = true;
+
+	// mmap fails on a zero length mapping, so an empty file is left unmapped.
+	if (fileSize > 0)
+	{
+		void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED)
+		{
+			::close(fd);
+			fileSize = 0;
+			opened = false;
+			return false;
+		}
+		fileData = static_cast<const char*>(mapping);
+	}
+
+	// The mapping stays valid after the descriptor is closed.
+	::close(fd);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (fileData != nullptr)
+	{
+		UnmapViewOfFile(fileData);
+	}
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (fileData != nullptr)
+	{
+		munmap(const_cast<char*>(fileData), fileSize);
+	}
+#endif
+
+	fileData = nullptr;
+	fileSize = 0;
+	opened = false;
+}
+
+void MappedFile::swap(MappedFile& other)
+{
+	std::swap(fileData, other.fileData);
+	std::swap(fileSize, other.fileSize);
+	std::swap(opened, other.opened);
+#ifdef _WIN32
+	std::swap(fileHandle, other.fileHandle);
+	std::swap(mappingHandle, other.mappingHandle);
+#endif
+}
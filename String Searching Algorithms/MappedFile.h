@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Maps a whole file into memory as read-only so that it can be used without copying it into a buffer first.
+// The operating system only loads the pages that are actually touched, so opening even a very large file is close to instant.
+class MappedFile
+{
+public:
+	// Constructor and destructor. The destructor unmaps the file if one is still open.
+	MappedFile();
+	~MappedFile();
+
+	// Opens and maps the file. Returns false if the file couldn't be opened or mapped.
+	bool open(const std::string& filename);
+
+	// Unmaps the file and closes it.
+	void close();
+
+	// Swaps mappings with another MappedFile, so that a file can be mapped and checked before it replaces the one that's open.
+	void swap(MappedFile& other);
+
+	// Access to the mapped bytes.
+	const char* data() const { return fileData; };
+	size_t size() const { return fileSize; };
+	bool isOpen() const { return opened; };
+
+private:
+	// Copying would unmap the file twice, so it isn't allowed.
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	// Pointer to the start of the mapping and its length in bytes.
+	const char* fileData;
+	size_t fileSize;
+
+	// An empty file can't be mapped, but it still counts as opened.
+	bool opened;
+
+#ifdef _WIN32
+	// Windows needs the file handle and the mapping handle kept until the view is unmapped.
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
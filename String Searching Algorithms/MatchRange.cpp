@@ -0,0 +1,66 @@
+#include "MatchRange.h"
+
+MatchRange::MatchRange(const CompiledPattern& p, const char* t, size_t length, bool overlapping) : pattern(p)
+{
+	text = t;
+	textLength = length;
+	overlaps = overlapping;
+}
+
+size_t MatchRange::first() const
+{
+	if (pattern.length() == 0)
+	{
+		return CompiledPattern::npos;
+	}
+	return pattern.find(text, textLength);
+}
+
+size_t MatchRange::next(size_t position) const
+{
+	return pattern.find(text, textLength, position + (overlaps ? 1 : pattern.length()));
+}
+
+MultiMatchRange::MultiMatchRange(const DoubleArrayTrie& a, const char* t, size_t length) : automaton(a)
+{
+	text = t;
+	textLength = length;
+}
+
+MultiMatchRange::iterator::iterator(const MultiMatchRange* r) : range(r), next(0), state(0), index(0)
+{
+	advance();
+}
+
+MultiMatchRange::iterator& MultiMatchRange::iterator::operator++()
+{
+	index++;
+	if (index >= found.size())
+	{
+		advance();
+	}
+	return *this;
+}
+
+void MultiMatchRange::iterator::advance()
+{
+	found.clear();
+	index = 0;
+	if (range->automaton.getStateCount() == 0)
+	{
+		*this = iterator();
+		return;
+	}
+
+	while (found.empty())
+	{
+		if (next >= range->textLength)
+		{
+			*this = iterator();
+			return;
+		}
+		state = range->automaton.step(state, (unsigned char)range->text[next]);
+		next++;
+		range->automaton.collect(state, next, found);
+	}
+}
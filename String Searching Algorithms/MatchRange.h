@@ -0,0 +1,107 @@
+#pragma once
+#include <vector>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include "SearchTypes.h"
+#include "CompiledPattern.h"
+#include "DoubleArrayTrie.h"
+
+// The matches of a keyword in a text, found one at a time as they're asked for instead of all at once into a vector.
+// Looping over the range finds the next match each time round, so the first match is ready as soon as it's reached, a loop can stop early without searching
+// the rest of the text, and millions of matches take no more memory than one. The pattern and the text have to stay as they are while the range is used.
+//
+//     for (size_t position : MatchRange(pattern, text, length)) { ... }
+class MatchRange
+{
+public:
+	// Walks through the matches. Reading it gives the position of the current match.
+	class iterator
+	{
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef size_t value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const size_t* pointer;
+		typedef const size_t& reference;
+
+		iterator() : range(nullptr), position(CompiledPattern::npos) {};
+		iterator(const MatchRange* r, size_t p) : range(r), position(p) {};
+
+		reference operator*() const { return position; };
+		iterator& operator++() { position = range->next(position); return *this; };
+		iterator operator++(int) { iterator old = *this; ++*this; return old; };
+		bool operator==(const iterator& other) const { return position == other.position; };
+		bool operator!=(const iterator& other) const { return position != other.position; };
+
+	private:
+		const MatchRange* range;
+		size_t position;
+	};
+
+	// With 'overlapping' set, a match can start inside the one before it, the same as findAll(). Otherwise the search carries on from the end of each match.
+	MatchRange(const CompiledPattern& p, const char* t, size_t length, bool overlapping = true);
+
+	// begin() searches for the first match.
+	iterator begin() const { return iterator(this, first()); };
+	iterator end() const { return iterator(); };
+
+private:
+	// The first match, and the match after the one at 'position'.
+	size_t first() const;
+	size_t next(size_t position) const;
+
+	const CompiledPattern& pattern;
+	const char* text;
+	size_t textLength;
+	bool overlaps;
+};
+
+// The matches of an Aho-Corasick automaton in a text, found one at a time. They come in the order they end in the text, the same as DoubleArrayTrie::search().
+// The only thing kept between matches is the automaton state and the few keywords that end at the current character.
+class MultiMatchRange
+{
+public:
+	// Walks through the matches. Reading it gives the current match.
+	class iterator
+	{
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef MultiMatch value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const MultiMatch* pointer;
+		typedef const MultiMatch& reference;
+
+		iterator() : range(nullptr), next(0), state(0), index(0) {};
+		iterator(const MultiMatchRange* r);
+
+		reference operator*() const { return found[index]; };
+		pointer operator->() const { return &found[index]; };
+		iterator& operator++();
+		iterator operator++(int) { iterator old = *this; ++*this; return old; };
+
+		// Iterators are only compared with end(), which is the one with no range left.
+		bool operator==(const iterator& other) const { return range == other.range && next == other.next && index == other.index; };
+		bool operator!=(const iterator& other) const { return !(*this == other); };
+
+	private:
+		// Reads the text until a keyword ends, or sets the iterator to end() if the text runs out first.
+		void advance();
+
+		const MultiMatchRange* range;
+		size_t next;
+		int32_t state;
+		std::vector<MultiMatch> found;
+		size_t index;
+	};
+
+	MultiMatchRange(const DoubleArrayTrie& a, const char* t, size_t length);
+
+	iterator begin() const { return iterator(this); };
+	iterator end() const { return iterator(); };
+
+private:
+	const DoubleArrayTrie& automaton;
+	const char* text;
+	size_t textLength;
+};
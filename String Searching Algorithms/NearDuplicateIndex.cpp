@@ -0,0 +1,288 @@
+#include "NearDuplicateIndex.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include "RollingHash.h"
+#include "WorkerPool.h"
+
+// Scrambles the bits of a 64-bit number (the finaliser from splitmix64), used to make the hash functions for the signatures.
+static inline uint64_t mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+}
+
+// A task that works out the signatures of a range of documents. Each document's signature has its own place in the array, so the tasks don't share anything they write to.
+class SignatureTask :
+	public Task
+{
+public:
+	SignatureTask(const NearDuplicateIndex* i, const std::vector<std::string>* d, int f, int e, uint32_t* s, std::vector<char>* h)
+	{
+		index = i;
+		documents = d;
+		first = f;
+		end = e;
+		signatures = s;
+		hasSignature = h;
+	};
+
+	void run()
+	{
+		for (int i = first; i < end; i++)
+		{
+			const std::string& document = (*documents)[i];
+			(*hasSignature)[i] = index->computeSignature(document.data(), document.length(), signatures + size_t(i) * NearDuplicateIndex::signatureLength) ? 1 : 0;
+		}
+	};
+
+private:
+	const NearDuplicateIndex* index;
+	const std::vector<std::string>* documents;
+	int first;
+	int end;
+	uint32_t* signatures;
+	std::vector<char>* hasSignature;
+};
+
+NearDuplicateIndex::NearDuplicateIndex(int k, int w, int bands)
+{
+	gramLength = k < 1 ? 1 : k;
+	windowLength = w < 1 ? 1 : w;
+
+	// Every band has the same number of rows, so the band count has to divide the signature length.
+	bandCount = 1;
+	while (bandCount * 2 <= bands && signatureLength % (bandCount * 2) == 0)
+	{
+		bandCount *= 2;
+	}
+	rowCount = signatureLength / bandCount;
+	documentCount = 0;
+}
+
+NearDuplicateIndex::~NearDuplicateIndex()
+{
+}
+
+std::vector<WinnowedHash> NearDuplicateIndex::winnow(const char* t, size_t length, int k, int w)
+{
+	std::vector<WinnowedHash> result;
+	if (k < 1 || w < 1 || length < size_t(k))
+	{
+		return result;
+	}
+	size_t grams = length - k + 1;
+
+	// A short document has fewer than w k-grams, so its one window is all of them.
+	size_t window = std::min(size_t(w), grams);
+
+	// The deque holds the k-grams that could still be the smallest in a window, with their hashes increasing from front to back.
+	// When a new hash comes in, any hash behind it that isn't smaller can never be chosen again. Ties go to the rightmost hash, as in the original winnowing paper.
+	std::deque<WinnowedHash> candidates;
+	RollingHash hash = RollingHash(size_t(k));
+	uint64_t h = hash.init(t);
+	size_t lastChosen = std::numeric_limits<size_t>::max();
+	for (size_t i = 0; i < grams; i++)
+	{
+		if (i > 0)
+		{
+			h = hash.roll((unsigned char)t[i - 1], (unsigned char)t[i + k - 1]);
+		}
+
+		// The top bits of the polynomial hash are the best mixed, so the hash is scrambled before it's compared.
+		uint64_t value = mix(h);
+		while (!candidates.empty() && candidates.back().hash >= value)
+		{
+			candidates.pop_back();
+		}
+		candidates.push_back({ value, i });
+
+		if (i + 1 >= window)
+		{
+			while (candidates.front().position + window <= i)
+			{
+				candidates.pop_front();
+			}
+
+			// Neighbouring windows usually choose the same k-gram, which is only recorded once.
+			if (candidates.front().position != lastChosen)
+			{
+				lastChosen = candidates.front().position;
+				result.push_back(candidates.front());
+			}
+		}
+	}
+	return result;
+}
+
+bool NearDuplicateIndex::computeSignature(const char* t, size_t length, uint32_t* signature) const
+{
+	std::vector<WinnowedHash> fingerprints = winnow(t, length, gramLength, windowLength);
+	for (int j = 0; j < signatureLength; j++)
+	{
+		signature[j] = std::numeric_limits<uint32_t>::max();
+	}
+	if (fingerprints.empty())
+	{
+		return false;
+	}
+
+	// The j'th hash function is a + j * b, with a and b made from the fingerprint. This gives 64 hash functions for the cost of two,
+	// and works nearly as well as 64 separate functions.
+	for (const WinnowedHash& f : fingerprints)
+	{
+		uint64_t a = mix(f.hash);
+		uint64_t b = mix(f.hash ^ 0x9E3779B97F4A7C15ULL) | 1;
+		for (int j = 0; j < signatureLength; j++)
+		{
+			uint32_t value = uint32_t((a + uint64_t(j) * b) >> 32);
+			if (value < signature[j])
+			{
+				signature[j] = value;
+			}
+		}
+	}
+	return true;
+}
+
+void NearDuplicateIndex::addDocument(const char* t, size_t length)
+{
+	signatures.resize(signatures.size() + signatureLength);
+	hasSignature.push_back(computeSignature(t, length, &signatures[size_t(documentCount) * signatureLength]));
+	documentCount++;
+}
+
+void NearDuplicateIndex::addDocuments(const std::vector<std::string>& documents, int threads)
+{
+	int first = documentCount;
+	int count = int(documents.size());
+	signatures.resize(signatures.size() + size_t(count) * signatureLength);
+	std::vector<char> found(count, 0);
+
+	if (threads <= 1 || count < 2)
+	{
+		SignatureTask(this, &documents, 0, count, &signatures[size_t(first) * signatureLength], &found).run();
+	}
+	else
+	{
+		// A few more groups than threads, so that a thread that gets short documents can pick up another group.
+		int groups = std::min(count, threads * 4);
+		WorkerPool pool;
+		pool.start(threads);
+		for (int g = 0; g < groups; g++)
+		{
+			pool.add_task(new SignatureTask(this, &documents, int(size_t(count) * g / groups), int(size_t(count) * (g + 1) / groups), &signatures[size_t(first) * signatureLength], &found));
+		}
+		pool.wait();
+		pool.stop();
+	}
+
+	for (char f : found)
+	{
+		hasSignature.push_back(f != 0);
+	}
+	documentCount += count;
+}
+
+double NearDuplicateIndex::similarity(int a, int b) const
+{
+	if (!hasSignature[a] || !hasSignature[b])
+	{
+		return 0.0;
+	}
+	const uint32_t* x = &signatures[size_t(a) * signatureLength];
+	const uint32_t* y = &signatures[size_t(b) * signatureLength];
+	int same = 0;
+	for (int j = 0; j < signatureLength; j++)
+	{
+		same += x[j] == y[j] ? 1 : 0;
+	}
+	return double(same) / signatureLength;
+}
+
+std::vector<DuplicatePair> NearDuplicateIndex::findDuplicates(double threshold) const
+{
+	// For each band, sort the documents by the hash of their values in that band. Documents that agree on the whole band end up next to each other.
+	// Every pair in a run of equal hashes is a candidate. Packing each pair into one number lets the pairs found by several bands be removed with a sort.
+	std::vector<uint64_t> candidates;
+	std::vector<std::pair<uint64_t, int>> keys;
+	keys.reserve(documentCount);
+	for (int band = 0; band < bandCount; band++)
+	{
+		keys.clear();
+		for (int d = 0; d < documentCount; d++)
+		{
+			if (!hasSignature[d])
+			{
+				continue;
+			}
+			const uint32_t* rows = &signatures[size_t(d) * signatureLength + size_t(band) * rowCount];
+			uint64_t key = uint64_t(band);
+			for (int r = 0; r < rowCount; r++)
+			{
+				key = mix(key ^ rows[r]);
+			}
+			keys.push_back({ key, d });
+		}
+		std::sort(keys.begin(), keys.end());
+
+		for (size_t i = 0; i < keys.size(); )
+		{
+			size_t j = i + 1;
+			while (j < keys.size() && keys[j].first == keys[i].first)
+			{
+				j++;
+			}
+			for (size_t a = i; a < j; a++)
+			{
+				for (size_t b = a + 1; b < j; b++)
+				{
+					candidates.push_back((uint64_t(keys[a].second) << 32) | uint64_t(keys[b].second));
+				}
+			}
+			i = j;
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	// Only keep the candidates whose whole signatures are similar enough.
+	std::vector<DuplicatePair> pairs;
+	for (uint64_t c : candidates)
+	{
+		int a = int(c >> 32);
+		int b = int(c & 0xFFFFFFFF);
+		double s = similarity(a, b);
+		if (s >= threshold)
+		{
+			pairs.push_back({ a, b, s });
+		}
+	}
+	return pairs;
+}
+
+std::vector<DuplicatePair> NearDuplicateIndex::findDuplicatesExhaustive(double threshold) const
+{
+	std::vector<DuplicatePair> pairs;
+	for (int a = 0; a < documentCount; a++)
+	{
+		for (int b = a + 1; b < documentCount; b++)
+		{
+			double s = similarity(a, b);
+			if (s >= threshold && s > 0.0)
+			{
+				pairs.push_back({ a, b, s });
+			}
+		}
+	}
+	return pairs;
+}
+
+size_t NearDuplicateIndex::memoryUsage() const
+{
+	return signatures.capacity() * sizeof(uint32_t) + hasSignature.capacity() / 8;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// A hash picked out of a document by winnowing, and where the k-gram it came from starts.
+struct WinnowedHash
+{
+	uint64_t hash;
+	size_t position;
+};
+
+// Two documents that are likely to be copies of each other, and the estimated fraction of their fingerprints that they share.
+struct DuplicatePair
+{
+	int first;
+	int second;
+	double similarity;
+};
+
+// Finds documents that are mostly the same as each other in a large collection, such as different drafts of the Shrek script.
+//
+// Each document is first reduced to a set of fingerprints by winnowing: the rolling hash from the Rabin-Karp search is taken of every k characters,
+// and from every window of w hashes in a row the smallest one is kept. Any piece of text at least w + k - 1 characters long that two documents share
+// is guaranteed to give them a fingerprint in common, however the rest of the documents differ.
+//
+// Comparing the fingerprint sets of every pair of documents would take time proportional to the square of the number of documents, so each set is boiled down to
+// a MinHash signature: the smallest value of each of several hash functions over the set. Two signatures agree in each place with a probability equal to the
+// Jaccard similarity of the sets. The signature is cut into bands, and only documents that agree on every value in at least one band are compared (locality sensitive hashing),
+// which finds the similar pairs without looking at the others.
+class NearDuplicateIndex
+{
+public:
+	// The number of values in each signature. It must equal bands * rows.
+	static const int signatureLength = 64;
+
+	// k is the length of the k-grams in characters, and w is the number of k-gram hashes that each fingerprint is chosen from.
+	// With 16 bands of 4 rows, a pair with a similarity of 0.5 is compared 64% of the time, and a pair with 0.8 is compared over 99.9% of the time.
+	NearDuplicateIndex(int k = 16, int w = 16, int bands = 16);
+	~NearDuplicateIndex();
+
+	// Adds documents to the index, working out their signatures on several threads. Documents are numbered in the order they are added.
+	void addDocuments(const std::vector<std::string>& documents, int threads = 1);
+	void addDocument(const char* t, size_t length);
+
+	// Returns every pair of documents whose estimated similarity is at least 'threshold', found with the LSH bands.
+	std::vector<DuplicatePair> findDuplicates(double threshold) const;
+
+	// The same as findDuplicates(), but by comparing every pair of signatures. Only useful for checking what the bands miss on small collections.
+	std::vector<DuplicatePair> findDuplicatesExhaustive(double threshold) const;
+
+	// The estimated similarity of two documents in the index, from 0 to 1.
+	double similarity(int a, int b) const;
+
+	int getDocumentCount() const { return documentCount; };
+	size_t memoryUsage() const;
+
+	// The fingerprints chosen from a document by winnowing, in the order they appear.
+	static std::vector<WinnowedHash> winnow(const char* t, size_t length, int k, int w);
+
+protected:
+	// The task that works out signatures on the worker threads.
+	friend class SignatureTask;
+
+	// Works out the signature of a document and stores it in 'signature'. Returns false if the document is too short to have any k-grams.
+	bool computeSignature(const char* t, size_t length, uint32_t* signature) const;
+
+	int gramLength;
+	int windowLength;
+	int bandCount;
+	int rowCount;
+
+	// The signatures of all of the documents, one after another, and whether each document had any fingerprints at all.
+	std::vector<uint32_t> signatures;
+	std::vector<bool> hasSignature;
+	int documentCount;
+};
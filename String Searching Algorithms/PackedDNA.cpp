@@ -0,0 +1,324 @@
+#include "PackedDNA.h"
+
+// SSE2 is part of every 64-bit x86 CPU, so the fast packer can use it without checking the CPU first.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PACKED_SSE2 1
+#include <emmintrin.h>
+#else
+#define PACKED_SSE2 0
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Every 2 bit lane with its low bit set, and each base repeated across a whole word.
+static const uint64_t lowBits = 0x5555555555555555ULL;
+static const uint64_t repeated[4] = { 0, lowBits, lowBits * 2, lowBits * 3 };
+
+// How many bases at the start of the keyword are compared at every position before the whole keyword is checked.
+// 8 bases only let through about 1 in 65536 positions of random DNA.
+static const int filterLength = 8;
+
+// Index of the lowest set bit.
+static inline int lowestBit(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return int(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)x))
+	{
+		return int(index);
+	}
+	_BitScanForward(&index, (unsigned long)(x >> 32));
+	return int(index) + 32;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+// What each character means when packing: a base's 2 bit code, an unknown base, or a line break that is skipped.
+static const int8_t unknownBase = -1;
+static const int8_t lineBreak = -2;
+
+struct CharacterCodes
+{
+	int8_t codes[256];
+
+	CharacterCodes()
+	{
+		for (int c = 0; c < 256; c++)
+		{
+			codes[c] = unknownBase;
+		}
+		for (const char* b = "ACGTacgt"; *b; b++)
+		{
+			codes[(unsigned char)*b] = int8_t(((unsigned char)*b >> 1) & 3);
+		}
+		codes['\n'] = lineBreak;
+		codes['\r'] = lineBreak;
+	}
+};
+
+// The table is built the first time it's needed.
+static const int8_t* characterCodes()
+{
+	static const CharacterCodes table;
+	return table.codes;
+}
+
+// Spreads the 16 bits of x out to the even bits of a 32 bit number.
+static inline uint64_t spreadBits(uint64_t x)
+{
+	x = (x | (x << 8)) & 0x00FF00FFULL;
+	x = (x | (x << 4)) & 0x0F0F0F0FULL;
+	x = (x | (x << 2)) & 0x33333333ULL;
+	x = (x | (x << 1)) & 0x55555555ULL;
+	return x;
+}
+
+PackedDNA::PackedDNA()
+{
+	bases = 0;
+	words.assign(2, 0);
+}
+
+PackedDNA::~PackedDNA()
+{
+}
+
+void PackedDNA::append(uint64_t codes, int count)
+{
+	size_t word = bases / 32;
+	int shift = int(bases % 32) * 2;
+	words[word] |= codes << shift;
+
+	// Some of the bases may not fit in the current word, and there always needs to be a spare word after the last base.
+	if (shift + count * 2 > 64)
+	{
+		words[word + 1] |= codes >> (64 - shift);
+	}
+	bases += count;
+	if (words.size() < bases / 32 + 2)
+	{
+		words.push_back(0);
+	}
+}
+
+void PackedDNA::markUnknown(size_t i)
+{
+	if (unknown.size() <= i / 64)
+	{
+		unknown.resize(i / 64 + 1, 0);
+	}
+	unknown[i / 64] |= uint64_t(1) << (i % 64);
+}
+
+void PackedDNA::pack(const char* t, size_t length)
+{
+	const int8_t* codes = characterCodes();
+	words.clear();
+	words.reserve(length / 32 + 2);
+	words.assign(2, 0);
+	unknown.clear();
+	bases = 0;
+
+	size_t i = 0;
+#if PACKED_SSE2
+	// 16 characters at a time. Bit 1 of each character is the low bit of its code and bit 2 is the high bit, so shifting them up to the top bit of each byte
+	// lets movemask collect them. Any block that isn't all A, C, G or T is packed one character at a time below instead.
+	const __m128i lowerCase = _mm_set1_epi8(0x20);
+	const __m128i a = _mm_set1_epi8('a');
+	const __m128i c = _mm_set1_epi8('c');
+	const __m128i g = _mm_set1_epi8('g');
+	const __m128i tBase = _mm_set1_epi8('t');
+	while (i + 16 <= length)
+	{
+		__m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + i));
+		__m128i lower = _mm_or_si128(text, lowerCase);
+		__m128i valid = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, a), _mm_cmpeq_epi8(lower, c)), _mm_or_si128(_mm_cmpeq_epi8(lower, g), _mm_cmpeq_epi8(lower, tBase)));
+
+		if (_mm_movemask_epi8(valid) == 0xFFFF)
+		{
+			uint64_t low = uint64_t(_mm_movemask_epi8(_mm_slli_epi16(text, 6)));
+			uint64_t high = uint64_t(_mm_movemask_epi8(_mm_slli_epi16(text, 5)));
+			append(spreadBits(low) | (spreadBits(high) << 1), 16);
+		}
+		else
+		{
+			for (size_t j = i; j < i + 16; j++)
+			{
+				int8_t code = codes[(unsigned char)t[j]];
+				if (code == lineBreak)
+				{
+					continue;
+				}
+				if (code == unknownBase)
+				{
+					markUnknown(bases);
+					code = 0;
+				}
+				append(uint64_t(code), 1);
+			}
+		}
+		i += 16;
+	}
+#endif
+
+	for (; i < length; i++)
+	{
+		int8_t code = codes[(unsigned char)t[i]];
+		if (code == lineBreak)
+		{
+			continue;
+		}
+		if (code == unknownBase)
+		{
+			markUnknown(bases);
+			code = 0;
+		}
+		append(uint64_t(code), 1);
+	}
+
+	if (!unknown.empty())
+	{
+		unknown.resize(bases / 64 + 1, 0);
+	}
+}
+
+uint64_t PackedDNA::window(size_t i) const
+{
+	size_t word = i / 32;
+	int shift = int(i % 32) * 2;
+	uint64_t result = words[word] >> shift;
+	if (shift != 0 && word + 1 < words.size())
+	{
+		result |= words[word + 1] << (64 - shift);
+	}
+	return result;
+}
+
+bool PackedDNA::hasUnknown(size_t from, size_t to) const
+{
+	if (unknown.empty())
+	{
+		return false;
+	}
+	for (size_t i = from; i < to; )
+	{
+		// Skip whole words of the bitmap where possible.
+		if (i % 64 == 0 && i + 64 <= to)
+		{
+			if (unknown[i / 64] != 0)
+			{
+				return true;
+			}
+			i += 64;
+		}
+		else
+		{
+			if ((unknown[i / 64] >> (i % 64)) & 1)
+			{
+				return true;
+			}
+			i++;
+		}
+	}
+	return false;
+}
+
+char PackedDNA::baseAt(size_t i) const
+{
+	if (hasUnknown(i, i + 1))
+	{
+		return 'N';
+	}
+	static const char letters[4] = { 'A', 'C', 'T', 'G' };
+	return letters[(words[i / 32] >> ((i % 32) * 2)) & 3];
+}
+
+size_t PackedDNA::memoryUsage() const
+{
+	return (words.capacity() + unknown.capacity()) * sizeof(uint64_t);
+}
+
+std::vector<size_t> PackedDNA::search(const std::string& kw) const
+{
+	std::vector<size_t> results;
+	size_t keyLength = kw.length();
+	if (keyLength == 0 || keyLength > bases)
+	{
+		return results;
+	}
+
+	// Pack the keyword the same way, 32 bases to a word.
+	const int8_t* codes = characterCodes();
+	std::vector<uint64_t> keyWords((keyLength + 31) / 32, 0);
+	for (size_t j = 0; j < keyLength; j++)
+	{
+		int8_t code = codes[(unsigned char)kw[j]];
+		if (code < 0)
+		{
+			return results;
+		}
+		keyWords[j / 32] |= uint64_t(code) << ((j % 32) * 2);
+	}
+	int filter = int(keyLength < size_t(filterLength) ? keyLength : size_t(filterLength));
+	int filterCodes[filterLength];
+	for (int j = 0; j < filter; j++)
+	{
+		filterCodes[j] = int((keyWords[0] >> (j * 2)) & 3);
+	}
+
+	size_t lastStart = bases - keyLength;
+	size_t lastWord = lastStart / 32;
+	for (size_t w = 0; w <= lastWord; w++)
+	{
+		uint64_t current = words[w];
+		uint64_t next = words[w + 1];
+
+		// Lane l of 'matching' stays 01 while the bases starting at position 32w + l agree with the start of the keyword.
+		// For the j'th base, the word is moved down by j bases so the base j after each starting position lines up with it, and XORing with the keyword's base
+		// repeated in every lane leaves a lane at 00 only where the two bases are the same.
+		uint64_t matching = lowBits;
+		for (int j = 0; j < filter && matching != 0; j++)
+		{
+			uint64_t shifted = j == 0 ? current : (current >> (j * 2)) | (next << (64 - j * 2));
+			uint64_t difference = shifted ^ repeated[filterCodes[j]];
+			matching &= ~(difference | (difference >> 1));
+		}
+		matching &= lowBits;
+
+		while (matching != 0)
+		{
+			size_t position = w * 32 + size_t(lowestBit(matching) / 2);
+			matching &= matching - 1;
+			if (position > lastStart)
+			{
+				break;
+			}
+
+			// Check the whole keyword, 32 bases at a time.
+			bool found = true;
+			for (size_t k = 0; k < keyWords.size(); k++)
+			{
+				size_t remaining = keyLength - k * 32;
+				uint64_t mask = remaining >= 32 ? ~uint64_t(0) : (uint64_t(1) << (remaining * 2)) - 1;
+				if ((window(position + k * 32) & mask) != keyWords[k])
+				{
+					found = false;
+					break;
+				}
+			}
+			if (found && !hasUnknown(position, position + keyLength))
+			{
+				results.push_back(position);
+			}
+		}
+	}
+
+	return results;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// DNA text stored with 2 bits per base instead of 8, 32 bases to a 64-bit word.
+// With only four letters the skip table in Boyer-Moore hardly ever lets it skip more than a character or two, so this search works the other way round:
+// it looks at all 32 starting positions in a word at the same time, comparing the first few bases of the keyword with bitwise operations,
+// and only checks the whole keyword at the positions that pass.
+//
+// The bases are coded as A = 0, C = 1, T = 2, G = 3, which is just bits 1 and 2 of the ASCII code, so upper and lower case pack the same way.
+// Line breaks are skipped so that a FASTA sequence split over several lines is searched as one sequence, and positions count bases rather than bytes.
+// Any other character (such as N for an unknown base) takes up a position but never matches.
+class PackedDNA
+{
+public:
+	// Constructor and destructor.
+	PackedDNA();
+	~PackedDNA();
+
+	// Packs a sequence, replacing whatever was packed before.
+	void pack(const char* t, size_t length);
+	void pack(const std::string& t) { pack(t.data(), t.length()); };
+
+	// Returns the position of every occurance of the keyword, counted in bases from the start of the sequence. A keyword with anything other than A, C, G or T in it is never found.
+	std::vector<size_t> search(const std::string& kw) const;
+
+	// The number of bases that were packed, including unknown ones.
+	size_t size() const { return bases; };
+
+	// The base at a position, as an upper case letter, or 'N' for an unknown base.
+	char baseAt(size_t i) const;
+
+	// The number of bytes used by the packed sequence.
+	size_t memoryUsage() const;
+
+protected:
+	// Adds 'count' bases, already coded as 2 bits each, to the end of the sequence.
+	void append(uint64_t codes, int count);
+
+	// Marks a base as unknown.
+	void markUnknown(size_t i);
+
+	// Returns the 32 bases starting at position i in one word, with the base at i in the lowest 2 bits.
+	uint64_t window(size_t i) const;
+
+	// Whether any base from 'from' up to but not including 'to' is unknown.
+	bool hasUnknown(size_t from, size_t to) const;
+
+	// The packed bases. There is always one more word than needed, so window() can read past the last base without checking.
+	std::vector<uint64_t> words;
+
+	// One bit per base, set for unknown bases. Left empty if there are none.
+	std::vector<uint64_t> unknown;
+
+	size_t bases;
+};
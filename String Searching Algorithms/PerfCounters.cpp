@@ -0,0 +1,129 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+
+// Opens one counter for this process on whichever CPU it runs on, stopped, and only counting user-mode work so that the kernel's share of a system call doesn't get in.
+// The counter also reports how long it was enabled and how long it was actually running, so the count can be scaled up if the kernel had to share the hardware between counters.
+static int openEvent(uint32_t type, uint64_t config)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+PerfCounters::PerfCounters()
+{
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		fds[e] = -1;
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+	close();
+}
+
+const char* PerfCounters::eventName(int event)
+{
+	static const char* names[perfEventCount] = { "Cycles", "Instructions", "Branch misses", "L1 misses", "LLC misses" };
+	return names[event];
+}
+
+bool PerfCounters::open()
+{
+	close();
+#ifdef __linux__
+	fds[PerfCycles] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	fds[PerfInstructions] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	fds[PerfBranchMisses] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	fds[PerfL1Misses] = openEvent(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	fds[PerfLLCMisses] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+	return isOpen();
+}
+
+void PerfCounters::close()
+{
+	for (int e = 0; e < perfEventCount; e++)
+	{
+#ifdef __linux__
+		if (fds[e] != -1)
+		{
+			::close(fds[e]);
+		}
+#endif
+		fds[e] = -1;
+	}
+}
+
+bool PerfCounters::isOpen() const
+{
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		if (fds[e] != -1)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		if (fds[e] != -1)
+		{
+			ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+}
+
+PerfSample PerfCounters::stop()
+{
+	PerfSample sample;
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		sample.counts[e] = 0;
+		sample.available[e] = false;
+	}
+
+#ifdef __linux__
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		if (fds[e] != -1)
+		{
+			ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		// The value, then the time enabled and the time running.
+		uint64_t values[3];
+		if (fds[e] == -1 || read(fds[e], values, sizeof(values)) != ssize_t(sizeof(values)) || values[2] == 0)
+		{
+			continue;
+		}
+		sample.counts[e] = values[2] < values[1] ? uint64_t(double(values[0]) * double(values[1]) / double(values[2])) : values[0];
+		sample.available[e] = true;
+	}
+#endif
+	return sample;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// The hardware events that PerfCounters can count.
+enum PerfEvent
+{
+	PerfCycles,
+	PerfInstructions,
+	PerfBranchMisses,
+	PerfL1Misses,
+	PerfLLCMisses,
+	perfEventCount
+};
+
+// The counts from one measurement. An event the machine couldn't count is marked as not available rather than given a count of 0.
+struct PerfSample
+{
+	uint64_t counts[perfEventCount];
+	bool available[perfEventCount];
+
+	// Instructions per cycle, or 0 if either wasn't counted.
+	double ipc() const
+	{
+		return available[PerfCycles] && available[PerfInstructions] && counts[PerfCycles] > 0 ? double(counts[PerfInstructions]) / double(counts[PerfCycles]) : 0;
+	};
+
+	// Whether anything at all was counted.
+	bool any() const
+	{
+		for (int e = 0; e < perfEventCount; e++)
+		{
+			if (available[e])
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+};
+
+// Counts CPU cycles, instructions, branch mispredictions, L1 data cache misses and last level cache misses between start() and stop(), using the Linux perf_event_open system call.
+// This shows why one search is faster than another where the time alone can't, such as whether it runs more instructions, or mispredicts more branches, or waits on the cache.
+// Only this process's own user-mode work is counted. On other systems, or where the kernel doesn't allow it (see /proc/sys/kernel/perf_event_paranoid, and most virtual machines),
+// open() returns false and every sample comes back with nothing available, so code that uses the counters doesn't need to check which system it's on.
+class PerfCounters
+{
+public:
+	// Constructor and destructor. The destructor closes any open counters.
+	PerfCounters();
+	~PerfCounters();
+
+	// Opens as many of the counters as the machine supports. Returns false if none of them could be opened.
+	bool open();
+	void close();
+	bool isOpen() const;
+
+	// Zeroes the counters and starts them, and stops them and reads them.
+	void start();
+	PerfSample stop();
+
+	// The name of an event, for the results.
+	static const char* eventName(int event);
+
+private:
+	// Copying would close the counters twice, so it isn't allowed.
+	PerfCounters(const PerfCounters&);
+	PerfCounters& operator=(const PerfCounters&);
+
+	// A file descriptor for each event, or -1 if it isn't open.
+	int fds[perfEventCount];
+};
@@ -0,0 +1,154 @@
+#include "ResultCache.h"
+#include "Varint.h"
+#include "RollingHash.h"
+
+// Roughly what the list and map pointers and the map's bucket take up for each entry, on top of the entry itself.
+static const size_t nodeOverhead = 64;
+
+size_t ResultCache::KeyHash::operator()(const Key& key) const
+{
+	uint64_t h = RollingHash::hashOf(key.pattern.data(), key.pattern.length());
+	h = (h ^ key.version) * RollingHash::multiplier + key.mode;
+	return size_t(h ^ (h >> 32));
+}
+
+ResultCache::ResultCache(size_t memoryBudget)
+{
+	budget = memoryBudget;
+	used = 0;
+	hits = 0;
+	misses = 0;
+	evictions = 0;
+	invalidations = 0;
+}
+
+ResultCache::~ResultCache()
+{
+}
+
+void ResultCache::setBudget(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	budget = bytes;
+	trim();
+}
+
+bool ResultCache::find(uint64_t version, const std::string& pattern, uint8_t mode, std::vector<uint64_t>& offsets, uint64_t& count)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	if (budget == 0)
+	{
+		return false;
+	}
+
+	Key key = { version, mode, pattern };
+	auto found = index.find(key);
+	if (found == index.end())
+	{
+		misses++;
+		return false;
+	}
+	hits++;
+
+	// Move it to the front of the list, since it's now the most recently used.
+	entries.splice(entries.begin(), entries, found->second);
+	const Entry& entry = *found->second;
+
+	count = entry.count;
+	offsets.clear();
+	size_t position = 0;
+	uint64_t gap;
+	uint64_t offset = 0;
+	while (readVarint(entry.packed.data(), entry.packed.length(), position, gap))
+	{
+		offset += gap;
+		offsets.push_back(offset);
+	}
+	return true;
+}
+
+void ResultCache::insert(uint64_t version, const std::string& pattern, uint8_t mode, const std::vector<uint64_t>& offsets, uint64_t count)
+{
+	// Pack the results before locking, so other threads aren't kept waiting. The offsets are in order, so the gaps are never negative.
+	Entry entry;
+	entry.key = { version, mode, pattern };
+	entry.count = count;
+	uint64_t previous = 0;
+	for (uint64_t offset : offsets)
+	{
+		appendVarint(entry.packed, offset - previous);
+		previous = offset;
+	}
+	entry.packed.shrink_to_fit();
+	entry.bytes = sizeof(Entry) + nodeOverhead + pattern.length() + entry.packed.length();
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	if (entry.bytes > budget)
+	{
+		return;
+	}
+
+	// Another thread may have searched for the same thing at the same time. Its results are the same, so just keep the one that's there.
+	if (index.find(entry.key) != index.end())
+	{
+		return;
+	}
+
+	used += entry.bytes;
+	entries.push_front(std::move(entry));
+	index[entries.front().key] = entries.begin();
+	trim();
+}
+
+size_t ResultCache::invalidate(uint64_t version)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	size_t removed = 0;
+	for (auto entry = entries.begin(); entry != entries.end(); )
+	{
+		if (entry->key.version == version)
+		{
+			used -= entry->bytes;
+			index.erase(entry->key);
+			entry = entries.erase(entry);
+			removed++;
+		}
+		else
+		{
+			++entry;
+		}
+	}
+	invalidations += removed;
+	return removed;
+}
+
+void ResultCache::clear()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	index.clear();
+	entries.clear();
+	used = 0;
+	hits = 0;
+	misses = 0;
+	evictions = 0;
+	invalidations = 0;
+}
+
+CacheStats ResultCache::getStats()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	CacheStats stats = { hits, misses, evictions, invalidations, entries.size(), used, budget };
+	return stats;
+}
+
+void ResultCache::trim()
+{
+	while (used > budget && !entries.empty())
+	{
+		Entry& oldest = entries.back();
+		used -= oldest.bytes;
+		index.erase(oldest.key);
+		entries.pop_back();
+		evictions++;
+	}
+}
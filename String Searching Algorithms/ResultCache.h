@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// How well a ResultCache is doing.
+struct CacheStats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t invalidations;
+	size_t entries;
+	size_t bytes;
+	size_t budget;
+
+	double hitRate() const { return hits + misses > 0 ? double(hits) / double(hits + misses) : 0; };
+};
+
+// Remembers the results of recent searches, so that a keyword that is searched for again and again in a text that hasn't changed is only searched for once.
+// Results are looked up by the version of the text (a hash of its contents, so any change to the text gives it a new version), the keyword, and the search options.
+// The match positions are kept as the gaps between them in variable length integers (see Varint.h), which is usually one or two bytes a match instead of eight.
+//
+// The cache has a memory budget. When it's full, the results that haven't been used for the longest are thrown away to make room (least recently used).
+// The memory counted for each entry is its keyword, its packed results and a fixed amount for the lists and maps that keep track of it, so it's close but not exact.
+// It's safe to use from several threads at once.
+class ResultCache
+{
+public:
+	// Constructor and destructor.
+	ResultCache(size_t memoryBudget = size_t(64) << 20);
+	~ResultCache();
+
+	// Changes the memory budget, throwing away entries if it's now over. A budget of 0 turns the cache off.
+	void setBudget(size_t bytes);
+	size_t getBudget() const { return budget; };
+
+	// Looks up the results of a search. Returns false if they aren't in the cache, otherwise fills in the match positions and the number of matches.
+	bool find(uint64_t version, const std::string& pattern, uint8_t mode, std::vector<uint64_t>& offsets, uint64_t& count);
+
+	// Adds the results of a search. Results that are bigger than the whole budget aren't kept.
+	void insert(uint64_t version, const std::string& pattern, uint8_t mode, const std::vector<uint64_t>& offsets, uint64_t count);
+
+	// Throws away every entry for a version of a text, for when the text has been changed. Returns the number of entries thrown away.
+	size_t invalidate(uint64_t version);
+
+	// Throws away every entry and resets the statistics.
+	void clear();
+
+	CacheStats getStats();
+
+protected:
+	// What a search is looked up by.
+	struct Key
+	{
+		uint64_t version;
+		uint8_t mode;
+		std::string pattern;
+
+		bool operator==(const Key& other) const { return version == other.version && mode == other.mode && pattern == other.pattern; };
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	// The results of one search: the number of matches, and the gaps between them packed into variable length integers.
+	struct Entry
+	{
+		Key key;
+		uint64_t count;
+		std::string packed;
+		size_t bytes;
+	};
+
+	// Throws away the least recently used entries until the cache is within its budget. The mutex must already be locked.
+	void trim();
+
+	// Most recently used first, and a map from each key to its place in the list.
+	std::list<Entry> entries;
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+	std::mutex cacheMutex;
+
+	size_t budget;
+	size_t used;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t invalidations;
+};
@@ -0,0 +1,179 @@
+#include "ResultFile.h"
+#include "Varint.h"
+#include <cstring>
+
+static const char resultMagic[4] = { 'S', 'S', 'R', 'B' };
+static const uint16_t resultVersion = 1;
+
+// The header is the magic bytes, the version, 2 reserved bytes, the number of keywords and the text length.
+static const size_t headerSize = 4 + 2 + 2 + 4 + 8;
+
+ResultWriter::ResultWriter()
+{
+	patternCount = 0;
+}
+
+ResultWriter::~ResultWriter()
+{
+	close();
+}
+
+bool ResultWriter::open(const std::string& filename, uint64_t textBytes)
+{
+	close();
+	file.open(filename, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	patternCount = 0;
+	uint16_t reserved = 0;
+	file.write(resultMagic, sizeof(resultMagic));
+	file.write(reinterpret_cast<const char*>(&resultVersion), sizeof(resultVersion));
+	file.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+	file.write(reinterpret_cast<const char*>(&patternCount), sizeof(patternCount));
+	file.write(reinterpret_cast<const char*>(&textBytes), sizeof(textBytes));
+	return bool(file);
+}
+
+template <typename T>
+void ResultWriter::writeGroup(int pattern, const std::string& keyword, const std::vector<T>& offsets)
+{
+	buffer.clear();
+	appendVarint(buffer, uint64_t(pattern));
+	appendVarint(buffer, keyword.length());
+	buffer += keyword;
+	appendVarint(buffer, offsets.size());
+
+	// Store the gap from the previous match rather than the position itself, since the gaps are much smaller numbers.
+	uint64_t previous = 0;
+	for (const T& offset : offsets)
+	{
+		appendVarint(buffer, uint64_t(offset) - previous);
+		previous = uint64_t(offset);
+	}
+
+	file.write(buffer.data(), buffer.size());
+	patternCount++;
+}
+
+void ResultWriter::writePattern(int pattern, const std::string& keyword, const std::vector<size_t>& offsets)
+{
+	writeGroup(pattern, keyword, offsets);
+}
+
+void ResultWriter::writePattern(int pattern, const std::string& keyword, const std::vector<int>& offsets)
+{
+	writeGroup(pattern, keyword, offsets);
+}
+
+bool ResultWriter::close()
+{
+	if (!file.is_open())
+	{
+		return true;
+	}
+
+	// The number of keywords isn't known until the end, so go back and fill it in.
+	file.seekp(8);
+	file.write(reinterpret_cast<const char*>(&patternCount), sizeof(patternCount));
+	bool written = bool(file);
+	file.close();
+	return written && !file.fail();
+}
+
+ResultReader::ResultReader()
+{
+	position = 0;
+	patternCount = 0;
+	textBytes = 0;
+}
+
+ResultReader::~ResultReader()
+{
+}
+
+bool ResultReader::open(const std::string& filename)
+{
+	if (!file.open(filename))
+	{
+		return false;
+	}
+	const char* data = file.data();
+
+	uint16_t version;
+	if (file.size() < headerSize || memcmp(data, resultMagic, sizeof(resultMagic)) != 0)
+	{
+		return false;
+	}
+	memcpy(&version, data + 4, sizeof(version));
+	if (version != resultVersion)
+	{
+		return false;
+	}
+	memcpy(&patternCount, data + 8, sizeof(patternCount));
+	memcpy(&textBytes, data + 12, sizeof(textBytes));
+	position = headerSize;
+	return true;
+}
+
+bool ResultReader::next(ResultGroup& group)
+{
+	const char* data = file.data();
+	size_t size = file.size();
+	uint64_t pattern, length, count;
+	if (!readVarint(data, size, position, pattern) || !readVarint(data, size, position, length) || length > size - position)
+	{
+		return false;
+	}
+	group.pattern = int(pattern);
+	group.keyword.assign(data + position, size_t(length));
+	position += size_t(length);
+
+	if (!readVarint(data, size, position, count))
+	{
+		return false;
+	}
+
+	// Add the gaps back up to get the positions.
+	group.offsets.clear();
+	uint64_t offset = 0;
+	for (uint64_t i = 0; i < count; i++)
+	{
+		uint64_t gap;
+		if (!readVarint(data, size, position, gap))
+		{
+			return false;
+		}
+		offset += gap;
+		group.offsets.push_back(offset);
+	}
+	return true;
+}
+
+bool convertResultsToCSV(const std::string& binaryFile, const std::string& csvFile)
+{
+	ResultReader reader;
+	if (!reader.open(binaryFile))
+	{
+		return false;
+	}
+	std::ofstream csv(csvFile);
+	if (!csv)
+	{
+		return false;
+	}
+
+	ResultGroup group;
+	while (reader.next(group))
+	{
+		csv << "Word, Position\n";
+		for (uint64_t offset : group.offsets)
+		{
+			csv << "'" << group.keyword << "'," << offset << "\n";
+		}
+		csv << "Occurances:," << group.offsets.size() << "\n\n";
+	}
+	return true;
+}
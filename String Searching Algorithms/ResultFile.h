@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include "MappedFile.h"
+
+// A compact binary file of match positions, for result sets that are too big for one CSV line per match.
+// The file starts with a small header: the magic bytes 'SSRB', a version number, the number of keywords in the file and the length of the text that was searched.
+// After that each keyword has a group: its index, its length and text, the number of matches, then the match positions.
+// All of the numbers are varints, and each position is stored as the gap from the one before it, so a dense set of matches takes one or two bytes per match.
+class ResultWriter
+{
+public:
+	// Constructor and destructor. The destructor closes the file if it's still open.
+	ResultWriter();
+	~ResultWriter();
+
+	// Creates the file and writes the header. Returns false if the file couldn't be created.
+	bool open(const std::string& filename, uint64_t textBytes);
+
+	// Adds a keyword's matches to the file. The positions must be in order.
+	void writePattern(int pattern, const std::string& keyword, const std::vector<size_t>& offsets);
+	void writePattern(int pattern, const std::string& keyword, const std::vector<int>& offsets);
+
+	// Fills in the number of keywords in the header and closes the file. Returns false if any of the file couldn't be written.
+	bool close();
+
+	bool isOpen() const { return file.is_open(); };
+	uint32_t getPatternCount() const { return patternCount; };
+
+protected:
+	// Encodes and writes one group.
+	template <typename T>
+	void writeGroup(int pattern, const std::string& keyword, const std::vector<T>& offsets);
+
+	std::ofstream file;
+	uint32_t patternCount;
+
+	// Reused between groups so that a new buffer isn't needed for every keyword.
+	std::string buffer;
+};
+
+// A keyword's matches, as read back from a result file.
+struct ResultGroup
+{
+	int pattern;
+	std::string keyword;
+	std::vector<uint64_t> offsets;
+};
+
+// Reads a file written by ResultWriter one group at a time.
+class ResultReader
+{
+public:
+	// Constructor and destructor.
+	ResultReader();
+	~ResultReader();
+
+	// Opens the file and checks the header. Returns false if it's missing or isn't a result file.
+	bool open(const std::string& filename);
+
+	// Reads the next keyword's matches. Returns false at the end of the file.
+	bool next(ResultGroup& group);
+
+	uint32_t getPatternCount() const { return patternCount; };
+	uint64_t getTextBytes() const { return textBytes; };
+
+protected:
+	// The file is mapped rather than read in, so a large result file can be read without loading all of it first.
+	MappedFile file;
+	size_t position;
+	uint32_t patternCount;
+	uint64_t textBytes;
+};
+
+// Converts a binary result file back into the same 'Word, Position' CSV layout used by results.csv. Returns false if either file couldn't be opened.
+bool convertResultsToCSV(const std::string& binaryFile, const std::string& csvFile);
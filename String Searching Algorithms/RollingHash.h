@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Polynomial rolling hash over a fixed-size window, 'H = c1a^k-1 + c2a^k-2 + ... + cka^0', worked out modulo 2^64 so that the overflow of an unsigned 64-bit integer does the modulo for free.
+// Unlike the simple sum used in StringSearch::hash(), the multiplier means that the order of the characters matters, so anagrams like "stop" and "pots" don't collide.
+// Rolling the hash forward by one character is O(1): take away the character leaving the window and add the one entering it.
+class RollingHash
+{
+public:
+	// The multiplier. It's odd so that it can't lose information modulo 2^64.
+	static const uint64_t multiplier = 0x100000001B3ULL;
+
+	// Constructor. The window size is the number of characters the hash covers.
+	RollingHash(size_t windowSize = 1)
+	{
+		setWindow(windowSize);
+	}
+
+	// Changes the window size, and works out a^k, which is needed to remove the oldest character from the hash.
+	void setWindow(size_t windowSize)
+	{
+		window = windowSize;
+		removeFactor = 1;
+		for (size_t i = 0; i < window; i++)
+		{
+			removeFactor *= multiplier;
+		}
+		h = 0;
+	}
+
+	// Hashes the first window of characters starting at s.
+	uint64_t init(const char* s)
+	{
+		h = hashOf(s, window);
+		return h;
+	}
+
+	// Moves the window one character forward. 'out' is the character leaving the window and 'in' is the character entering it.
+	// This is the same as (h - out * a^(k-1)) * a + in, but written so that the only thing waiting on the previous hash is one multiply and one add,
+	// which matters when the hash is rolled over every byte of a large file.
+	uint64_t roll(unsigned char out, unsigned char in)
+	{
+		h = h * multiplier + (in - out * removeFactor);
+		return h;
+	}
+
+	uint64_t value() const { return h; };
+	size_t getWindow() const { return window; };
+
+	// Hashes a whole string. Gives the same value as init() for the same characters.
+	static uint64_t hashOf(const char* s, size_t length)
+	{
+		uint64_t result = 0;
+		for (size_t i = 0; i < length; i++)
+		{
+			result = result * multiplier + (unsigned char)s[i];
+		}
+		return result;
+	}
+
+private:
+	uint64_t h;
+	uint64_t removeFactor;
+	size_t window;
+};
@@ -0,0 +1,236 @@
+#include "ScalingBenchmark.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <set>
+#include <utility>
+#include "StringSearch.h"
+#include "CompiledPattern.h"
+#include "DoubleArrayTrie.h"
+#include "TeddyPrefilter.h"
+#include "PackedDNA.h"
+#include "MatchRange.h"
+
+using the_clock = std::chrono::steady_clock;
+
+// The searches that are timed, in the order they appear in the results.
+static const char* algorithmNames[] = { "Boyer-Moore", "Rabin-Karp", "Compiled Boyer-Moore", "Aho-Corasick", "Teddy", "Packed DNA" };
+static const int algorithmCount = 6;
+
+ScalingBenchmark::ScalingBenchmark()
+{
+	smallestText = size_t(1) << 10;
+	largestText = size_t(1) << 30;
+	shortestPattern = 1;
+	longestPattern = 1024;
+	minimumTime = 20;
+	timeLimit = 2000;
+	progress = true;
+}
+
+ScalingBenchmark::~ScalingBenchmark()
+{
+}
+
+bool ScalingBenchmark::setCounters(bool on)
+{
+	if (!on)
+	{
+		counters.close();
+		return false;
+	}
+	return counters.open();
+}
+
+double ScalingBenchmark::measure(const std::function<size_t()>& search, size_t& matches, PerfSample& sample)
+{
+	int runs = 0;
+	double elapsed = 0;
+	counters.start();
+	the_clock::time_point start = the_clock::now();
+	do
+	{
+		matches = search();
+		runs++;
+		elapsed = std::chrono::duration<double, std::milli>(the_clock::now() - start).count();
+	} while (elapsed < minimumTime);
+	sample = counters.stop();
+
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		sample.counts[e] /= runs;
+	}
+	return elapsed / runs;
+}
+
+bool ScalingBenchmark::run(const std::string& csvFile)
+{
+	std::ofstream csv(csvFile);
+	if (!csv)
+	{
+		return false;
+	}
+	csv << "Corpus,Algorithm,Text bytes,Pattern length,Matches,Time (ms),Throughput (MB/s)";
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		csv << "," << PerfCounters::eventName(e);
+	}
+	csv << ",IPC\n";
+	results.clear();
+
+	const std::vector<CorpusSetting> corpora = {
+		{ CorpusKind::Uniform, 2, "Uniform (2 letters)" },
+		{ CorpusKind::Uniform, 26, "Uniform (26 letters)" },
+		{ CorpusKind::Uniform, 256, "Uniform (256 bytes)" },
+		{ CorpusKind::Zipf, 0, "Zipf English" },
+		{ CorpusKind::DNA, 0, "DNA" },
+		{ CorpusKind::Periodic, 4096, "Periodic" }
+	};
+
+	CorpusGenerator generator;
+	StringSearch stringSearcher;
+	for (const CorpusSetting& corpus : corpora)
+	{
+		std::string largest = generator.generate(corpus.kind, largestText, corpus.alphabet);
+
+		// One keyword of each length for the whole sweep, so every size is searched for the same thing.
+		std::vector<std::string> patterns;
+		for (size_t length = shortestPattern; length <= longestPattern; length *= 2)
+		{
+			patterns.push_back(generator.pattern(corpus.kind, largest, length));
+		}
+
+		// The algorithm and keyword length pairs that went over the time limit on a smaller text.
+		std::set<std::pair<int, size_t>> givenUp;
+
+		// The sizes go up by 4 times each step, finishing with the largest size even if it isn't a power of 4 times the smallest.
+		std::vector<size_t> sizes;
+		for (size_t size = smallestText; size < largestText; size *= 4)
+		{
+			sizes.push_back(size);
+		}
+		sizes.push_back(largestText);
+
+		for (size_t size : sizes)
+		{
+			if (progress)
+			{
+				std::cout << corpus.name << ": " << size << " bytes\n";
+			}
+
+			// The original searches take the text as a std::string, so make one of the right size. The largest size is the generated text itself.
+			std::string prefix;
+			if (size < largest.length())
+			{
+				prefix.assign(largest, 0, size);
+			}
+			const std::string& text = size < largest.length() ? prefix : largest;
+
+			PackedDNA dna;
+			if (corpus.kind == CorpusKind::DNA)
+			{
+				dna.pack(text);
+			}
+
+			for (const std::string& kw : patterns)
+			{
+				if (kw.length() > size)
+				{
+					continue;
+				}
+
+				// Build each algorithm's tables before the timing starts, as a program searching the same keyword many times would.
+				CompiledPattern pattern(kw);
+				DoubleArrayTrie automaton;
+				automaton.build({ kw });
+				TeddyPrefilter teddy;
+				bool teddyBuilt = teddy.build({ kw });
+				std::vector<MultiMatch> multiMatches;
+
+				for (int a = 0; a < algorithmCount; a++)
+				{
+					if (givenUp.count(std::make_pair(a, kw.length())) != 0 || (a == 4 && !teddyBuilt) || (a == 5 && corpus.kind != CorpusKind::DNA))
+					{
+						continue;
+					}
+
+					std::function<size_t()> search;
+					switch (a)
+					{
+					case 0:
+						search = [&]() { return stringSearcher.searchBoyerMoore(kw, text).size(); };
+						break;
+					case 1:
+						search = [&]() { return stringSearcher.searchRabinKarp(kw, text).size(); };
+						break;
+					case 2:
+						search = [&]()
+						{
+							size_t count = 0;
+							for (size_t position : MatchRange(pattern, text.data(), text.length()))
+							{
+								(void)position;
+								count++;
+							}
+							return count;
+						};
+						break;
+					case 3:
+						search = [&]()
+						{
+							size_t count = 0;
+							for (const MultiMatch& match : MultiMatchRange(automaton, text.data(), text.length()))
+							{
+								(void)match;
+								count++;
+							}
+							return count;
+						};
+						break;
+					case 4:
+						search = [&]()
+						{
+							multiMatches.clear();
+							teddy.search(text.data(), text.length(), multiMatches);
+							return multiMatches.size();
+						};
+						break;
+					default:
+						search = [&]() { return dna.search(kw).size(); };
+						break;
+					}
+
+					size_t matches = 0;
+					PerfSample sample;
+					double ms = measure(search, matches, sample);
+					if (ms > timeLimit)
+					{
+						givenUp.insert(std::make_pair(a, kw.length()));
+					}
+
+					ScalingResult result = { corpus.name, algorithmNames[a], size, kw.length(), matches, ms, ms > 0 ? double(size) / (1 << 20) / (ms / 1000) : 0, sample };
+					results.push_back(result);
+					csv << result.corpus << "," << result.algorithm << "," << result.textBytes << "," << result.patternLength << "," << result.matches << "," << result.milliseconds << "," << result.megabytesPerSecond;
+
+					// An event the machine couldn't count is left empty, so it isn't mistaken for a count of 0.
+					for (int e = 0; e < perfEventCount; e++)
+					{
+						csv << ",";
+						if (sample.available[e])
+						{
+							csv << sample.counts[e];
+						}
+					}
+					csv << ",";
+					if (sample.ipc() > 0)
+					{
+						csv << sample.ipc();
+					}
+					csv << "\n";
+				}
+			}
+			csv.flush();
+		}
+	}
+	return bool(csv);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include "CorpusGenerator.h"
+#include "PerfCounters.h"
+
+// One timing from the scaling benchmark.
+struct ScalingResult
+{
+	std::string corpus;
+	std::string algorithm;
+	size_t textBytes;
+	size_t patternLength;
+	size_t matches;
+	double milliseconds;
+	double megabytesPerSecond;
+
+	// The hardware counts for one search, if they were collected.
+	PerfSample counters;
+};
+
+// Times every single keyword search on generated texts, over a range of text sizes and keyword lengths, to show how each one scales.
+// The texts are uniform random text with 2, 26 and 256 different characters, Zipf-distributed English-like words, DNA, and the periodic worst case.
+// Text sizes go up by a factor of 4 from the smallest up to the largest, and keyword lengths double from the shortest to the longest.
+// Each text is made once at the largest size, and the smaller sizes are taken from the start of it.
+//
+// Small texts are searched over and over until enough time has passed to measure, and the average is recorded. A search that takes longer than the time limit
+// on one size isn't run on the bigger sizes with the same text and keyword length, so that the worst cases don't hold up the rest of the sweep.
+// Every result is written to a CSV file as soon as it's measured, so the curves can be plotted from it (throughput against text size or keyword length).
+class ScalingBenchmark
+{
+public:
+	// Constructor and destructor.
+	ScalingBenchmark();
+	~ScalingBenchmark();
+
+	// The range of text sizes, in bytes, and of keyword lengths.
+	void setTextSizes(size_t smallest, size_t largest) { smallestText = smallest; largestText = largest; };
+	void setPatternLengths(size_t shortest, size_t longest) { shortestPattern = shortest; longestPattern = longest; };
+
+	// How long to keep repeating a search on a small text, and how long a single search can take before the larger sizes are skipped, both in milliseconds.
+	void setMinimumTime(double ms) { minimumTime = ms; };
+	void setTimeLimit(double ms) { timeLimit = ms; };
+
+	// Whether to print a line to the console as each text size is started.
+	void setProgress(bool show) { progress = show; };
+
+	// Whether to count cycles, instructions, branch mispredictions and cache misses for each search as well as timing it. They're added to the CSV file if the machine
+	// allows it, and the columns are left empty if it doesn't. Returns whether any of the counters could be opened.
+	bool setCounters(bool on);
+
+	// Runs the whole sweep and writes the results to a CSV file. Returns false if the file couldn't be created.
+	bool run(const std::string& csvFile);
+
+	const std::vector<ScalingResult>& getResults() const { return results; };
+
+protected:
+	// A text to generate, and the name it's given in the results.
+	struct CorpusSetting
+	{
+		CorpusKind kind;
+		int alphabet;
+		std::string name;
+	};
+
+	// Times a search, repeating it until minimumTime has passed. Returns the average time of one search, and sets 'matches' to the number of matches it found
+	// and 'sample' to the average hardware counts of one search.
+	double measure(const std::function<size_t()>& search, size_t& matches, PerfSample& sample);
+
+	size_t smallestText;
+	size_t largestText;
+	size_t shortestPattern;
+	size_t longestPattern;
+	double minimumTime;
+	double timeLimit;
+	bool progress;
+	PerfCounters counters;
+
+	std::vector<ScalingResult> results;
+};
@@ -0,0 +1,130 @@
+#include "ScatterWriter.h"
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#include <algorithm>
+
+// The most slices one writev() call will take. POSIX only promises 16, but IOV_MAX is normally 1024.
+#ifdef IOV_MAX
+static const size_t maxSlices = IOV_MAX;
+#else
+static const size_t maxSlices = 16;
+#endif
+#endif
+
+ScatterWriter::ScatterWriter()
+{
+	bytesWritten = 0;
+#ifndef _WIN32
+	fd = -1;
+#endif
+}
+
+ScatterWriter::~ScatterWriter()
+{
+	close();
+}
+
+bool ScatterWriter::open(const std::string& filename)
+{
+	close();
+	bytesWritten = 0;
+#ifdef _WIN32
+	file.open(filename, std::ios::binary | std::ios::trunc);
+	return file.is_open();
+#else
+	fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	return fd != -1;
+#endif
+}
+
+void ScatterWriter::close()
+{
+#ifdef _WIN32
+	if (file.is_open())
+	{
+		file.close();
+	}
+#else
+	if (fd != -1)
+	{
+		::close(fd);
+		fd = -1;
+	}
+#endif
+}
+
+bool ScatterWriter::isOpen() const
+{
+#ifdef _WIN32
+	return file.is_open();
+#else
+	return fd != -1;
+#endif
+}
+
+bool ScatterWriter::write(const std::vector<OutputSlice>& slices)
+{
+	if (!isOpen())
+	{
+		return false;
+	}
+
+#ifdef _WIN32
+	for (const OutputSlice& slice : slices)
+	{
+		file.write(slice.data, std::streamsize(slice.length));
+		bytesWritten += slice.length;
+	}
+	return bool(file);
+#else
+	std::vector<iovec> vectors;
+	vectors.reserve(std::min(slices.size(), maxSlices));
+	size_t next = 0;
+	while (next < slices.size())
+	{
+		// Fill the next batch, leaving out empty slices.
+		vectors.clear();
+		while (next < slices.size() && vectors.size() < maxSlices)
+		{
+			if (slices[next].length > 0)
+			{
+				vectors.push_back(iovec{ const_cast<char*>(slices[next].data), slices[next].length });
+			}
+			next++;
+		}
+
+		// writev() can stop part way through, for example if it's interrupted by a signal, so carry on from wherever it got to.
+		size_t first = 0;
+		while (first < vectors.size())
+		{
+			ssize_t written = ::writev(fd, vectors.data() + first, int(vectors.size() - first));
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			bytesWritten += size_t(written);
+			size_t left = size_t(written);
+			while (first < vectors.size() && left >= vectors[first].iov_len)
+			{
+				left -= vectors[first].iov_len;
+				first++;
+			}
+			if (first < vectors.size())
+			{
+				vectors[first].iov_base = static_cast<char*>(vectors[first].iov_base) + left;
+				vectors[first].iov_len -= left;
+			}
+		}
+	}
+	return true;
+#endif
+}
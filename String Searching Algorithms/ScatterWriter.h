@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#ifdef _WIN32
+#include <fstream>
+#endif
+
+// A piece of output: a pointer to some bytes that already exist somewhere else, and how many of them to write.
+struct OutputSlice
+{
+	const char* data;
+	size_t length;
+};
+
+// Writes a list of slices to a file as if they were one block, without copying them together first.
+// On Linux and other POSIX systems the whole list is handed to a single writev() call (split up only if it has more slices than the system allows in one call),
+// so the kernel gathers the slices straight from wherever they are. Windows has no writev() for ordinary files, so there the slices are written one after another
+// through a buffered stream instead.
+class ScatterWriter
+{
+public:
+	// Constructor and destructor. The destructor closes the file if it's still open.
+	ScatterWriter();
+	~ScatterWriter();
+
+	// Creates the file, replacing it if it already exists. Returns false if it couldn't be created.
+	bool open(const std::string& filename);
+
+	// Writes the slices in order. Returns false if the write failed.
+	bool write(const std::vector<OutputSlice>& slices);
+
+	void close();
+	bool isOpen() const;
+
+	// The number of bytes written since the file was opened.
+	size_t getBytesWritten() const { return bytesWritten; };
+
+private:
+	// Copying would close the file twice, so it isn't allowed.
+	ScatterWriter(const ScatterWriter&);
+	ScatterWriter& operator=(const ScatterWriter&);
+
+	size_t bytesWritten;
+
+#ifdef _WIN32
+	std::ofstream file;
+#else
+	int fd;
+#endif
+};
@@ -0,0 +1,688 @@
+#include "SearchServer.h"
+#include "task.h"
+#include "ThreadArena.h"
+#include "RollingHash.h"
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using the_clock = std::chrono::steady_clock;
+
+static const uint32_t requestMagic = 0x31515353;	// 'SSQ1'
+static const uint32_t responseMagic = 0x31525353;	// 'SSR1'
+static const uint32_t shutdownCount = 0xFFFFFFFF;
+
+// The most queries in one batch and the longest keyword the server will read. A client that sends more is disconnected,
+// so that a bad header can't make the server try to allocate gigabytes for it.
+static const uint32_t maxBatchQueries = 65536;
+static const uint32_t maxPatternLength = 1 << 20;
+
+// The most compiled patterns kept at once. When the cache is full it's emptied and starts again.
+static const size_t maxCachedPatterns = 4096;
+
+// Counts down as the queries in a batch finish, so that the connection thread knows when it can send the responses.
+struct BatchLatch
+{
+	std::mutex latchMutex;
+	std::condition_variable finished;
+	int remaining;
+};
+
+// A task that runs a single query from a batch on a worker thread.
+class QueryTask :
+	public Task
+{
+public:
+	QueryTask(SearchServer* s, const SearchQuery* q, SearchResponse* r, BatchLatch* l)
+	{
+		server = s;
+		query = q;
+		response = r;
+		latch = l;
+	};
+
+	void run()
+	{
+		server->runQuery(*query, *response);
+
+		std::lock_guard<std::mutex> lock(latch->latchMutex);
+		latch->remaining--;
+		if (latch->remaining == 0)
+		{
+			latch->finished.notify_one();
+		}
+	};
+
+private:
+	SearchServer* server;
+	const SearchQuery* query;
+	SearchResponse* response;
+	BatchLatch* latch;
+};
+
+// Helpers for building and reading the messages. Integers are copied in the machine's byte order, which is little-endian on every platform this runs on.
+static void put32(std::string& out, uint32_t value)
+{
+	out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void put64(std::string& out, uint64_t value)
+{
+	out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+#ifndef _WIN32
+// Sockets can return less than was asked for, so these keep going until everything has been sent or received.
+static bool readAll(int s, void* buffer, size_t length)
+{
+	char* p = static_cast<char*>(buffer);
+	while (length > 0)
+	{
+		ssize_t got = ::read(s, p, length);
+		if (got <= 0)
+		{
+			return false;
+		}
+		p += got;
+		length -= size_t(got);
+	}
+	return true;
+}
+
+static bool writeAll(int s, const void* buffer, size_t length)
+{
+	const char* p = static_cast<const char*>(buffer);
+	while (length > 0)
+	{
+		ssize_t sent = ::write(s, p, length);
+		if (sent <= 0)
+		{
+			return false;
+		}
+		p += sent;
+		length -= size_t(sent);
+	}
+	return true;
+}
+
+// Opens a client connection to the server's socket.
+static int connectTo(const std::string& socketPath)
+{
+	int s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s < 0)
+	{
+		return -1;
+	}
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+	if (connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		::close(s);
+		return -1;
+	}
+	return s;
+}
+#endif
+
+SearchServer::SearchServer()
+{
+	running = false;
+	listenSocket = -1;
+	useArena = true;
+}
+
+SearchServer::~SearchServer()
+{
+	stop();
+	pool.stop();
+}
+
+// A hash of a corpus's contents and length, used as its version.
+static uint64_t contentVersion(const MappedFile& file)
+{
+	return RollingHash::hashOf(file.data(), file.size()) * RollingHash::multiplier + file.size();
+}
+
+// Reads a file's size, modification time and serial number without opening it. Returns false if the file isn't there.
+static bool readStamp(const std::string& path, uint64_t& size, int64_t& modified, uint64_t& file)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(path.c_str(), &info) != 0)
+	{
+		return false;
+	}
+	modified = int64_t(info.st_mtime) * 1000000000;
+#else
+	struct stat info;
+	if (::stat(path.c_str(), &info) != 0)
+	{
+		return false;
+	}
+#ifdef __linux__
+	modified = int64_t(info.st_mtim.tv_sec) * 1000000000 + int64_t(info.st_mtim.tv_nsec);
+#else
+	modified = int64_t(info.st_mtime) * 1000000000;
+#endif
+#endif
+	size = uint64_t(info.st_size);
+	file = uint64_t(info.st_ino);
+	return true;
+}
+
+bool SearchServer::addCorpus(const std::string& name, const std::string& filename)
+{
+	std::unique_ptr<Corpus> corpus(new Corpus());
+	corpus->name = name;
+	corpus->path = filename;
+
+	// The stamp is read before the file is mapped, so a change made in between makes the stamp out of date and the file is mapped again on the next query.
+	FileStamp& stamp = corpus->stamp;
+	if (!readStamp(filename, stamp.size, stamp.modified, stamp.file) || !corpus->file.open(filename))
+	{
+		return false;
+	}
+	corpus->version = contentVersion(corpus->file);
+	corpora.push_back(std::move(corpus));
+	return true;
+}
+
+uint64_t SearchServer::getCorpusVersion(int i) const
+{
+	Corpus& corpus = *corpora[i];
+	std::shared_lock<std::shared_timed_mutex> reading(corpus.corpusMutex);
+	return corpus.version;
+}
+
+bool SearchServer::reloadCorpus(int i)
+{
+	return reload(i, false);
+}
+
+bool SearchServer::reload(int i, bool onlyIfChanged)
+{
+	Corpus& corpus = *corpora[i];
+	FileStamp stamp;
+	bool found = readStamp(corpus.path, stamp.size, stamp.modified, stamp.file);
+
+	// Checking the stamp is cheap and most of the time it hasn't changed, so that's done with only a read lock, letting other queries search at the same time.
+	if (onlyIfChanged)
+	{
+		std::shared_lock<std::shared_timed_mutex> reading(corpus.corpusMutex);
+		if (!found || stamp == corpus.stamp)
+		{
+			return found;
+		}
+	}
+
+	// Several queries can notice the change at once, so once the locks are held, check whether one of the others has already mapped it again.
+	std::lock_guard<std::mutex> reloading(reloadMutex);
+	std::unique_lock<std::shared_timed_mutex> writing(corpus.corpusMutex);
+	found = readStamp(corpus.path, stamp.size, stamp.modified, stamp.file);
+	if (onlyIfChanged && found && stamp == corpus.stamp)
+	{
+		return true;
+	}
+
+	// If the file can't be mapped, the corpus is left empty and gets the version of an empty file, so that its old results aren't given out either.
+	uint64_t oldVersion = corpus.version;
+	corpus.file.close();
+	bool opened = found && corpus.file.open(corpus.path);
+	if (found)
+	{
+		corpus.stamp = stamp;
+	}
+	corpus.version = contentVersion(corpus.file);
+
+	// Another corpus could have exactly the same contents, and its results are still right, so only throw them away if no other corpus has the old version.
+	// Versions are only changed while reloadMutex is held, so the other corpora's versions can be read here without locking them.
+	bool stillUsed = false;
+	for (const std::unique_ptr<Corpus>& other : corpora)
+	{
+		stillUsed = stillUsed || other->version == oldVersion;
+	}
+	if (!stillUsed)
+	{
+		resultCache.invalidate(oldVersion);
+	}
+	return opened;
+}
+
+bool SearchServer::loadConfig(const std::string& filename)
+{
+	std::ifstream ifs(filename);
+	if (!ifs)
+	{
+		return false;
+	}
+
+	bool allLoaded = true;
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		std::istringstream fields(line);
+		std::string name, path;
+		if (!(fields >> name) || name[0] == '#')
+		{
+			continue;
+		}
+
+		// The rest of the line is the path, so that it can have spaces in it.
+		std::getline(fields >> std::ws, path);
+		if (!path.empty() && path.back() == '\r')
+		{
+			path.pop_back();
+		}
+		if (!addCorpus(name, path))
+		{
+			std::cout << "Couldn't map corpus '" << name << "' from " << path << ".\n";
+			allLoaded = false;
+		}
+	}
+	return allLoaded;
+}
+
+std::shared_ptr<const CompiledPattern> SearchServer::getPattern(const std::string& pattern, bool ignoreCase)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::pair<std::string, bool> key(pattern, ignoreCase);
+	auto found = patternCache.find(key);
+	if (found != patternCache.end())
+	{
+		return found->second;
+	}
+
+	if (patternCache.size() >= maxCachedPatterns)
+	{
+		patternCache.clear();
+	}
+	std::shared_ptr<const CompiledPattern> compiled(new CompiledPattern(pattern, ignoreCase));
+	patternCache[key] = compiled;
+	return compiled;
+}
+
+void SearchServer::runQuery(const SearchQuery& query, SearchResponse& response)
+{
+	the_clock::time_point startTime = the_clock::now();
+
+	response.count = 0;
+	response.offsets.clear();
+	if (query.corpus >= corpora.size())
+	{
+		response.status = statusUnknownCorpus;
+	}
+	else
+	{
+		// The corpus's file may have been changed since it was mapped, and the cache would still have results for the old contents, so check before looking there.
+		// The corpus is then locked for reading until the search is done, so it can't be mapped again in the middle of it.
+		response.status = statusOK;
+		reload(query.corpus, true);
+		Corpus& corpus = *corpora[query.corpus];
+		std::shared_lock<std::shared_timed_mutex> reading(corpus.corpusMutex);
+		if (!resultCache.find(corpus.version, query.pattern, query.flags, response.offsets, response.count))
+		{
+			search(query, corpus.file, response);
+			resultCache.insert(corpus.version, query.pattern, query.flags, response.offsets, response.count);
+		}
+	}
+
+	response.latency = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(the_clock::now() - startTime).count());
+}
+
+void SearchServer::search(const SearchQuery& query, const MappedFile& file, SearchResponse& response)
+{
+	std::shared_ptr<const CompiledPattern> pattern = getPattern(query.pattern, (query.flags & flagIgnoreCase) != 0);
+	bool countOnly = (query.flags & flagCountOnly) != 0;
+
+	if (useArena && !countOnly)
+	{
+		// The matches grow in the thread's arena, which has already grown to fit earlier queries, so the only allocation is the response's offsets at their final size.
+		ThreadArena& arena = ThreadArena::local();
+		arena.reset();
+		ArenaVector<uint64_t> matches{ ArenaAllocator<uint64_t>(arena) };
+		for (size_t i = pattern->find(file.data(), file.size()); i != CompiledPattern::npos; i = pattern->find(file.data(), file.size(), i + 1))
+		{
+			matches.push_back(i);
+		}
+		response.offsets.assign(matches.begin(), matches.end());
+		response.count = matches.size();
+	}
+	else
+	{
+		for (size_t i = pattern->find(file.data(), file.size()); i != CompiledPattern::npos; i = pattern->find(file.data(), file.size(), i + 1))
+		{
+			if (!countOnly)
+			{
+				response.offsets.push_back(i);
+			}
+			response.count++;
+		}
+	}
+}
+
+std::vector<SearchResponse> SearchServer::answer(const std::vector<SearchQuery>& queries)
+{
+	std::vector<SearchResponse> responses(queries.size());
+	if (queries.empty())
+	{
+		return responses;
+	}
+
+	// Start the pool the first time it's needed, with one thread per core.
+	if (pool.size() == 0)
+	{
+		int threads = int(std::thread::hardware_concurrency());
+		pool.start(threads > 0 ? threads : 1);
+	}
+
+	BatchLatch latch;
+	latch.remaining = int(queries.size());
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		pool.add_task(new QueryTask(this, &queries[i], &responses[i], &latch));
+	}
+
+	std::unique_lock<std::mutex> lock(latch.latchMutex);
+	latch.finished.wait(lock, [&]() { return latch.remaining == 0; });
+	return responses;
+}
+
+#ifndef _WIN32
+void SearchServer::serveConnection(int connection)
+{
+	while (running)
+	{
+		uint32_t header[2];
+		if (!readAll(connection, header, sizeof(header)) || header[0] != requestMagic)
+		{
+			break;
+		}
+
+		if (header[1] == shutdownCount)
+		{
+			stop();
+			break;
+		}
+
+		if (header[1] > maxBatchQueries)
+		{
+			break;
+		}
+
+		// Read the whole batch before running any of it. The queries are added as they arrive rather than all made up front, so a client that
+		// claims a big batch and then sends nothing hasn't made the server allocate for it.
+		std::vector<SearchQuery> queries;
+		bool ok = true;
+		for (uint32_t i = 0; i < header[1]; i++)
+		{
+			uint8_t fields[8];
+			if (!readAll(connection, fields, sizeof(fields)))
+			{
+				ok = false;
+				break;
+			}
+			SearchQuery q;
+			memcpy(&q.corpus, fields, sizeof(q.corpus));
+			q.flags = fields[2];
+			uint32_t length;
+			memcpy(&length, fields + 4, sizeof(length));
+			if (length > maxPatternLength)
+			{
+				ok = false;
+				break;
+			}
+			q.pattern.resize(length);
+			if (length > 0 && !readAll(connection, &q.pattern[0], length))
+			{
+				ok = false;
+				break;
+			}
+			queries.push_back(std::move(q));
+		}
+		if (!ok)
+		{
+			break;
+		}
+
+		std::vector<SearchResponse> responses = answer(queries);
+
+		// Build the whole response in one buffer so that it goes out in as few writes as possible.
+		std::string out;
+		put32(out, responseMagic);
+		put32(out, uint32_t(responses.size()));
+		for (const SearchResponse& r : responses)
+		{
+			put64(out, r.status);
+			put64(out, r.latency);
+			put64(out, r.count);
+			for (uint64_t offset : r.offsets)
+			{
+				put64(out, offset);
+			}
+		}
+		if (!writeAll(connection, out.data(), out.size()))
+		{
+			break;
+		}
+	}
+
+	// Take the socket out of the list before closing it, so that run() can't shut down a socket that has been closed and its number given to something else.
+	std::lock_guard<std::mutex> lock(connectionMutex);
+	for (size_t i = 0; i < connectionSockets.size(); i++)
+	{
+		if (connectionSockets[i] == connection)
+		{
+			connectionSockets.erase(connectionSockets.begin() + i);
+			break;
+		}
+	}
+	::close(connection);
+	finishedThreads.push_back(std::this_thread::get_id());
+}
+
+void SearchServer::reapConnections()
+{
+	for (std::thread::id id : finishedThreads)
+	{
+		for (size_t i = 0; i < connectionThreads.size(); i++)
+		{
+			if (connectionThreads[i]->get_id() == id)
+			{
+				// The thread has nothing left to do but return, so this doesn't wait for long.
+				connectionThreads[i]->join();
+				delete connectionThreads[i];
+				connectionThreads.erase(connectionThreads.begin() + i);
+				break;
+			}
+		}
+	}
+	finishedThreads.clear();
+}
+
+bool SearchServer::run(const std::string& socketPath, int threadCount)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.length() >= sizeof(address.sun_path))
+	{
+		return false;
+	}
+	strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+	listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenSocket < 0)
+	{
+		return false;
+	}
+
+	// Remove a socket file left behind by a server that didn't shut down cleanly.
+	::unlink(socketPath.c_str());
+	if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenSocket, 16) != 0)
+	{
+		::close(listenSocket);
+		listenSocket = -1;
+		return false;
+	}
+
+	pool.start(threadCount > 0 ? threadCount : 1);
+	running = true;
+
+	// Wait for connections, checking a few times a second whether the server has been asked to stop.
+	while (running)
+	{
+		// Join the threads of clients that have disconnected, so that a server with a new connection for every batch doesn't keep a thread for each one.
+		{
+			std::lock_guard<std::mutex> lock(connectionMutex);
+			reapConnections();
+		}
+
+		pollfd waiting;
+		waiting.fd = listenSocket;
+		waiting.events = POLLIN;
+		waiting.revents = 0;
+		if (poll(&waiting, 1, 200) <= 0)
+		{
+			continue;
+		}
+
+		int connection = accept(listenSocket, nullptr, nullptr);
+		if (connection < 0)
+		{
+			continue;
+		}
+
+		// Each client gets its own thread to read its batches, while the queries themselves run on the shared pool.
+		std::lock_guard<std::mutex> lock(connectionMutex);
+		connectionSockets.push_back(connection);
+		connectionThreads.push_back(new std::thread(&SearchServer::serveConnection, this, connection));
+	}
+
+	// Wake up any connection threads that are waiting for a client to send something, then wait for them to finish.
+	{
+		std::lock_guard<std::mutex> lock(connectionMutex);
+		for (int connection : connectionSockets)
+		{
+			shutdown(connection, SHUT_RDWR);
+		}
+	}
+	for (std::thread* t : connectionThreads)
+	{
+		t->join();
+		delete t;
+	}
+	connectionThreads.clear();
+	finishedThreads.clear();
+
+	::close(listenSocket);
+	listenSocket = -1;
+	::unlink(socketPath.c_str());
+	pool.stop();
+	return true;
+}
+
+bool SearchServer::query(const std::string& socketPath, const std::vector<SearchQuery>& queries, std::vector<SearchResponse>& responses)
+{
+	int s = connectTo(socketPath);
+	if (s < 0)
+	{
+		return false;
+	}
+
+	std::string out;
+	put32(out, requestMagic);
+	put32(out, uint32_t(queries.size()));
+	for (const SearchQuery& q : queries)
+	{
+		uint8_t fields[8] = {};
+		memcpy(fields, &q.corpus, sizeof(q.corpus));
+		fields[2] = q.flags;
+		uint32_t length = uint32_t(q.pattern.length());
+		memcpy(fields + 4, &length, sizeof(length));
+		out.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+		out += q.pattern;
+	}
+
+	bool ok = writeAll(s, out.data(), out.size());
+	uint32_t header[2];
+	ok = ok && readAll(s, header, sizeof(header)) && header[0] == responseMagic && header[1] == queries.size();
+
+	responses.assign(ok ? queries.size() : 0, SearchResponse());
+	for (size_t i = 0; ok && i < responses.size(); i++)
+	{
+		uint64_t fields[3];
+		ok = readAll(s, fields, sizeof(fields));
+		if (!ok)
+		{
+			break;
+		}
+		responses[i].status = uint8_t(fields[0]);
+		responses[i].latency = fields[1];
+		responses[i].count = fields[2];
+
+		if ((queries[i].flags & flagCountOnly) == 0 && responses[i].count > 0)
+		{
+			responses[i].offsets.resize(size_t(responses[i].count));
+			ok = readAll(s, responses[i].offsets.data(), responses[i].offsets.size() * sizeof(uint64_t));
+		}
+	}
+
+	::close(s);
+	return ok;
+}
+
+bool SearchServer::sendShutdown(const std::string& socketPath)
+{
+	int s = connectTo(socketPath);
+	if (s < 0)
+	{
+		return false;
+	}
+	uint32_t header[2] = { requestMagic, shutdownCount };
+	bool ok = writeAll(s, header, sizeof(header));
+	::close(s);
+	return ok;
+}
+#else
+// Unix domain sockets aren't available through the standard headers on Windows, so the server only runs on Linux and macOS.
+// answer() still works, so the corpora and worker pool can be used directly.
+void SearchServer::serveConnection(int)
+{
+}
+
+bool SearchServer::run(const std::string&, int)
+{
+	std::cout << "The search server needs Unix domain sockets, which this build doesn't support.\n";
+	return false;
+}
+
+bool SearchServer::query(const std::string&, const std::vector<SearchQuery>&, std::vector<SearchResponse>&)
+{
+	return false;
+}
+
+bool SearchServer::sendShutdown(const std::string&)
+{
+	return false;
+}
+#endif
+
+void SearchServer::stop()
+{
+	running = false;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "MappedFile.h"
+#include "CompiledPattern.h"
+#include "WorkerPool.h"
+#include "ResultCache.h"
+
+// A single query sent to the search server: which corpus to search, the keyword, and option flags.
+struct SearchQuery
+{
+	uint16_t corpus;
+	uint8_t flags;
+	std::string pattern;
+};
+
+// The server's answer to a query. latency is the time taken to run the query on the server, in nanoseconds.
+struct SearchResponse
+{
+	uint8_t status;
+	uint64_t latency;
+	uint64_t count;
+	std::vector<uint64_t> offsets;
+};
+
+// A long-running search service. The corpora are mapped into memory once when the server starts, and compiled patterns are kept between queries,
+// so each query only pays for the search itself rather than for loading files. Clients send batches of queries over a Unix domain socket using a compact binary protocol,
+// and the queries in a batch are run at the same time on a pool of worker threads.
+//
+// Protocol (all integers are little-endian):
+// Request:  uint32 magic 'SSQ1', uint32 query count (0xFFFFFFFF asks the server to shut down), then for each query:
+//           uint16 corpus, uint8 flags, uint8 reserved, uint32 keyword length, keyword bytes.
+// Response: uint32 magic 'SSR1', uint32 response count, then for each query in the same order:
+//           uint8 status, 7 reserved bytes, uint64 latency (ns), uint64 match count, then uint64 offsets unless the count only flag was set.
+class SearchServer
+{
+public:
+	// Query flags.
+	static const uint8_t flagIgnoreCase = 1;
+	static const uint8_t flagCountOnly = 2;
+
+	// Response status codes.
+	static const uint8_t statusOK = 0;
+	static const uint8_t statusUnknownCorpus = 1;
+
+	// Constructor and destructor.
+	SearchServer();
+	~SearchServer();
+
+	// Maps a file into memory to be searched. Corpora are numbered in the order they are added. Returns false if the file couldn't be mapped.
+	bool addCorpus(const std::string& name, const std::string& filename);
+
+	// Adds every corpus listed in a config file. Each line is a name followed by a file path, separated by whitespace. Lines starting with # are ignored.
+	bool loadConfig(const std::string& filename);
+
+	int getCorpusCount() const { return int(corpora.size()); };
+	const std::string& getCorpusName(int i) const { return corpora[i]->name; };
+
+	// The version of a corpus, which is a hash of its contents. Cached results are kept by version, so a corpus whose file changes never gets old results.
+	uint64_t getCorpusVersion(int i) const;
+
+	// Maps a corpus's file again after it has been changed, and throws away the cached results for the old version. Returns false if the file couldn't be mapped.
+	// Queries don't need this to be called: before each one, the file's size, modification time and identity are checked, and it's mapped again if any of them
+	// have changed. A query that is already searching the corpus finishes first, since the corpus is locked for reading while it's searched.
+	bool reloadCorpus(int i);
+
+	// Listens on the socket and answers queries until a client asks the server to shut down, or stop() is called. Returns false if the socket couldn't be opened.
+	bool run(const std::string& socketPath, int threadCount);
+
+	// Asks run() to return. Safe to call from another thread.
+	void stop();
+
+	// Whether run() is listening for connections.
+	bool isRunning() const { return running; };
+
+	// The cache of recent results, which answers a query that has been asked before on the same version of a corpus without searching it again.
+	// Its memory budget is 64MB by default, and a budget of 0 turns it off.
+	void setCacheBudget(size_t bytes) { resultCache.setBudget(bytes); };
+	CacheStats getCacheStats() { return resultCache.getStats(); };
+
+	// Whether each worker thread collects a query's matches in its own ThreadArena, which it resets between queries, rather than growing the response's vector
+	// one match at a time. Either way the response gets the same offsets. It's on by default, and can be turned off to compare the two.
+	void setUseArena(bool use) { useArena = use; };
+	bool getUseArena() const { return useArena; };
+
+	// Runs a batch of queries on the worker pool and waits for all of their answers. Used for every batch that comes in over the socket.
+	std::vector<SearchResponse> answer(const std::vector<SearchQuery>& queries);
+
+	// Client side of the protocol: sends a batch of queries to a running server and reads back the responses.
+	static bool query(const std::string& socketPath, const std::vector<SearchQuery>& queries, std::vector<SearchResponse>& responses);
+
+	// Client side of the protocol: asks a running server to shut down.
+	static bool sendShutdown(const std::string& socketPath);
+
+protected:
+	// The task that runs a query on the worker pool needs to call runQuery().
+	friend class QueryTask;
+
+	// Reads batches from one client until it disconnects.
+	void serveConnection(int connection);
+
+	// Joins and deletes the connection threads that have finished. The connection mutex must already be locked.
+	void reapConnections();
+
+	// Returns a compiled pattern for a keyword, compiling it the first time it's asked for.
+	std::shared_ptr<const CompiledPattern> getPattern(const std::string& pattern, bool ignoreCase);
+
+	// Runs one query. Called on a worker thread.
+	void runQuery(const SearchQuery& query, SearchResponse& response);
+
+	// Searches a mapped corpus for a query's keyword, filling in the response's matches. The corpus must already be locked for reading.
+	void search(const SearchQuery& query, const MappedFile& file, SearchResponse& response);
+
+	// What a corpus's file looked like when it was mapped: its size, when it was last modified (in nanoseconds where the system keeps them), and which file it is,
+	// so that a file that has been replaced by renaming another over it is noticed too. A file rewritten with the same size within the same clock tick can't be told apart.
+	struct FileStamp
+	{
+		uint64_t size;
+		int64_t modified;
+		uint64_t file;
+
+		bool operator==(const FileStamp& other) const { return size == other.size && modified == other.modified && file == other.file; };
+	};
+
+	// Maps a corpus again if its file's stamp has changed. If 'onlyIfChanged' is false it's mapped again anyway.
+	bool reload(int i, bool onlyIfChanged);
+
+	// A mapped corpus, the name it was given in the config, the file it came from, its stamp when it was mapped, and the version (hash) of its contents.
+	// Queries lock it for reading while they search it, and reloading it locks it for writing.
+	struct Corpus
+	{
+		std::string name;
+		std::string path;
+		MappedFile file;
+		FileStamp stamp;
+		uint64_t version;
+		std::shared_timed_mutex corpusMutex;
+	};
+	std::vector<std::unique_ptr<Corpus>> corpora;
+
+	// Only one corpus is reloaded at a time, so that the versions of the others can be compared safely when deciding which cached results to throw away.
+	std::mutex reloadMutex;
+
+	// Compiled patterns that have been used before, shared between worker threads.
+	std::map<std::pair<std::string, bool>, std::shared_ptr<const CompiledPattern>> patternCache;
+	std::mutex cacheMutex;
+
+	// Results of queries that have been run before.
+	ResultCache resultCache;
+
+	// The threads that run the queries.
+	WorkerPool pool;
+	bool useArena;
+
+	// The listening socket, and the threads and sockets of the clients that are connected.
+	// A connection thread adds its id to finishedThreads as the last thing it does, so that run() can join it instead of keeping it until shutdown.
+	std::atomic<bool> running;
+	int listenSocket;
+	std::vector<std::thread*> connectionThreads;
+	std::vector<std::thread::id> finishedThreads;
+	std::vector<int> connectionSockets;
+	std::mutex connectionMutex;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+// Types shared between the different search classes.
+
+// Stores a single match from a multi-keyword search: the position in the text that it was found at and the index of the keyword that was found.
+struct MultiMatch
+{
+	size_t position;
+	int pattern;
+};
+
+// Stores a single match of a pattern that can match text of different lengths: where it starts and how long it is.
+struct WildcardMatch
+{
+	size_t position;
+	size_t length;
+};
@@ -0,0 +1,340 @@
+#include "SegmentedIndex.h"
+#include <fstream>
+#include <cstdio>
+
+// The first word of the manifest and the version of its layout.
+static const char* manifestMagic = "SSIX";
+static const uint32_t manifestVersion = 1;
+
+SegmentedIndex::SegmentedIndex()
+{
+	nextNumber = 1;
+	merging = false;
+	mergeFailed = false;
+	mergeThreshold = 8;
+}
+
+SegmentedIndex::~SegmentedIndex()
+{
+	close();
+}
+
+bool SegmentedIndex::open(const std::string& p)
+{
+	close();
+	path = p;
+
+	std::ifstream ifs(path);
+	if (!ifs)
+	{
+		// A new index starts with no segments.
+		nextNumber = 1;
+		std::lock_guard<std::mutex> guard(lock);
+		return writeManifest();
+	}
+
+	std::string magic;
+	uint32_t version = 0;
+	size_t count = 0;
+	ifs >> magic >> version >> nextNumber >> count;
+	if (!ifs || magic != manifestMagic || version != manifestVersion)
+	{
+		return false;
+	}
+
+	std::vector<std::shared_ptr<IndexSegment>> opened;
+	std::vector<uint32_t> openedNumbers;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t number;
+		if (!(ifs >> number))
+		{
+			return false;
+		}
+		std::shared_ptr<IndexSegment> segment = std::make_shared<IndexSegment>();
+		if (!segment->open(segmentName(number)))
+		{
+			return false;
+		}
+		opened.push_back(segment);
+		openedNumbers.push_back(number);
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+	segments.swap(opened);
+	numbers.swap(openedNumbers);
+	return true;
+}
+
+void SegmentedIndex::close()
+{
+	waitForMerge();
+	std::lock_guard<std::mutex> guard(lock);
+	segments.clear();
+	numbers.clear();
+}
+
+bool SegmentedIndex::clear()
+{
+	waitForMerge();
+	std::vector<uint32_t> oldNumbers;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		segments.clear();
+		oldNumbers.swap(numbers);
+		if (!writeManifest())
+		{
+			return false;
+		}
+	}
+	for (uint32_t old : oldNumbers)
+	{
+		std::remove(segmentName(old).c_str());
+	}
+	return true;
+}
+
+bool SegmentedIndex::writeManifest() const
+{
+	// Write the new manifest next to the old one and then rename it over the top, so a crash part way through leaves the old manifest complete.
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream ofs(temporary);
+		if (!ofs)
+		{
+			return false;
+		}
+		ofs << manifestMagic << " " << manifestVersion << "\n" << nextNumber << "\n" << numbers.size() << "\n";
+		for (uint32_t number : numbers)
+		{
+			ofs << number << "\n";
+		}
+		if (!ofs)
+		{
+			return false;
+		}
+	}
+#ifdef _WIN32
+	// Renaming on Windows fails if the new name is already taken.
+	std::remove(path.c_str());
+#endif
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+std::vector<std::shared_ptr<IndexSegment>> SegmentedIndex::snapshot() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return segments;
+}
+
+bool SegmentedIndex::addDocuments(const std::vector<std::string>& documents)
+{
+	if (documents.empty() || path.empty())
+	{
+		return false;
+	}
+
+	std::string text;
+	std::vector<uint64_t> starts;
+	for (const std::string& document : documents)
+	{
+		starts.push_back(text.length());
+		text += document;
+	}
+	starts.push_back(text.length());
+
+	uint32_t number;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		number = nextNumber++;
+	}
+
+	// The segment is written and opened without holding the lock, so searches carry on while it's built.
+	std::shared_ptr<IndexSegment> segment = std::make_shared<IndexSegment>();
+	if (!IndexSegment::write(segmentName(number), text.data(), text.length(), starts) || !segment->open(segmentName(number)))
+	{
+		std::remove(segmentName(number).c_str());
+		return false;
+	}
+
+	size_t count;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		segments.push_back(segment);
+		numbers.push_back(number);
+		if (!writeManifest())
+		{
+			segments.pop_back();
+			numbers.pop_back();
+			return false;
+		}
+		count = segments.size();
+	}
+
+	if (count >= mergeThreshold)
+	{
+		startMerge();
+	}
+	return true;
+}
+
+bool SegmentedIndex::startMerge()
+{
+	// Only one merge runs at a time. A merge that has finished still needs its thread joining.
+	if (merging)
+	{
+		return false;
+	}
+	if (mergeThread.joinable())
+	{
+		mergeThread.join();
+	}
+
+	std::vector<std::shared_ptr<IndexSegment>> segmentsToMerge;
+	std::vector<uint32_t> numbersToMerge;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (segments.size() < 2)
+		{
+			return false;
+		}
+		segmentsToMerge = segments;
+		numbersToMerge = numbers;
+	}
+
+	merging = true;
+	mergeFailed = false;
+	mergeThread = std::thread(&SegmentedIndex::merge, this, segmentsToMerge, numbersToMerge);
+	return true;
+}
+
+bool SegmentedIndex::waitForMerge()
+{
+	if (mergeThread.joinable())
+	{
+		mergeThread.join();
+	}
+	return !mergeFailed;
+}
+
+void SegmentedIndex::merge(std::vector<std::shared_ptr<IndexSegment>> segmentsToMerge, std::vector<uint32_t> numbersToMerge)
+{
+	// Put the documents of every segment back to back, reading them straight out of the mapped files.
+	std::string text;
+	std::vector<uint64_t> starts;
+	for (const std::shared_ptr<IndexSegment>& segment : segmentsToMerge)
+	{
+		uint64_t base = text.length();
+		const uint64_t* segmentStarts = segment->getDocumentStarts();
+		for (uint64_t d = 0; d < segment->getDocumentCount(); d++)
+		{
+			starts.push_back(base + segmentStarts[d]);
+		}
+		text.append(segment->getText(), size_t(segment->getTextSize()));
+	}
+	starts.push_back(text.length());
+
+	uint32_t number;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		number = nextNumber++;
+	}
+
+	std::shared_ptr<IndexSegment> merged = std::make_shared<IndexSegment>();
+	bool ok = IndexSegment::write(segmentName(number), text.data(), text.length(), starts) && merged->open(segmentName(number));
+	if (ok)
+	{
+		// Segments are only ever added to the end while a merge runs, so the ones that were merged are still the first in the list.
+		std::lock_guard<std::mutex> guard(lock);
+		std::vector<std::shared_ptr<IndexSegment>> oldSegments(segments.begin(), segments.begin() + segmentsToMerge.size());
+		std::vector<uint32_t> oldNumbers(numbers.begin(), numbers.begin() + numbersToMerge.size());
+		segments.erase(segments.begin() + 1, segments.begin() + segmentsToMerge.size());
+		numbers.erase(numbers.begin() + 1, numbers.begin() + numbersToMerge.size());
+		segments[0] = merged;
+		numbers[0] = number;
+		if (!writeManifest())
+		{
+			segments.erase(segments.begin());
+			numbers.erase(numbers.begin());
+			segments.insert(segments.begin(), oldSegments.begin(), oldSegments.end());
+			numbers.insert(numbers.begin(), oldNumbers.begin(), oldNumbers.end());
+			ok = false;
+		}
+	}
+
+	if (!ok)
+	{
+		merged.reset();
+		std::remove(segmentName(number).c_str());
+		mergeFailed = true;
+		merging = false;
+		return;
+	}
+
+	// Let go of the old segments and delete their files. A search that's still running keeps its own copy of the pointers, so its mapping stays valid.
+	// On Windows a file that's still mapped can't be deleted, and is left behind; it isn't in the manifest, so it's never opened again.
+	segmentsToMerge.clear();
+	for (uint32_t old : numbersToMerge)
+	{
+		std::remove(segmentName(old).c_str());
+	}
+	merging = false;
+}
+
+std::vector<IndexMatch> SegmentedIndex::find(const std::string& pattern, bool useNGrams) const
+{
+	std::vector<IndexMatch> results;
+	uint64_t firstDocument = 0;
+	for (const std::shared_ptr<IndexSegment>& segment : snapshot())
+	{
+		if (useNGrams)
+		{
+			segment->findByNGrams(pattern.data(), pattern.length(), firstDocument, results);
+		}
+		else
+		{
+			segment->find(pattern.data(), pattern.length(), firstDocument, results);
+		}
+		firstDocument += segment->getDocumentCount();
+	}
+	return results;
+}
+
+size_t SegmentedIndex::getSegmentCount() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return segments.size();
+}
+
+uint64_t SegmentedIndex::getDocumentCount() const
+{
+	uint64_t total = 0;
+	for (const std::shared_ptr<IndexSegment>& segment : snapshot())
+	{
+		total += segment->getDocumentCount();
+	}
+	return total;
+}
+
+uint64_t SegmentedIndex::fileSize() const
+{
+	uint64_t total = 0;
+	for (const std::shared_ptr<IndexSegment>& segment : snapshot())
+	{
+		total += segment->fileSize();
+	}
+	return total;
+}
+
+std::string SegmentedIndex::getDocument(uint64_t document) const
+{
+	for (const std::shared_ptr<IndexSegment>& segment : snapshot())
+	{
+		if (document < segment->getDocumentCount())
+		{
+			return segment->getDocument(document);
+		}
+		document -= segment->getDocumentCount();
+	}
+	return std::string();
+}
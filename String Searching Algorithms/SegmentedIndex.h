@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "IndexSegment.h"
+
+// An on-disk index that documents can be added to, kept as a list of IndexSegment files plus a small manifest file naming them.
+// Opening the index maps the segments, so it can be searched straight away however big it is, and it carries on from where it was left when the program runs again.
+//
+// Adding documents writes them to a new segment rather than changing the existing ones, so a search that's running never sees a file change under it.
+// Searching many small segments is slower than searching one big one, so segments are merged on a background thread into one new segment,
+// which replaces them in the manifest when it's finished. Searches carry on using the old segments until then.
+//
+// The manifest is a text file: a 'SSIX' line with the version number, the number to give the next segment, and then the numbers of the segments in order.
+// Segment files are named after the manifest with their number added, for example "shrek.index" has segments "shrek.index.1", "shrek.index.2" and so on.
+// Searches can run on any thread, but documents should only be added, and merges started, from one thread at a time.
+class SegmentedIndex
+{
+public:
+	// Constructor and destructor. The destructor waits for a merge to finish.
+	SegmentedIndex();
+	~SegmentedIndex();
+
+	// Opens the index with the given manifest file, creating an empty one if it doesn't exist yet. Returns false if the manifest or one of its segments can't be read.
+	bool open(const std::string& path);
+
+	// Waits for any merge and closes the segments.
+	void close();
+
+	// Deletes every segment, leaving the index open and empty. Returns false if the manifest couldn't be written.
+	bool clear();
+
+	// Writes the documents to a new segment and adds it to the index. Once there are 'mergeThreshold' segments, a background merge is started.
+	bool addDocuments(const std::vector<std::string>& documents);
+
+	// Starts merging all of the current segments into one on a background thread. Returns false if a merge is already running or there's nothing to merge.
+	bool startMerge();
+
+	// Waits for a background merge to finish. Returns false if the merge failed, in which case the old segments are still used.
+	bool waitForMerge();
+	bool isMerging() const { return merging; };
+
+	// Finds every occurance of a keyword in every document, in document order, using the suffix arrays or the 3-gram postings.
+	std::vector<IndexMatch> find(const std::string& pattern, bool useNGrams = false) const;
+
+	// Information about the index.
+	size_t getSegmentCount() const;
+	uint64_t getDocumentCount() const;
+	uint64_t fileSize() const;
+	std::string getDocument(uint64_t document) const;
+
+	// How many segments there can be before a merge is started automatically.
+	void setMergeThreshold(size_t threshold) { mergeThreshold = threshold; };
+
+protected:
+	// Takes a copy of the current list of segments, so a search or merge can use them while documents are added.
+	std::vector<std::shared_ptr<IndexSegment>> snapshot() const;
+
+	// Writes the manifest for the current segments. Has to be called with the lock held.
+	bool writeManifest() const;
+
+	// Runs on the background thread.
+	void merge(std::vector<std::shared_ptr<IndexSegment>> segmentsToMerge, std::vector<uint32_t> numbersToMerge);
+
+	std::string segmentName(uint32_t number) const { return path + "." + std::to_string(number); };
+
+	std::string path;
+
+	// The open segments, the number of each one's file, and the number to give the next file. All three are protected by the lock.
+	std::vector<std::shared_ptr<IndexSegment>> segments;
+	std::vector<uint32_t> numbers;
+	uint32_t nextNumber;
+	mutable std::mutex lock;
+
+	std::thread mergeThread;
+	std::atomic<bool> merging;
+	bool mergeFailed;
+	size_t mergeThreshold;
+};
@@ -3,8 +3,37 @@
 #include <iostream>
 #include <fstream>
 #include "StringSearch.h"
+#include "DoubleArrayTrie.h"
+#include "FoldedText.h"
+#include "TextEncoding.h"
+#include "SearchServer.h"
+#include "BatchSearch.h"
+#include "ResultFile.h"
+#include "IncrementalSearch.h"
+#include "CompressedReader.h"
+#include "PackedDNA.h"
+#include "ContentChunker.h"
+#include "NearDuplicateIndex.h"
+#include "FrequencyCounter.h"
+#include "WordIndex.h"
+#include "SegmentedIndex.h"
+#include "TextReplacer.h"
+#include "MatchRange.h"
+#include "ScalingBenchmark.h"
+#include "PerfCounters.h"
+#include "AllocationTracker.h"
+#include "ThreadArena.h"
+#include "FixedPattern.h"
+#include "WildcardPattern.h"
+#include <thread>
 #include <chrono>
 #include <limits>
+#include <algorithm>
+#include <random>
+#include <functional>
+#include <utility>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 // For measuring performance (time).
 using std::chrono::duration_cast;
@@ -28,6 +57,186 @@ void loadTextFile(std::string filename, std::string& target)
 	);
 }
 
+// Loads a file exactly as it is stored, without any newline conversion, and works out what encoding it's in.
+// loadTextFile() reads in text mode, which is fine for plain text but mangles UTF-16 files, since their newlines are two bytes long.
+TextEncoding loadEncodedFile(std::string filename, std::string& target)
+{
+	std::ifstream ifs(filename, std::ios::binary);
+	target.assign(
+		(std::istreambuf_iterator<char>(ifs)),
+		(std::istreambuf_iterator<char>())
+	);
+
+	size_t bomLength = 0;
+	return detectEncoding(target.data(), target.length(), bomLength);
+}
+
+// Loads a list of keywords from a text file, one keyword per line. Returns false if the file couldn't be opened.
+bool loadKeywordFile(std::string filename, std::vector<std::string>& target)
+{
+	std::ifstream ifs(filename);
+	if (!ifs)
+	{
+		return false;
+	}
+
+	target.clear();
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		// Files saved on Windows leave a carriage return on the end of each line.
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		if (!line.empty())
+		{
+			target.push_back(line);
+		}
+	}
+	return true;
+}
+
+// The time a file was last changed, in seconds, or -1 if it doesn't exist.
+long long fileModifiedTime(const std::string& filename)
+{
+	struct stat info;
+	if (stat(filename.c_str(), &info) != 0)
+	{
+		return -1;
+	}
+	return (long long)info.st_mtime;
+}
+
+// Result sets bigger than this are written to results.bin instead of one line per match in results.csv, since writing the CSV would take longer than the search.
+const size_t largeResultSet = 10000;
+
+// Adds the positions of a keyword's matches to the results. Small result sets go in the CSV file as before, and large ones go in the binary file.
+void writeMatches(std::ofstream& resultsFile, ResultWriter& binaryResults, std::string keyword, const std::vector<int>& results)
+{
+	if (results.size() > largeResultSet)
+	{
+		if (!binaryResults.isOpen())
+		{
+			binaryResults.open("results.bin", 0);
+		}
+		binaryResults.writePattern(int(binaryResults.getPatternCount()), keyword, results);
+		resultsFile << "'" << keyword << "',in results.bin\n";
+		return;
+	}
+
+	for (int i = 0; i < results.size(); i++)
+	{
+		resultsFile << "'" << keyword << "'," << results[i] << "\n";
+	}
+}
+
+// Adds the hardware counts from a timed search to the results and shows them, if they were collected. An event the machine couldn't count is left out.
+void writeCounters(std::ofstream& resultsFile, const PerfSample& sample, int runs)
+{
+	if (!sample.any())
+	{
+		return;
+	}
+
+	for (int e = 0; e < perfEventCount; e++)
+	{
+		if (sample.available[e])
+		{
+			resultsFile << PerfCounters::eventName(e) << " to run " << runs << " times:," << sample.counts[e] << "\n";
+			std::cout << PerfCounters::eventName(e) << ": " << sample.counts[e] << "\n";
+		}
+	}
+	if (sample.ipc() > 0)
+	{
+		resultsFile << "Instructions per cycle:," << sample.ipc() << "\n";
+		std::cout << "Instructions per cycle: " << sample.ipc() << "\n";
+	}
+}
+
+// Runs a search once to warm it up, so that any buffers it keeps between calls have already grown, then runs it 'runs' more times and returns the allocations made in those runs.
+AllocationStats countAllocations(const std::function<void()>& search, int runs)
+{
+	search();
+	AllocationTracker tracker;
+	for (int i = 0; i < runs; i++)
+	{
+		search();
+	}
+	return tracker.stop();
+}
+
+// Checks that searching with a compiled pattern or automaton doesn't allocate any memory once it's warmed up, for '--check-allocations'.
+// The matches go into vectors that are kept between searches, as a program running the same search over and over would. Returns false if any of them allocated.
+bool checkAllocations(const std::string& text, const std::string& kw, int runs)
+{
+	CompiledPattern pattern(kw);
+	CompiledPattern caselessPattern(kw, true);
+	DoubleArrayTrie automaton;
+	automaton.build({ kw });
+	TeddyPrefilter teddy;
+	bool teddyBuilt = teddy.build({ kw });
+	std::vector<size_t> positions;
+	std::vector<MultiMatch> multiMatches;
+	size_t count = 0;
+
+	std::vector<std::pair<std::string, std::function<void()>>> searches;
+	searches.push_back(std::make_pair("Compiled Boyer-Moore (find)", [&]()
+	{
+		for (size_t i = pattern.find(text.data(), text.length()); i != CompiledPattern::npos; i = pattern.find(text.data(), text.length(), i + 1))
+		{
+			count++;
+		}
+	}));
+	searches.push_back(std::make_pair("Compiled Boyer-Moore (findAll)", [&]()
+	{
+		positions.clear();
+		pattern.findAll(text.data(), text.length(), positions);
+	}));
+	searches.push_back(std::make_pair("Compiled Boyer-Moore (ignoring case)", [&]()
+	{
+		positions.clear();
+		caselessPattern.findAll(text.data(), text.length(), positions);
+	}));
+	searches.push_back(std::make_pair("Compiled Boyer-Moore (MatchRange)", [&]()
+	{
+		for (size_t position : MatchRange(pattern, text.data(), text.length()))
+		{
+			count += position != CompiledPattern::npos;
+		}
+	}));
+	searches.push_back(std::make_pair("Aho-Corasick", [&]()
+	{
+		multiMatches.clear();
+		automaton.search(text.data(), text.length(), multiMatches);
+	}));
+	if (teddyBuilt)
+	{
+		searches.push_back(std::make_pair("Teddy", [&]()
+		{
+			multiMatches.clear();
+			teddy.search(text.data(), text.length(), multiMatches);
+		}));
+	}
+
+	bool passed = true;
+	for (const auto& search : searches)
+	{
+		AllocationStats stats = countAllocations(search.second, runs);
+		std::cout << search.first << ": " << stats.allocations << " allocations (" << stats.bytes << " bytes) in " << runs << " searches. " << (stats.allocations == 0 ? "Passed" : "FAILED") << "\n";
+		passed = passed && stats.allocations == 0;
+	}
+	return passed;
+}
+
+// Displays the totals from a batch search.
+void showBatchStats(const BatchStats& stats)
+{
+	std::cout << "Searched for " << stats.patterns << " keyword(s) " << (stats.mode == BatchMode::PatternParallel ? "in parallel by keyword" : "in parallel by chunks of text")
+		<< " and found " << stats.matches << " occurances in " << stats.seconds * 1000 << "ms.\n"
+		<< "Throughput: " << stats.queriesPerSecond() << " queries/s, " << stats.gigabytesPerSecond() << " GB/s.\n\n";
+}
+
 // Function to ensure that the program doesn't fail if an invalid input is received.
 void validateInput()
 {
@@ -39,8 +248,74 @@ void validateInput()
 	}
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+	// Running with '--serve <config file> [socket path]' starts the program as a search server instead of showing the menu.
+	// The config file lists the corpora to keep in memory, one 'name path' pair per line.
+	if (argc >= 3 && std::string(argv[1]) == "--serve")
+	{
+		SearchServer server;
+		if (!server.loadConfig(argv[2]) || server.getCorpusCount() == 0)
+		{
+			std::cout << "Couldn't load the corpora listed in " << argv[2] << ".\n";
+			return 1;
+		}
+		std::string socketPath = argc >= 4 ? argv[3] : "stringsearch.sock";
+		int threads = int(std::thread::hardware_concurrency());
+		std::cout << "Serving " << server.getCorpusCount() << " corpora on " << socketPath << " with " << threads << " worker threads.\n";
+		return server.run(socketPath, threads) ? 0 : 1;
+	}
+
+	// Running with '--to-csv <binary result file> <csv file>' converts a binary result file back to CSV.
+	if (argc >= 4 && std::string(argv[1]) == "--to-csv")
+	{
+		if (!convertResultsToCSV(argv[2], argv[3]))
+		{
+			std::cout << "Couldn't convert " << argv[2] << " to " << argv[3] << ".\n";
+			return 1;
+		}
+		return 0;
+	}
+
+	// Running with '--batch <pattern file> <text file> [output file]' searches the text for every keyword in the pattern file and then exits.
+	if (argc >= 4 && std::string(argv[1]) == "--batch")
+	{
+		BatchSearch batch;
+		std::string text;
+		if (!batch.loadPatterns(argv[2]))
+		{
+			std::cout << "Couldn't load the keywords in " << argv[2] << ".\n";
+			return 1;
+		}
+		loadTextFile(argv[3], text);
+		std::string outputFile = argc >= 5 ? argv[4] : "batch_results.bin";
+		BatchStats stats = batch.run(text.data(), text.length(), outputFile, int(std::thread::hardware_concurrency()));
+		if (!stats.written)
+		{
+			std::cout << "Couldn't write the results to " << outputFile << ".\n";
+			return 1;
+		}
+		showBatchStats(stats);
+		return 0;
+	}
+
+	// Running with '--check-allocations [text file] [keyword]' checks that searches with a compiled pattern don't allocate any memory once they're warmed up,
+	// and exits with 1 if any of them do, so it can be run as a test. It searches the script of Shrek for 'Shrek' if no text file and keyword are given.
+	if (argc >= 2 && std::string(argv[1]) == "--check-allocations")
+	{
+		std::string text;
+		loadTextFile(argc >= 3 ? argv[2] : "Shrek.txt", text);
+		std::string kw = argc >= 4 ? argv[3] : "Shrek";
+		if (text.empty())
+		{
+			std::cout << "Couldn't load " << (argc >= 3 ? argv[2] : "Shrek.txt") << ".\n";
+			return 1;
+		}
+		bool passed = checkAllocations(text, kw, 100);
+		std::cout << (passed ? "No allocations in steady-state searches.\n" : "Some steady-state searches allocated memory.\n");
+		return passed ? 0 : 1;
+	}
+
 	// Initialise time measurement variables.
 	the_clock::time_point startTime = the_clock::now();
 	the_clock::time_point endTime = the_clock::now();
@@ -57,8 +332,13 @@ int main()
 
 	// Used for storing the results of the string search, and storing them in a csv file.
 	std::ofstream resultsFile("results.csv");
+	ResultWriter binaryResults;
 	std::vector<int> results;
 
+	// Hardware performance counters for the Boyer-Moore, Rabin-Karp and scaling benchmarks. They're closed until the user turns them on.
+	PerfCounters counters;
+	PerfSample sample;
+
 	// Integers for holding the user's input.
 	int x = 0;
 	int y = 0;
@@ -67,7 +347,7 @@ int main()
 	do 
 	{
 		// Displays the options that the user has to choose from.
-		std::cout << "Enter 1 to test Boyer-Moore algorithm.\nEnter 2 to test Rabin-Karp algorithm.\nEnter 3 to compare the vector and linked list data structures.\nEnter 4 to toggle text output while running (disabled by default).\nEnter 5 to exit.\nPlease enter a number: ";
+		std::cout << "Enter 1 to test Boyer-Moore algorithm.\nEnter 2 to test Rabin-Karp algorithm.\nEnter 3 to compare the vector and linked list data structures.\nEnter 4 to toggle text output while running (disabled by default).\nEnter 5 to exit.\nEnter 6 to test multi-keyword search (Aho-Corasick, multi-pattern Rabin-Karp and Teddy).\nEnter 7 to test case-insensitive search.\nEnter 8 to test searching UTF-16 and UTF-8 text without converting it.\nEnter 9 to test the search server.\nEnter 10 to test batch search with a file of keywords.\nEnter 11 to test incremental search on a growing log file.\nEnter 12 to test searching compressed text while it is decompressed.\nEnter 13 to test searching DNA packed into 2 bits per base.\nEnter 14 to test content-defined chunking and deduplication.\nEnter 15 to test finding near-duplicate documents.\nEnter 16 to test counting the most common words and n-grams.\nEnter 17 to test phrase search with a word index.\nEnter 18 to test an on-disk index that documents can be added to.\nEnter 19 to test search-and-replace.\nEnter 20 to test finding matches one at a time.\nEnter 21 to run the scaling benchmark on generated texts.\nEnter 22 to toggle hardware performance counters (Linux only, disabled by default).\nEnter 23 to count the memory allocations made by each search.\nEnter 24 to compare search throughput with and without per-thread arenas.\nEnter 25 to compare keywords compiled at build time with keywords compiled at run time.\nEnter 26 to test keywords with wildcards and gaps.\nEnter 27 to test the search server's result cache.\nPlease enter a number: ";
 		std::cin >> x; // recieve user input
 		validateInput();
 		switch (x)
@@ -88,6 +368,148 @@ int main()
 			// Calls function to compare the data structures that I considered when creating the algorithms.
 			stringSearcher.compareDataStructure();
 			break;
+		case 6:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the multi-keyword search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 7:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the case-insensitive searches?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 8:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the encoded text search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 9:
+			// Ask user how many times they wish to send the batch of queries and receive their input.
+			std::cout << "\n\nHow many times would you like to send the batch of queries to the search server?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 10:
+			// Ask user how many times they wish to run the batch and receive their input.
+			std::cout << "\n\nHow many times would you like to run the batch search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 11:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the incremental search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 12:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the compressed text search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 13:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the DNA search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 14:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the chunking?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 15:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the near-duplicate search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 16:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the word and n-gram counts?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 17:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the phrase searches?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 18:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the index searches?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 19:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the search-and-replace?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 20:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the searches?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 21:
+			// Ask user for the largest text to generate, since the biggest sizes take a long time and a lot of memory.
+			std::cout << "\n\nWhat is the largest text size to test, in MB? (1024 for the full sweep up to 1GB)\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 22:
+			// Turns the hardware performance counters on or off. Opening them can fail if the system doesn't support them or doesn't allow it.
+			if (counters.isOpen())
+			{
+				counters.close();
+				std::cout << "\nHardware performance counters are off.\n\n";
+			}
+			else if (counters.open())
+			{
+				std::cout << "\nHardware performance counters are on.\n\n";
+			}
+			else
+			{
+				std::cout << "\nHardware performance counters aren't available on this system (see /proc/sys/kernel/perf_event_paranoid on Linux).\n\n";
+			}
+			break;
+		case 23:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run each search?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 24:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many rounds of queries would you like to run?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 25:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the searches?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 26:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many times would you like to run the wildcard searches?\n";
+			std::cin >> y;
+			validateInput();
+			break;
+		case 27:
+			// Ask user how many times they wish to run the algorithm and receive their input.
+			std::cout << "\n\nHow many batches of queries would you like to send?\n";
+			std::cin >> y;
+			validateInput();
+			break;
 		case 4:
 			// Turns text output while the algorithm is runnning on or off. It is off by default as it has a huge impact on performance.
 			stringSearcher.setOutputText(!stringSearcher.getOutputText());
@@ -106,21 +528,21 @@ int main()
 
 			// Add the results to the results file.
 			resultsFile << "Boyer-Moore Algorithm\n\nWord, Position\n";
-			for (int i = 0; i < results.size(); i++)
-			{
-				resultsFile << "'wood'," << results[i] << "\n";
-			}
+			writeMatches(resultsFile, binaryResults, "wood", results);
 			resultsFile << "Occurances:," << results.size() << "\n";
 
 			// Measure the performance of the algorithm.
 			// Gets the time it takes to run the algorithm y amount of times, then adds it to the results file and outputs it to the console.
+			counters.start();
 			startTime = the_clock::now();
 			for (int i = 0; i < y; i++)
 			{
 				stringSearcher.searchBoyerMoore("wood", smallText);
 			}
 			endTime = the_clock::now();
+			sample = counters.stop();
 			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			writeCounters(resultsFile, sample, y);
 			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
 			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
 
@@ -129,19 +551,19 @@ int main()
 			results = stringSearcher.searchBoyerMoore("Never gonna", mediumText);
 
 			resultsFile << "Word, Position\n";
-			for (int i = 0; i < results.size(); i++)
-			{
-				resultsFile << "'Never gonna'," << results[i] << "\n";
-			}
+			writeMatches(resultsFile, binaryResults, "Never gonna", results);
 			resultsFile << "Occurances:," << results.size() << "\n";
 
+			counters.start();
 			startTime = the_clock::now();
 			for (int i = 0; i < y; i++)
 			{
 				stringSearcher.searchBoyerMoore("Never gonna", mediumText);
 			}
 			endTime = the_clock::now();
+			sample = counters.stop();
 			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			writeCounters(resultsFile, sample, y);
 			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
 			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
 
@@ -150,19 +572,19 @@ int main()
 			results = stringSearcher.searchBoyerMoore("Shrek", largeText);
 
 			resultsFile << "Word, Position\n";
-			for (int i = 0; i < results.size(); i++)
-			{
-				resultsFile << "'Shrek'," << results[i] << "\n";
-			}
+			writeMatches(resultsFile, binaryResults, "Shrek", results);
 			resultsFile << "Occurances:," << results.size() << "\n";
 
+			counters.start();
 			startTime = the_clock::now();
 			for (int i = 0; i < y; i++)
 			{
 				stringSearcher.searchBoyerMoore("Shrek", largeText);
 			}
 			endTime = the_clock::now();
+			sample = counters.stop();
 			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			writeCounters(resultsFile, sample, y);
 			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
 			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
 		}
@@ -174,21 +596,21 @@ int main()
 
 			// Add the results to the results file.
 			resultsFile << "Rabin-Karp Algorithm\n\nWord, Position\n";
-			for (int i = 0; i < results.size(); i++)
-			{
-				resultsFile << "'wood'," << results[i] << "\n";
-			}
+			writeMatches(resultsFile, binaryResults, "wood", results);
 			resultsFile << "Occurances:," << results.size() << "\n";
 
 			// Measure the performance of the algorithm.
 			// Gets the time it takes to run the algorithm y amount of times, then adds it to the results file and outputs it to the console.
+			counters.start();
 			startTime = the_clock::now();
 			for (int i = 0; i < y; i++)
 			{
 				stringSearcher.searchRabinKarp("wood", smallText);
 			}
 			endTime = the_clock::now();
+			sample = counters.stop();
 			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			writeCounters(resultsFile, sample, y);
 			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
 			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
 
@@ -197,19 +619,19 @@ int main()
 			results = stringSearcher.searchRabinKarp("Never gonna", mediumText);
 
 			resultsFile << "Word, Position\n";
-			for (int i = 0; i < results.size(); i++)
-			{
-				resultsFile << "'Never gonna'," << results[i] << "\n";
-			}
+			writeMatches(resultsFile, binaryResults, "Never gonna", results);
 			resultsFile << "Occurances:," << results.size() << "\n";
 
+			counters.start();
 			startTime = the_clock::now();
 			for (int i = 0; i < y; i++)
 			{
 				stringSearcher.searchRabinKarp("Never gonna", mediumText);
 			}
 			endTime = the_clock::now();
+			sample = counters.stop();
 			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			writeCounters(resultsFile, sample, y);
 			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
 			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
 
@@ -218,21 +640,1437 @@ int main()
 			results = stringSearcher.searchRabinKarp("Shrek", largeText);
 
 			resultsFile << "Word, Position\n";
+			writeMatches(resultsFile, binaryResults, "Shrek", results);
+			resultsFile << "Occurances:," << results.size() << "\n";
+
+			counters.start();
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				stringSearcher.searchRabinKarp("Shrek", largeText);
+			}
+			endTime = the_clock::now();
+			sample = counters.stop();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			writeCounters(resultsFile, sample, y);
+			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
+			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
+		}
+
+		else if (x == 6) // If the user chose to test the multi-keyword search...
+		{
+			// Use the keywords in keywords.txt if there is one, otherwise search for the main characters in Shrek.
+			std::vector<std::string> keywords;
+			if (!loadKeywordFile("keywords.txt", keywords))
+			{
+				keywords = { "Shrek", "Donkey", "Fiona", "Farquaad", "Dragon", "ogre" };
+			}
+
+			// The automaton is built once and saved to keywords.dat, and later runs load that file instead of building it again. Loading maps the file into memory,
+			// which is much quicker than building the automaton for a large dictionary. It's only rebuilt if keywords.dat is missing, is older than keywords.txt,
+			// or was built for different keywords (keywords.txt could have been changed within the same second, or there may not be one at all).
+			DoubleArrayTrie automaton;
+			startTime = the_clock::now();
+			bool loaded = fileModifiedTime("keywords.dat") >= fileModifiedTime("keywords.txt") && automaton.load("keywords.dat");
+			endTime = the_clock::now();
+			auto load_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+			if (loaded && automaton.getKeywordCount() == int(keywords.size()))
+			{
+				for (int k = 0; loaded && k < automaton.getKeywordCount(); k++)
+				{
+					loaded = automaton.getKeyword(k) == keywords[k];
+				}
+			}
+			else
+			{
+				loaded = false;
+			}
+
+			long long build_time = -1;
+			if (!loaded)
+			{
+				std::cout << "\nBuilding the double-array automaton for " << keywords.size() << " keyword(s) and saving it to keywords.dat...\n";
+				startTime = the_clock::now();
+				DoubleArrayTrie builder;
+				builder.build(keywords);
+				bool saved = builder.save("keywords.dat");
+				endTime = the_clock::now();
+				build_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+				startTime = the_clock::now();
+				if (!saved || !automaton.load("keywords.dat"))
+				{
+					std::cout << "Couldn't save and load keywords.dat.\n\n";
+					continue;
+				}
+				endTime = the_clock::now();
+				load_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+				std::cout << "Built " << automaton.getStateCount() << " states (" << automaton.memoryUsage() << " bytes) in " << build_time << "ms, loaded in " << load_time << " microseconds.\n";
+			}
+			else
+			{
+				std::cout << "\nLoaded the double-array automaton for " << keywords.size() << " keyword(s) from keywords.dat without rebuilding it: " << automaton.getStateCount()
+					<< " states (" << automaton.memoryUsage() << " bytes) in " << load_time << " microseconds.\n";
+			}
+
+			// Run the search once to retrieve the results.
+			std::cout << "Long length text: Searching for how many occurances of each keyword are in the script of the movie 'Shrek'.\n";
+			std::vector<MultiMatch> multiResults = automaton.search(largeText);
+
+			// Add the results to the results file.
+			resultsFile << "Aho-Corasick Algorithm (double-array)\n\nKeywords:," << automaton.getKeywordCount() << "\nStates:," << automaton.getStateCount() << "\nBuild time:," << (loaded ? std::string("not rebuilt") : std::to_string(build_time) + ",ms") << "\nLoad time:," << load_time << ",us\n\nWord, Position\n";
+			for (int i = 0; i < multiResults.size(); i++)
+			{
+				resultsFile << "'" << automaton.getKeyword(multiResults[i].pattern) << "'," << multiResults[i].position << "\n";
+			}
+			resultsFile << "Occurances:," << multiResults.size() << "\n";
+
+			// Measure the performance of the algorithm.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				automaton.search(largeText);
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
+			std::cout << "Aho-Corasick found " << multiResults.size() << " occurances.\nTime taken to run " << y << " times: " << time_taken << "ms\n\n";
+
+			// Repeat with the other multi-pattern strategies so that they can be compared.
+			// Rabin-Karp does one pass over the text with a rolling hash for each keyword length, and Teddy uses SIMD to find candidate positions for up to 64 keywords.
+			MultiStrategy strategies[] = { MultiStrategy::RabinKarp, MultiStrategy::Teddy };
+			std::string strategyNames[] = { "Rabin-Karp Algorithm (multi-pattern)", std::string("Teddy Algorithm (") + (TeddyPrefilter::usingSIMD() ? "SSSE3" : "no SIMD") + ")" };
+			for (int s = 0; s < 2; s++)
+			{
+				multiResults = stringSearcher.searchMultiple(keywords, largeText, strategies[s]);
+
+				resultsFile << strategyNames[s] << "\n\nWord, Position\n";
+				for (int i = 0; i < multiResults.size(); i++)
+				{
+					resultsFile << "'" << keywords[multiResults[i].pattern] << "'," << multiResults[i].position << "\n";
+				}
+				resultsFile << "Occurances:," << multiResults.size() << "\n";
+
+				startTime = the_clock::now();
+				for (int i = 0; i < y; i++)
+				{
+					stringSearcher.searchMultiple(keywords, largeText, strategies[s]);
+				}
+				endTime = the_clock::now();
+				time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+				resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
+				std::cout << strategyNames[s] << " found " << multiResults.size() << " occurances.\nTime taken to run " << y << " times: " << time_taken << "ms\n\n";
+			}
+		}
+
+		else if (x == 7) // If the user chose to test case-insensitive search...
+		{
+			// Run the algorithm once to retrieve the results. 'shrek' should match 'Shrek' and 'SHREK' as well.
+			std::cout << "\nLong length text: Searching for how many occurances of 'shrek', ignoring case, are in the script of the movie 'Shrek'.\n";
+			results = stringSearcher.searchBoyerMooreIgnoreCase("shrek", largeText);
+
+			resultsFile << "Boyer-Moore Algorithm (ignoring case)\n\nWord, Position\n";
 			for (int i = 0; i < results.size(); i++)
 			{
-				resultsFile << "'Shrek'," << results[i] << "\n";
+				resultsFile << "'" << largeText.substr(results[i], 5) << "'," << results[i] << "\n";
 			}
 			resultsFile << "Occurances:," << results.size() << "\n";
 
 			startTime = the_clock::now();
 			for (int i = 0; i < y; i++)
 			{
-				stringSearcher.searchRabinKarp("Shrek", largeText);
+				stringSearcher.searchBoyerMooreIgnoreCase("shrek", largeText);
 			}
 			endTime = the_clock::now();
 			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
 			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
-			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
+			std::cout << "Boyer-Moore found " << results.size() << " occurances.\nTime taken to run " << y << " times: " << time_taken << "ms\n\n";
+
+			// Repeat with Teddy, which puts both cases of each letter into its SIMD tables.
+			std::vector<std::string> caselessKeywords = { "shrek" };
+			std::vector<MultiMatch> multiResults = stringSearcher.searchTeddyIgnoreCase(caselessKeywords, largeText);
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				stringSearcher.searchTeddyIgnoreCase(caselessKeywords, largeText);
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			resultsFile << "Teddy Algorithm (ignoring case)\nOccurances:," << multiResults.size() << "\nTime taken to run " << y << " times:," << time_taken << ",ms\n\n";
+			std::cout << "Teddy found " << multiResults.size() << " occurances.\nTime taken to run " << y << " times: " << time_taken << "ms\n\n";
+
+			// Repeat with a folded shadow copy of the text. The copy is made once, then each search is a normal case-sensitive search, at the cost of the extra memory.
+			startTime = the_clock::now();
+			FoldedText foldedText;
+			foldedText.build(largeText);
+			endTime = the_clock::now();
+			auto fold_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+			std::vector<size_t> foldedResults = foldedText.search("shrek");
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				foldedText.search("shrek");
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			resultsFile << "Boyer-Moore Algorithm (folded shadow copy)\nOccurances:," << foldedResults.size() << "\nTime taken to fold:," << fold_time << ",us\nExtra memory:," << foldedText.memoryUsage() << ",bytes\nTime taken to run " << y << " times:," << time_taken << ",ms\n\n";
+			std::cout << "Folded shadow copy found " << foldedResults.size() << " occurances.\nFolding took " << fold_time << " microseconds and uses " << foldedText.memoryUsage() << " extra bytes.\nTime taken to run " << y << " times: " << time_taken << "ms\n\n";
+		}
+
+		else if (x == 8) // If the user chose to test searching encoded text...
+		{
+			// The Interactive Mandelbrot's Main.cpp is saved as UTF-16LE with a BOM, so it is a good example of a file that the byte-wise searches can't read.
+			std::string encodedText;
+			TextEncoding encoding = loadEncodedFile("../Interactive Mandelbrot/CMP105App/Main.cpp", encodedText);
+			std::cout << "\nSearching for how many occurances of 'window' are in the Interactive Mandelbrot's Main.cpp, which is " << encodingName(encoding) << ".\n";
+
+			// The keyword is converted to the file's encoding once, and then the file is searched as it is.
+			EncodedSearch encodedSearcher;
+			encodedSearcher.compile("window", encoding);
+			std::vector<EncodedMatch> encodedResults = encodedSearcher.search(encodedText);
+
+			resultsFile << "Boyer-Moore Algorithm (" << encodingName(encoding) << ")\n\nWord, Byte Position, Character Position\n";
+			for (int i = 0; i < encodedResults.size(); i++)
+			{
+				resultsFile << "'window'," << encodedResults[i].byteOffset << "," << encodedResults[i].charOffset << "\n";
+			}
+			resultsFile << "Occurances:," << encodedResults.size() << "\n";
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				encodedSearcher.search(encodedText);
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			resultsFile << "Time taken to run " << y << " times:," << time_taken << ",ms\n\n";
+			std::cout << "Found " << encodedResults.size() << " occurances.\nTime taken to run " << y << " times: " << time_taken << "ms\n\n";
+		}
+
+		else if (x == 9) // If the user chose to test the search server...
+		{
+			// Start a server in the background with the medium and large texts mapped into memory.
+			SearchServer server;
+			if (!server.addCorpus("rickroll", "rickroll.txt") || !server.addCorpus("shrek", "Shrek.txt"))
+			{
+				std::cout << "\nCouldn't map rickroll.txt and Shrek.txt.\n\n";
+				continue;
+			}
+			std::thread serverThread([&server]() { server.run("stringsearch.sock", int(std::thread::hardware_concurrency())); });
+			for (int i = 0; i < 100 && !server.isRunning(); i++)
+			{
+				std::this_thread::sleep_for(milliseconds(10));
+			}
+
+			// The same keywords as the other tests, sent as one batch so they run at the same time on the server.
+			std::vector<SearchQuery> queries = {
+				{ 0, 0, "Never gonna" },
+				{ 1, 0, "Shrek" },
+				{ 1, SearchServer::flagIgnoreCase, "shrek" },
+				{ 1, SearchServer::flagCountOnly, "Donkey" }
+			};
+			std::vector<SearchResponse> responses;
+
+			std::cout << "\nSending " << queries.size() << " queries to the search server...\n";
+			if (!SearchServer::query("stringsearch.sock", queries, responses))
+			{
+				std::cout << "The search server didn't answer.\n\n";
+			}
+			else
+			{
+				resultsFile << "Search Server\n\nWord, Corpus, Occurances, Server Latency (ns)\n";
+				for (int i = 0; i < responses.size(); i++)
+				{
+					resultsFile << "'" << queries[i].pattern << "'," << server.getCorpusName(queries[i].corpus) << "," << responses[i].count << "," << responses[i].latency << "\n";
+					std::cout << "'" << queries[i].pattern << "' in " << server.getCorpusName(queries[i].corpus) << ": " << responses[i].count << " occurances, " << responses[i].latency << "ns on the server.\n";
+				}
+
+				// Measure the round trip time of the whole batch, including the socket.
+				startTime = the_clock::now();
+				for (int i = 0; i < y; i++)
+				{
+					SearchServer::query("stringsearch.sock", queries, responses);
+				}
+				endTime = the_clock::now();
+				time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+				resultsFile << "Time taken to send " << y << " batches:," << time_taken << ",ms\n\n";
+				std::cout << "Time taken to send " << y << " batches: " << time_taken << "ms\n\n";
+			}
+
+			SearchServer::sendShutdown("stringsearch.sock");
+			server.stop();
+			serverThread.join();
+		}
+
+		else if (x == 10) // If the user chose to test batch search...
+		{
+			// Use the keywords in patterns.txt if there is one, otherwise use every different word in the Shrek script as a keyword.
+			BatchSearch batch;
+			if (!batch.loadPatterns("patterns.txt"))
+			{
+				std::vector<std::string> words;
+				std::string word;
+				for (char c : largeText)
+				{
+					if (isalpha((unsigned char)c))
+					{
+						word += c;
+					}
+					else if (!word.empty())
+					{
+						words.push_back(word);
+						word.clear();
+					}
+				}
+				std::sort(words.begin(), words.end());
+				words.erase(std::unique(words.begin(), words.end()), words.end());
+				batch.setPatterns(words);
+			}
+
+			std::cout << "\nLong length text: Searching the script of the movie 'Shrek' for " << batch.getPatterns().size() << " keywords. The results are written to batch_results.bin.\n";
+			int threads = int(std::thread::hardware_concurrency());
+			BatchStats stats = batch.run(largeText.data(), largeText.length(), "batch_results.bin", threads);
+			if (!stats.written)
+			{
+				std::cout << "Couldn't write the results to batch_results.bin.\n\n";
+				continue;
+			}
+			showBatchStats(stats);
+
+			resultsFile << "Batch Search\n\nKeywords:," << stats.patterns << "\nMode:," << (stats.mode == BatchMode::PatternParallel ? "Pattern-parallel" : "Text-parallel") << "\nOccurances:," << stats.matches << "\n";
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				batch.run(largeText.data(), largeText.length(), "batch_results.bin", threads);
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			resultsFile << "Queries per second:," << stats.queriesPerSecond() << "\nGB per second:," << stats.gigabytesPerSecond() << "\nTime taken to run " << y << " times:," << time_taken << ",ms\n\n";
+			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms\n\n";
+		}
+
+		else if (x == 11) // If the user chose to test incremental search...
+		{
+			// The Shrek script is written to a log file a piece at a time, as if something was still writing it, and the new part is searched after each write.
+			// The incremental search only reads the part that was added, while searching the whole file again has to read everything that was already there.
+			const size_t pieceSize = 16384;
+			std::cout << "\nLong length text: Searching for 'Donkey' in a copy of the script of the movie 'Shrek' that grows by " << pieceSize << " bytes at a time.\n";
+
+			IncrementalSearch tailSearch;
+			std::vector<MultiMatch> tailResults;
+			size_t fullCount = 0;
+			long long incremental_time = 0;
+			long long rescan_time = 0;
+			for (int i = 0; i < y; i++)
+			{
+				std::ofstream("shrek_log.txt", std::ios::binary | std::ios::trunc);
+				tailSearch.start("Donkey", IncrementalMode::BoyerMoore);
+				tailResults.clear();
+
+				for (size_t written = 0; written < largeText.length(); written += pieceSize)
+				{
+					std::ofstream log("shrek_log.txt", std::ios::binary | std::ios::app);
+					log.write(largeText.data() + written, std::min(pieceSize, largeText.length() - written));
+					log.close();
+
+					// Save the state after each piece so that a search that's stopped could carry on from here.
+					startTime = the_clock::now();
+					tailSearch.scanFile("shrek_log.txt", tailResults);
+					tailSearch.saveState("shrek_log.state");
+					endTime = the_clock::now();
+					incremental_time += duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+					startTime = the_clock::now();
+					std::string wholeLog;
+					loadTextFile("shrek_log.txt", wholeLog);
+					fullCount = stringSearcher.searchBoyerMoore("Donkey", wholeLog).size();
+					endTime = the_clock::now();
+					rescan_time += duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+				}
+			}
+
+			resultsFile << "Incremental Search\n\nWord, Position\n";
+			for (int i = 0; i < tailResults.size(); i++)
+			{
+				resultsFile << "'Donkey'," << tailResults[i].position << "\n";
+			}
+			resultsFile << "Occurances:," << tailResults.size() << "\nOccurances (searching the whole file):," << fullCount << "\nTime taken to run " << y << " times (incremental):," << incremental_time / 1000 << ",ms\nTime taken to run " << y << " times (whole file):," << rescan_time / 1000 << ",ms\n\n";
+			std::cout << "Found " << tailResults.size() << " occurances incrementally and " << fullCount << " by searching the whole file each time.\nTime taken to run " << y << " times: " << incremental_time / 1000 << "ms incrementally, " << rescan_time / 1000 << "ms searching the whole file.\n\n";
+		}
+
+		else if (x == 12) // If the user chose to test searching compressed text...
+		{
+			// Compress the Shrek script in each format that this build supports. With neither zlib nor zstd, the plain file still goes through the same pipeline.
+			std::vector<std::pair<std::string, CompressionFormat>> archives;
+			if (compressFile("Shrek.txt", "Shrek.txt.gz", CompressionFormat::Gzip))
+			{
+				archives.push_back({ "Shrek.txt.gz", CompressionFormat::Gzip });
+			}
+			if (compressFile("Shrek.txt", "Shrek.txt.zst", CompressionFormat::Zstd))
+			{
+				archives.push_back({ "Shrek.txt.zst", CompressionFormat::Zstd });
+			}
+			if (archives.empty())
+			{
+				std::cout << "\nThis was built without USE_ZLIB or USE_ZSTD, so the uncompressed script is used instead.";
+				archives.push_back({ "Shrek.txt", CompressionFormat::None });
+			}
+
+			resultsFile << "Compressed Text Search\n\nFile, Occurances (decompress then search), Time (decompress then search) (ms), Occurances (pipelined), Time (pipelined) (ms)\n";
+			for (int a = 0; a < archives.size(); a++)
+			{
+				const std::string& archive = archives[a].first;
+				std::cout << "\nLong length text: Searching for 'Donkey' in " << archive << ".\n";
+
+				// The usual way: decompress the whole file to disk, read it back in and then search it.
+				size_t diskCount = 0;
+				startTime = the_clock::now();
+				for (int i = 0; i < y; i++)
+				{
+					std::string decompressed;
+					decompressFile(archive, "Shrek_decompressed.txt");
+					loadTextFile("Shrek_decompressed.txt", decompressed);
+					diskCount = stringSearcher.searchBoyerMoore("Donkey", decompressed).size();
+				}
+				endTime = the_clock::now();
+				auto disk_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+				// The pipelined way: decompress on another thread and search each block as soon as it's ready.
+				std::vector<MultiMatch> streamResults;
+				bool streamError = false;
+				startTime = the_clock::now();
+				for (int i = 0; i < y; i++)
+				{
+					CompressedReader reader;
+					IncrementalSearch streamSearch;
+					streamSearch.start("Donkey", IncrementalMode::BoyerMoore);
+					streamResults.clear();
+					if (!reader.open(archive))
+					{
+						streamError = true;
+						break;
+					}
+					const char* block;
+					size_t blockLength;
+					while (reader.next(block, blockLength))
+					{
+						streamSearch.feed(block, blockLength, streamResults);
+					}
+					streamError = streamError || reader.hadError();
+				}
+				endTime = the_clock::now();
+				time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+				if (streamError)
+				{
+					std::cout << "There was a problem reading " << archive << ".\n";
+				}
+				resultsFile << archive << "," << diskCount << "," << disk_time << "," << streamResults.size() << "," << time_taken << "\n";
+				std::cout << "Decompressing to disk then searching found " << diskCount << " occurances.\nTime taken to run " << y << " times: " << disk_time << "ms\n";
+				std::cout << "Searching while decompressing found " << streamResults.size() << " occurances.\nTime taken to run " << y << " times: " << time_taken << "ms\n";
+			}
+			resultsFile << "\n";
+			std::cout << "\n";
+		}
+
+		else if (x == 13) // If the user chose to test searching packed DNA...
+		{
+			// Make up a genome of random bases. The seed is fixed so every run searches the same genome.
+			const size_t genomeLength = 64 * 1024 * 1024;
+			const std::string motif = "GATTACAGATTACA";
+			std::string genome(genomeLength, 'A');
+			std::mt19937 generator(105);
+			for (size_t i = 0; i < genomeLength; i++)
+			{
+				genome[i] = "ACGT"[generator() & 3];
+			}
+
+			// Random DNA would hardly ever contain the motif, so put some copies in.
+			for (int i = 0; i < 1000; i++)
+			{
+				genome.replace(generator() % (genomeLength - motif.length()), motif.length(), motif);
+			}
+			std::cout << "\nSearching a synthetic genome of " << genomeLength << " bases for '" << motif << "'.\n";
+
+			PackedDNA packedGenome;
+			startTime = the_clock::now();
+			packedGenome.pack(genome);
+			endTime = the_clock::now();
+			auto pack_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			// Boyer-Moore on the text as it is, for comparison. The compiled pattern is used so that the text isn't copied for each search.
+			CompiledPattern motifPattern;
+			motifPattern.compile(motif);
+			std::vector<size_t> byteResults;
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				byteResults.clear();
+				motifPattern.findAll(genome.data(), genome.length(), byteResults);
+			}
+			endTime = the_clock::now();
+			auto byte_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			std::vector<size_t> packedResults;
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				packedResults = packedGenome.search(motif);
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "Packed DNA Search\n\nBases:," << genomeLength << "\nOccurances (Boyer-Moore):," << byteResults.size() << "\nOccurances (packed):," << packedResults.size() << "\nPacked size:," << packedGenome.memoryUsage() << ",bytes\nTime taken to pack:," << pack_time << ",ms\nTime taken to run " << y << " times (Boyer-Moore):," << byte_time << ",ms\nTime taken to run " << y << " times (packed):," << time_taken << ",ms\n\n";
+			std::cout << "Boyer-Moore found " << byteResults.size() << " occurances.\nTime taken to run " << y << " times: " << byte_time << "ms\n";
+			std::cout << "The packed search found " << packedResults.size() << " occurances.\nPacking took " << pack_time << "ms and uses " << packedGenome.memoryUsage() << " bytes.\nTime taken to run " << y << " times: " << time_taken << "ms\n\n";
+		}
+
+		else if (x == 14) // If the user chose to test content-defined chunking...
+		{
+			// Make 64 versions of the Shrek script, each one a small edit of the last, like a folder of backups. Most of each version is the same as the one before,
+			// but the edits move everything after them along, so cutting at fixed sizes would find hardly any duplicates.
+			std::string versions;
+			std::string version = largeText;
+			std::mt19937 generator(37);
+			for (int v = 0; v < 64; v++)
+			{
+				if (!version.empty())
+				{
+					size_t at = generator() % version.length();
+					if (v % 2 == 0)
+					{
+						version.insert(at, "Donkey: Are we there yet?\n");
+					}
+					else
+					{
+						version.erase(at, std::min<size_t>(100, version.length() - at));
+					}
+				}
+				versions += version;
+			}
+
+			ContentChunker chunker(256, 1024, 8192);
+			int threads = int(std::thread::hardware_concurrency());
+			std::vector<Chunk> chunks = chunker.chunk(versions.data(), versions.length(), threads);
+			DedupStats dedup = ContentChunker::summarise(chunks);
+			std::cout << "\nCut " << versions.length() << " bytes into " << dedup.chunks << " chunks, " << dedup.uniqueChunks << " of them different.\nWithout the duplicates it would be " << dedup.uniqueBytes << " bytes, " << dedup.ratio() << " times smaller.\n";
+
+			// Time it on one thread and on all of them.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				chunker.chunk(versions.data(), versions.length());
+			}
+			endTime = the_clock::now();
+			auto single_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				chunker.chunk(versions.data(), versions.length(), threads);
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "Content-Defined Chunking\n\nBytes:," << versions.length() << "\nChunks:," << dedup.chunks << "\nUnique chunks:," << dedup.uniqueChunks << "\nUnique bytes:," << dedup.uniqueBytes << "\nDeduplication ratio:," << dedup.ratio() << "\nTime taken to run " << y << " times (1 thread):," << single_time << ",ms\nTime taken to run " << y << " times (" << threads << " threads):," << time_taken << ",ms\n\n";
+			std::cout << "Time taken to run " << y << " times: " << single_time << "ms on 1 thread, " << time_taken << "ms on " << threads << " threads.\n\n";
+		}
+
+		else if (x == 15) // If the user chose to test finding near-duplicate documents...
+		{
+			// Make a collection of documents from pieces of the Shrek script, and then some rewritten copies of the first few, which are the near-duplicates to find.
+			// Pieces that happen to overlap a lot are near-duplicates as well.
+			const int pieces = 5000;
+			const int copies = 500;
+			const size_t pieceLength = 2000;
+			std::vector<std::string> documents;
+			std::mt19937 generator(38);
+			for (int i = 0; i < pieces && largeText.length() > pieceLength; i++)
+			{
+				documents.push_back(largeText.substr(generator() % (largeText.length() - pieceLength), pieceLength));
+			}
+			for (int i = 0; i < copies && i < int(documents.size()); i++)
+			{
+				std::string copy = documents[i];
+				for (int e = 0; e < 3; e++)
+				{
+					copy.insert(generator() % copy.length(), " Donkey: Oh, you're talking about a sequel. ");
+				}
+				documents.push_back(copy);
+			}
+			std::cout << "\nLooking for near-duplicates among " << documents.size() << " pieces of the script of the movie 'Shrek'.\n";
+
+			int threads = int(std::thread::hardware_concurrency());
+			std::vector<DuplicatePair> duplicates;
+			long long fingerprint_time = 0;
+			long long lsh_time = 0;
+			for (int i = 0; i < y; i++)
+			{
+				NearDuplicateIndex index;
+				startTime = the_clock::now();
+				index.addDocuments(documents, threads);
+				endTime = the_clock::now();
+				fingerprint_time += duration_cast<milliseconds>(endTime - startTime).count();
+
+				startTime = the_clock::now();
+				duplicates = index.findDuplicates(0.5);
+				endTime = the_clock::now();
+				lsh_time += duration_cast<milliseconds>(endTime - startTime).count();
+
+				// Comparing every pair shows how many the bands missed, and how long that takes instead. Only done once since it's so slow.
+				if (i == 0)
+				{
+					startTime = the_clock::now();
+					std::vector<DuplicatePair> allPairs = index.findDuplicatesExhaustive(0.5);
+					endTime = the_clock::now();
+					time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+					resultsFile << "Near-Duplicate Documents\n\nDocuments:," << documents.size() << "\nPairs (comparing every pair):," << allPairs.size() << "\nTime taken to compare every pair once:," << time_taken << ",ms\n";
+					std::cout << "Comparing every pair found " << allPairs.size() << " pairs in " << time_taken << "ms.\n";
+				}
+			}
+
+			int foundCopies = 0;
+			for (const DuplicatePair& pair : duplicates)
+			{
+				if (pair.second == pair.first + pieces)
+				{
+					foundCopies++;
+				}
+			}
+			resultsFile << "Pairs (LSH):," << duplicates.size() << "\nRewritten copies found:," << foundCopies << "\nTime taken to fingerprint " << y << " times:," << fingerprint_time << ",ms\nTime taken to search " << y << " times:," << lsh_time << ",ms\n\n";
+			std::cout << "The LSH index found " << duplicates.size() << " pairs, including " << foundCopies << " of the " << copies << " rewritten copies.\nTime taken to run " << y << " times: " << fingerprint_time << "ms fingerprinting on " << threads << " threads, " << lsh_time << "ms searching.\n\n";
+		}
+
+		else if (x == 16) // If the user chose to test word and n-gram counting...
+		{
+			// The script on its own is counted in no time, so it's repeated to make a text big enough to be worth splitting between threads.
+			std::string corpus;
+			for (int i = 0; i < 32; i++)
+			{
+				corpus += largeText;
+			}
+			int threads = int(std::thread::hardware_concurrency());
+			std::cout << "\nLong length text: Counting the words and 3-grams in " << corpus.length() << " bytes made from copies of the script of the movie 'Shrek'.\n";
+
+			FrequencyCounter wordCounter;
+			FrequencyCounter gramCounter;
+			wordCounter.countWords(corpus.data(), corpus.length(), threads, true);
+			gramCounter.countNGrams(corpus.data(), corpus.length(), 3, threads);
+
+			resultsFile << "Word and N-Gram Counts\n\nWord, Occurances\n";
+			std::cout << "Most common words:\n";
+			for (const FrequencyEntry& entry : wordCounter.topK(10))
+			{
+				resultsFile << "'" << entry.text << "'," << entry.count << "\n";
+				std::cout << "'" << entry.text << "' " << entry.count << "\n";
+			}
+			resultsFile << "\n3-Gram, Occurances\n";
+			std::cout << "Most common 3-grams:\n";
+			for (const FrequencyEntry& entry : gramCounter.topK(10))
+			{
+				resultsFile << "'" << entry.text << "'," << entry.count << "\n";
+				std::cout << "'" << entry.text << "' " << entry.count << "\n";
+			}
+			std::cout << "'donkey' occurs " << wordCounter.count("donkey") << " times as a word, and 'Donkey' occurs " << gramCounter.count("Donkey") << " times anywhere.\n";
+
+			// Time the counting on one thread and then on all of them.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				FrequencyCounter counter;
+				counter.countWords(corpus.data(), corpus.length(), 1, true);
+				counter.countNGrams(corpus.data(), corpus.length(), 3, 1);
+			}
+			endTime = the_clock::now();
+			auto single_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				FrequencyCounter counter;
+				counter.countWords(corpus.data(), corpus.length(), threads, true);
+				counter.countNGrams(corpus.data(), corpus.length(), 3, threads);
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "\nDifferent words:," << wordCounter.getDistinct() << "\nDifferent 3-grams:," << gramCounter.getDistinct() << "\nTime taken to run " << y << " times (1 thread):," << single_time << ",ms\nTime taken to run " << y << " times (" << threads << " threads):," << time_taken << ",ms\n\n";
+			std::cout << "Time taken to run " << y << " times: " << single_time << "ms on 1 thread, " << time_taken << "ms on " << threads << " threads.\n\n";
+		}
+
+		else if (x == 17) // If the user chose to test the word index...
+		{
+			std::cout << "\nMedium and long length text: Indexing the words of 'Never Gonna Give You Up' and the script of the movie 'Shrek', one document per line, then searching for phrases.\n";
+			WordIndex songIndex;
+			WordIndex scriptIndex;
+			startTime = the_clock::now();
+			songIndex.build(mediumText);
+			scriptIndex.build(largeText);
+			endTime = the_clock::now();
+			auto build_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "Word Index\n\nText, Words, Different words, Documents, Postings (bytes), Index (bytes)\n";
+			resultsFile << "'Never Gonna Give You Up'," << songIndex.getTokenCount() << "," << songIndex.getTermCount() << "," << songIndex.getDocumentCount() << "," << songIndex.postingsSize() << "," << songIndex.memoryUsage() << "\n";
+			resultsFile << "'Shrek'," << scriptIndex.getTokenCount() << "," << scriptIndex.getTermCount() << "," << scriptIndex.getDocumentCount() << "," << scriptIndex.postingsSize() << "," << scriptIndex.memoryUsage() << "\n";
+			resultsFile << "Time taken to build:," << build_time << ",ms\n\nPhrase, Occurances (index), Occurances (search), First exact match\n";
+
+			// The phrases to look up, and which index and text each one is in.
+			const std::string phrases[] = { "Never gonna", "Never gonna give you up", "Lord Farquaad", "Donkey" };
+			const WordIndex* indexes[] = { &songIndex, &songIndex, &scriptIndex, &scriptIndex };
+			const std::string* texts[] = { &mediumText, &mediumText, &largeText, &largeText };
+
+			for (int p = 0; p < 4; p++)
+			{
+				// The index only matches whole words, whatever is between them, while the search matches the exact characters anywhere, so the counts can differ.
+				PhraseMatches matches = indexes[p]->phrase(phrases[p]);
+				CompiledPattern pattern(phrases[p], true);
+				size_t searched = 0;
+				for (size_t i = pattern.find(texts[p]->data(), texts[p]->length()); i != CompiledPattern::npos; i = pattern.find(texts[p]->data(), texts[p]->length(), i + 1))
+				{
+					searched++;
+				}
+				resultsFile << "'" << phrases[p] << "'," << matches.offsets.size() << "," << searched << ",";
+				std::cout << "'" << phrases[p] << "' was found " << matches.offsets.size() << " times with the index and " << searched << " times by searching";
+				if (matches.firstExact != WordIndex::npos)
+				{
+					resultsFile << matches.firstExact << "\n";
+					std::cout << ", first exactly at position " << matches.firstExact << ".\n";
+				}
+				else
+				{
+					resultsFile << "none\n";
+					std::cout << ", with no exact match.\n";
+				}
+			}
+			std::cout << "Lines with both 'Shrek' and 'Donkey': " << scriptIndex.allWords("Shrek Donkey").size() << "\n";
+
+			// Time looking the phrases up in the index against searching the whole text for them.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				for (int p = 0; p < 4; p++)
+				{
+					indexes[p]->phrase(phrases[p]);
+				}
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				for (int p = 0; p < 4; p++)
+				{
+					CompiledPattern pattern(phrases[p], true);
+					for (size_t j = pattern.find(texts[p]->data(), texts[p]->length()); j != CompiledPattern::npos; j = pattern.find(texts[p]->data(), texts[p]->length(), j + 1))
+					{
+					}
+				}
+			}
+			endTime = the_clock::now();
+			auto search_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "\nTime taken to run " << y << " times (index):," << time_taken << ",ms\nTime taken to run " << y << " times (search):," << search_time << ",ms\n\n";
+			std::cout << "Time taken to build the indexes: " << build_time << "ms.\nTime taken to run " << y << " times: " << time_taken << "ms with the index, " << search_time << "ms searching the text.\n\n";
+		}
+
+		else if (x == 18) // If the user chose to test the on-disk index...
+		{
+			// Split the script into lines, which are added to the index as documents in 8 batches so that it ends up with several segments.
+			std::vector<std::string> lines;
+			size_t lineStart = 0;
+			for (size_t i = 0; i <= largeText.length(); i++)
+			{
+				if (i == largeText.length() || largeText[i] == '\n')
+				{
+					lines.push_back(largeText.substr(lineStart, i - lineStart));
+					lineStart = i + 1;
+				}
+			}
+			std::cout << "\nLong length text: Adding the " << lines.size() << " lines of the script of the movie 'Shrek' to an index in 'shrek.index', in 8 batches.\n";
+
+			// Start from an empty index each time.
+			SegmentedIndex index;
+			index.setMergeThreshold(1000);
+			if (!index.open("shrek.index") || !index.clear())
+			{
+				std::cout << "The index couldn't be created.\n\n";
+				continue;
+			}
+			startTime = the_clock::now();
+			for (int batch = 0; batch < 8; batch++)
+			{
+				std::vector<std::string> documents(lines.begin() + lines.size() * batch / 8, lines.begin() + lines.size() * (batch + 1) / 8);
+				index.addDocuments(documents);
+			}
+			endTime = the_clock::now();
+			auto build_time = duration_cast<milliseconds>(endTime - startTime).count();
+			size_t segmentsBefore = index.getSegmentCount();
+
+			// Merge in the background, searching the old segments while it runs.
+			startTime = the_clock::now();
+			index.startMerge();
+			size_t searchesDuringMerge = 0;
+			while (index.isMerging())
+			{
+				index.find("Donkey");
+				searchesDuringMerge++;
+			}
+			bool merged = index.waitForMerge();
+			endTime = the_clock::now();
+			auto merge_time = duration_cast<milliseconds>(endTime - startTime).count();
+			index.close();
+
+			// Opening the index again only maps the files, so it's ready straight away.
+			startTime = the_clock::now();
+			index.open("shrek.index");
+			endTime = the_clock::now();
+			auto open_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+			std::vector<IndexMatch> matches = index.find("Donkey");
+			std::vector<IndexMatch> gramMatches = index.find("Donkey", true);
+			CompiledPattern pattern("Donkey");
+			size_t searched = 0;
+			for (size_t i = pattern.find(largeText.data(), largeText.length()); i != CompiledPattern::npos; i = pattern.find(largeText.data(), largeText.length(), i + 1))
+			{
+				searched++;
+			}
+			std::cout << "Segments before merging: " << segmentsBefore << ", after: " << index.getSegmentCount() << (merged ? "" : " (the merge failed)") << ", with " << searchesDuringMerge << " searches run during the merge.\n";
+			std::cout << "'Donkey' was found " << matches.size() << " times with the suffix array, " << gramMatches.size() << " times with the 3-grams and " << searched << " times by searching the text.\n";
+
+			// Time searching the index both ways against searching the text.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				index.find("Donkey");
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				index.find("Donkey", true);
+			}
+			endTime = the_clock::now();
+			auto gram_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				for (size_t j = pattern.find(largeText.data(), largeText.length()); j != CompiledPattern::npos; j = pattern.find(largeText.data(), largeText.length(), j + 1))
+				{
+				}
+			}
+			endTime = the_clock::now();
+			auto search_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "On-Disk Index\n\nDocuments:," << index.getDocumentCount() << "\nIndex size:," << index.fileSize() << ",bytes\nSegments before merging:," << segmentsBefore << "\nTime taken to add:," << build_time << ",ms\nTime taken to merge:," << merge_time << ",ms\nTime taken to open:," << open_time << ",us\n";
+			resultsFile << "Occurances of 'Donkey':," << matches.size() << "\nTime taken to run " << y << " times (suffix array):," << time_taken << ",ms\nTime taken to run " << y << " times (3-grams):," << gram_time << ",ms\nTime taken to run " << y << " times (search):," << search_time << ",ms\n\n";
+			std::cout << "Time taken to add the documents: " << build_time << "ms, to merge: " << merge_time << "ms, to open: " << open_time << "us.\n";
+			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms with the suffix array, " << gram_time << "ms with the 3-grams, " << search_time << "ms searching the text.\n\n";
+		}
+
+		else if (x == 19) // If the user chose to test search-and-replace...
+		{
+			std::cout << "\nLong length text: Replacing the names of the characters in the script of the movie 'Shrek' with '[REDACTED]', writing the result to 'Shrek_redacted.txt'.\n";
+			const std::vector<std::string> names = { "Shrek", "Donkey", "Fiona", "Farquaad" };
+			TextReplacer replacer;
+			replacer.compile(names, std::vector<std::string>(names.size(), "[REDACTED]"));
+
+			// Replace the whole text at once, then again in 64KB parts as if it was being read from a file, and check that both give the same output.
+			replacer.replaceToFile(largeText.data(), largeText.length(), "Shrek_redacted.txt");
+			size_t replaced = replacer.getReplacements();
+			const size_t partSize = 1 << 16;
+			replacer.begin("Shrek_redacted_streamed.txt");
+			for (size_t i = 0; i < largeText.length(); i += partSize)
+			{
+				replacer.feed(largeText.data() + i, std::min(partSize, largeText.length() - i));
+			}
+			replacer.finish();
+			std::string whole;
+			std::string streamed;
+			loadTextFile("Shrek_redacted.txt", whole);
+			loadTextFile("Shrek_redacted_streamed.txt", streamed);
+			std::cout << replaced << " names were replaced, and the output written in parts " << (whole == streamed ? "matches" : "doesn't match") << " the output written all at once.\n";
+
+			// Time writing the slices against building the new text in a string and writing that.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				replacer.replaceToFile(largeText.data(), largeText.length(), "Shrek_redacted.txt");
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				replacer.begin("Shrek_redacted_streamed.txt");
+				for (size_t j = 0; j < largeText.length(); j += partSize)
+				{
+					replacer.feed(largeText.data() + j, std::min(partSize, largeText.length() - j));
+				}
+				replacer.finish();
+			}
+			endTime = the_clock::now();
+			auto stream_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				std::vector<OutputSlice> slices;
+				replacer.replaceAll(largeText.data(), largeText.length(), slices);
+				std::string output;
+				for (const OutputSlice& slice : slices)
+				{
+					output.append(slice.data, slice.length);
+				}
+				std::ofstream ofs("Shrek_redacted_copy.txt", std::ios::binary);
+				ofs.write(output.data(), output.length());
+			}
+			endTime = the_clock::now();
+			auto copy_time = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "Search and Replace\n\nReplacements:," << replaced << "\nTime taken to run " << y << " times (slices):," << time_taken << ",ms\nTime taken to run " << y << " times (streamed):," << stream_time << ",ms\nTime taken to run " << y << " times (copied into a string):," << copy_time << ",ms\n\n";
+			std::cout << "Time taken to run " << y << " times: " << time_taken << "ms writing slices, " << stream_time << "ms streaming in parts, " << copy_time << "ms copying into a string first.\n\n";
+		}
+
+		else if (x == 20) // If the user chose to test finding matches one at a time...
+		{
+			std::cout << "\nLong length text: Finding occurances of 'Donkey' in the script of the movie 'Shrek' one at a time, instead of all at once.\n";
+			CompiledPattern pattern("Donkey");
+			MatchRange matches(pattern, largeText.data(), largeText.length());
+
+			// Stop after the first 5, without searching the rest of the text.
+			std::cout << "The first 5 are at positions";
+			int shown = 0;
+			for (size_t position : matches)
+			{
+				std::cout << " " << position;
+				if (++shown == 5)
+				{
+					break;
+				}
+			}
+			std::cout << ".\n";
+
+			// Count them all without storing any, and do the same for several names at once with the automaton.
+			size_t counted = 0;
+			for (size_t position : matches)
+			{
+				(void)position;
+				counted++;
+			}
+			DoubleArrayTrie automaton;
+			automaton.build({ "Shrek", "Donkey", "Fiona" });
+			size_t names = 0;
+			for (const MultiMatch& match : MultiMatchRange(automaton, largeText.data(), largeText.length()))
+			{
+				(void)match;
+				names++;
+			}
+			std::cout << "There are " << counted << " occurances of 'Donkey', and " << names << " of 'Shrek', 'Donkey' or 'Fiona'.\n";
+
+			// Time getting the first match, and every match, one at a time against filling a vector with all of them.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				*matches.begin();
+			}
+			endTime = the_clock::now();
+			auto first_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				std::vector<size_t> all;
+				pattern.findAll(largeText.data(), largeText.length(), all);
+			}
+			endTime = the_clock::now();
+			auto vector_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				for (size_t position : matches)
+				{
+					(void)position;
+				}
+			}
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+			resultsFile << "Matches One at a Time\n\nOccurances:," << counted << "\nTime taken to find the first match " << y << " times:," << first_time << ",us\nTime taken to find every match " << y << " times (one at a time):," << time_taken << ",ms\nTime taken to find every match " << y << " times (vector):," << vector_time / 1000 << ",ms\n\n";
+			std::cout << "Time taken to run " << y << " times: " << first_time << "us to the first match, " << time_taken << "ms for every match one at a time, " << vector_time / 1000 << "ms for every match into a vector.\n\n";
+		}
+
+		else if (x == 21) // If the user chose to run the scaling benchmark...
+		{
+			// The number of runs is the size of the largest text in MB. Anything less than 1 would give no text to generate keywords from.
+			if (y < 1)
+			{
+				std::cout << "\nThe largest text has to be at least 1MB.\n\n";
+				continue;
+			}
+			std::cout << "\nGenerated text: Timing every search on texts from 1KB to " << y << "MB and keywords from 1 to 1024 characters long, writing the results to 'scaling.csv'.\n";
+			ScalingBenchmark benchmark;
+			benchmark.setTextSizes(size_t(1) << 10, size_t(y) << 20);
+			benchmark.setPatternLengths(1, 1024);
+			benchmark.setCounters(counters.isOpen());
+
+			startTime = the_clock::now();
+			bool written = benchmark.run("scaling.csv");
+			endTime = the_clock::now();
+			time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+			if (!written)
+			{
+				std::cout << "'scaling.csv' couldn't be written.\n\n";
+				continue;
+			}
+
+			// Show the throughput of each search on the largest texts with a 16 character keyword. The full curves are in scaling.csv.
+			resultsFile << "Scaling Benchmark\n\nCorpus, Algorithm, Text bytes, Pattern length, Matches, Time (ms), Throughput (MB/s), Cycles, Instructions, Branch misses, L1 misses, LLC misses, IPC\n";
+			std::cout << "Throughput on the largest texts with a 16 character keyword:\n";
+			for (const ScalingResult& result : benchmark.getResults())
+			{
+				if (result.textBytes == (size_t(y) << 20) && result.patternLength == 16)
+				{
+					resultsFile << result.corpus << "," << result.algorithm << "," << result.textBytes << "," << result.patternLength << "," << result.matches << "," << result.milliseconds << "," << result.megabytesPerSecond;
+					std::cout << result.corpus << ", " << result.algorithm << ": " << result.megabytesPerSecond << "MB/s";
+
+					// The counters are for one search, and are only there if they were turned on and the machine allows it.
+					const PerfSample& counts = result.counters;
+					if (counts.any())
+					{
+						for (int e = 0; e < perfEventCount; e++)
+						{
+							resultsFile << ",";
+							if (counts.available[e])
+							{
+								resultsFile << counts.counts[e];
+							}
+						}
+						resultsFile << "," << counts.ipc();
+						std::cout << ", " << counts.ipc() << " instructions per cycle, " << counts.counts[PerfBranchMisses] << " branch misses";
+					}
+					resultsFile << "\n";
+					std::cout << "\n";
+				}
+			}
+			resultsFile << "Time taken to run the benchmark:," << time_taken << ",ms\n\n";
+			std::cout << "Time taken to run the benchmark: " << time_taken << "ms, with " << benchmark.getResults().size() << " results written to 'scaling.csv'.\n\n";
+		}
+
+		else if (x == 23) // If the user chose to count the memory allocations made by each search...
+		{
+			std::cout << "\nLong length text: Counting the memory allocations made by each search for 'Shrek' in the script of the movie 'Shrek'.\n";
+			std::string kw = "Shrek";
+			CompiledPattern pattern(kw);
+			DoubleArrayTrie automaton;
+			automaton.build({ kw });
+			std::vector<size_t> positions;
+			std::vector<MultiMatch> multiMatches;
+			size_t count = 0;
+
+			// The original searches take the keyword and text by value and return a new vector each time. The compiled searches can put their matches in
+			// a vector that is kept between calls, or find them one at a time without storing them at all.
+			std::vector<std::pair<std::string, std::function<void()>>> searches;
+			searches.push_back(std::make_pair("Boyer-Moore", [&]() { stringSearcher.searchBoyerMoore(kw, largeText); }));
+			searches.push_back(std::make_pair("Rabin-Karp", [&]() { stringSearcher.searchRabinKarp(kw, largeText); }));
+			searches.push_back(std::make_pair("Compiled Boyer-Moore (new vector each time)", [&]()
+			{
+				std::vector<size_t> fresh;
+				pattern.findAll(largeText.data(), largeText.length(), fresh);
+			}));
+			searches.push_back(std::make_pair("Compiled Boyer-Moore (vector kept between searches)", [&]()
+			{
+				positions.clear();
+				pattern.findAll(largeText.data(), largeText.length(), positions);
+			}));
+			searches.push_back(std::make_pair("Compiled Boyer-Moore (MatchRange)", [&]()
+			{
+				for (size_t position : MatchRange(pattern, largeText.data(), largeText.length()))
+				{
+					count += position != CompiledPattern::npos;
+				}
+			}));
+			searches.push_back(std::make_pair("Aho-Corasick (vector kept between searches)", [&]()
+			{
+				multiMatches.clear();
+				automaton.search(largeText.data(), largeText.length(), multiMatches);
+			}));
+			searches.push_back(std::make_pair("Aho-Corasick (MultiMatchRange)", [&]()
+			{
+				for (const MultiMatch& match : MultiMatchRange(automaton, largeText.data(), largeText.length()))
+				{
+					count += match.pattern >= 0;
+				}
+			}));
+
+			resultsFile << "Memory Allocations\n\nSearch, Allocations per search, Bytes per search\n";
+			for (const auto& search : searches)
+			{
+				AllocationStats stats = countAllocations(search.second, y);
+				double allocations = y > 0 ? double(stats.allocations) / y : 0;
+				uint64_t bytes = y > 0 ? stats.bytes / uint64_t(y) : 0;
+				resultsFile << search.first << "," << allocations << "," << bytes << "\n";
+				std::cout << search.first << ": " << allocations << " allocations, " << bytes << " bytes per search.\n";
+			}
+			resultsFile << "\n";
+			std::cout << "\n";
+		}
+
+		else if (x == 24) // If the user chose to compare searching with and without per-thread arenas...
+		{
+			// Queries with a mix of a few matches and a great many, since it's queries with lots of matches that grow their vectors the most.
+			// The song is short, so the time goes on handling each query rather than on the search itself, as it does on a busy server.
+			const std::vector<std::string> keywords = { "Never gonna", "you", "e", " ", "give", "a", "up", "o" };
+			std::vector<CompiledPattern> patterns;
+			for (const std::string& kw : keywords)
+			{
+				patterns.push_back(CompiledPattern(kw));
+			}
+			std::cout << "\nMedium length text: Running " << y << " rounds of " << keywords.size() << " queries on the song 'Never Gonnna Give You Up' by Rick Astley, with and without per-thread arenas.\n";
+			resultsFile << "Match Lists With and Without Per-Thread Arenas\n\nMatch lists, Queries, Time (ms), Queries per second, Allocations per query\n";
+
+			// The three ways of keeping a query's matches: a new vector for every query, a vector in the thread's arena that is reset between queries,
+			// and a vector from the thread's pool that keeps its room between queries.
+			ThreadArena& arena = ThreadArena::local();
+			size_t count = 0;
+			const char* listNames[] = { "New vector for each query", "Per-thread arena", "Per-thread buffer pool" };
+			for (int list = 0; list < 3; list++)
+			{
+				std::function<void(const CompiledPattern&)> query;
+				switch (list)
+				{
+				case 0:
+					query = [&](const CompiledPattern& pattern)
+					{
+						std::vector<size_t> matches;
+						for (size_t i = pattern.find(mediumText.data(), mediumText.length()); i != CompiledPattern::npos; i = pattern.find(mediumText.data(), mediumText.length(), i + 1))
+						{
+							matches.push_back(i);
+						}
+						count += matches.size();
+					};
+					break;
+				case 1:
+					query = [&](const CompiledPattern& pattern)
+					{
+						arena.reset();
+						ArenaVector<size_t> matches{ ArenaAllocator<size_t>(arena) };
+						for (size_t i = pattern.find(mediumText.data(), mediumText.length()); i != CompiledPattern::npos; i = pattern.find(mediumText.data(), mediumText.length(), i + 1))
+						{
+							matches.push_back(i);
+						}
+						count += matches.size();
+					};
+					break;
+				default:
+					query = [&](const CompiledPattern& pattern)
+					{
+						PooledBuffer matches;
+						for (size_t i = pattern.find(mediumText.data(), mediumText.length()); i != CompiledPattern::npos; i = pattern.find(mediumText.data(), mediumText.length(), i + 1))
+						{
+							matches->push_back(i);
+						}
+						count += matches->size();
+					};
+					break;
+				}
+
+				// One round first, so that the arena and the pool have grown before the timing starts.
+				for (const CompiledPattern& pattern : patterns)
+				{
+					query(pattern);
+				}
+
+				AllocationTracker tracker;
+				startTime = the_clock::now();
+				for (int i = 0; i < y; i++)
+				{
+					for (const CompiledPattern& pattern : patterns)
+					{
+						query(pattern);
+					}
+				}
+				endTime = the_clock::now();
+				AllocationStats stats = tracker.stop();
+				time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+				size_t queryCount = patterns.size() * size_t(std::max(y, 0));
+				double queriesPerSecond = time_taken > 0 ? double(queryCount) * 1000 / time_taken : 0;
+				double allocations = queryCount > 0 ? double(stats.allocations) / queryCount : 0;
+				resultsFile << listNames[list] << "," << queryCount << "," << time_taken << "," << queriesPerSecond << "," << allocations << "\n";
+				std::cout << listNames[list] << ": " << time_taken << "ms, " << queriesPerSecond << " queries/s, " << allocations << " allocations per query.\n";
+			}
+
+			// Repeat on the search server, where the queries run on its worker threads and every query also pays for its task and its response.
+			// The result cache is turned off, since it would answer every query after the first round without searching at all.
+			SearchServer server;
+			server.setCacheBudget(0);
+			if (server.addCorpus("rickroll", "rickroll.txt"))
+			{
+				std::vector<SearchQuery> queries;
+				for (int i = 0; i < 64; i++)
+				{
+					queries.push_back({ 0, 0, keywords[i % keywords.size()] });
+				}
+
+				const char* settingNames[] = { "Search server, grown one match at a time", "Search server, per-thread arena" };
+				for (int setting = 0; setting < 2; setting++)
+				{
+					server.setUseArena(setting == 1);
+					server.answer(queries);
+
+					int batches = std::max(1, y / 8);
+					startTime = the_clock::now();
+					for (int i = 0; i < batches; i++)
+					{
+						server.answer(queries);
+					}
+					endTime = the_clock::now();
+					time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+					size_t queryCount = queries.size() * size_t(batches);
+					double queriesPerSecond = time_taken > 0 ? double(queryCount) * 1000 / time_taken : 0;
+					resultsFile << settingNames[setting] << "," << queryCount << "," << time_taken << "," << queriesPerSecond << ",\n";
+					std::cout << settingNames[setting] << ": " << time_taken << "ms, " << queriesPerSecond << " queries/s.\n";
+				}
+			}
+			resultsFile << "\n";
+			std::cout << "\n";
+		}
+
+		else if (x == 25) // If the user chose to compare keywords compiled at build time with keywords compiled at run time...
+		{
+			// The keywords are written out as characters because they're template parameters, so the compiler builds their skip tables and unrolls their comparisons.
+			typedef FixedPattern<'S', 'h', 'r', 'e', 'k'> ShrekPattern;
+			typedef FixedPattern<'D', 'o', 'n', 'k', 'e', 'y'> DonkeyPattern;
+			std::cout << "\nLong length text: Searching for 'Shrek' and 'Donkey' in the script of the movie 'Shrek', with the keywords compiled at build time and at run time.\n";
+
+			// Find the matches both ways once before any timing, to check they're the same and so that neither timed loop is the first to read the text.
+			std::vector<size_t> fixedResults, compiledResults;
+			ShrekPattern::findAll(largeText.data(), largeText.length(), fixedResults);
+			DonkeyPattern::findAll(largeText.data(), largeText.length(), fixedResults);
+			CompiledPattern shrek("Shrek");
+			CompiledPattern donkey("Donkey");
+			shrek.findAll(largeText.data(), largeText.length(), compiledResults);
+			donkey.findAll(largeText.data(), largeText.length(), compiledResults);
+
+			// The two should always find the same matches, since the skip tables are the same.
+			bool same = fixedResults == compiledResults;
+			size_t matches = fixedResults.size();
+
+			// Making the run time patterns is timed on its own, since a program that only knew the keyword when it ran would have to do it, but only once per keyword.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				shrek.compile("Shrek");
+				donkey.compile("Donkey");
+			}
+			endTime = the_clock::now();
+			auto compile_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+			// Both searches are timed with their patterns already made.
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				compiledResults.clear();
+				shrek.findAll(largeText.data(), largeText.length(), compiledResults);
+				donkey.findAll(largeText.data(), largeText.length(), compiledResults);
+			}
+			endTime = the_clock::now();
+			auto compiled_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+			startTime = the_clock::now();
+			for (int i = 0; i < y; i++)
+			{
+				fixedResults.clear();
+				ShrekPattern::findAll(largeText.data(), largeText.length(), fixedResults);
+				DonkeyPattern::findAll(largeText.data(), largeText.length(), fixedResults);
+			}
+			endTime = the_clock::now();
+			auto fixed_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+			resultsFile << "Keywords Compiled at Build Time\n\nOccurances:," << matches << "\nSame matches as run time:," << (same ? "Yes" : "No")
+				<< "\nTime taken to compile " << y << " times (run time patterns):," << compile_time
+				<< ",us\nTime taken to run " << y << " times (compiled at run time):," << compiled_time << ",us\nTime taken to run " << y << " times (compiled at build time):," << fixed_time << ",us\n\n";
+			std::cout << matches << " occurances" << (same ? "" : ", but the run time pattern found different matches") << ".\n"
+				<< "Time taken to run " << y << " times: " << compiled_time << "us compiled at run time (plus " << compile_time << "us to compile), " << fixed_time << "us compiled at build time.\n\n";
+		}
+
+		else if (x == 26) // If the user chose to test keywords with wildcards and gaps...
+		{
+			// Each wildcard pattern is timed next to the plain keyword it's most like, to show how close to a literal search it gets.
+			struct WildcardTest
+			{
+				std::string pattern;
+				std::string literal;
+				const std::string* text;
+				std::string textName;
+			};
+
+			// A 'b' then twelve 'a's with up to 40 characters between each, in a 'b' followed by 420 'a's. Almost every end has a huge number of ways the gaps
+			// could be filled in, which is the case where working out where each match starts has to remember where it has already failed.
+			std::string manyGaps = "b";
+			for (int i = 0; i < 12; i++)
+			{
+				manyGaps += ".{0,40}a";
+			}
+			const std::string manyWaysText = "b" + std::string(420, 'a');
+
+			const std::vector<WildcardTest> tests = {
+				{ "N?ver g?nna", "Never gonna", &mediumText, "the song 'Never Gonnna Give You Up' by Rick Astley" },
+				{ "Sh?ek", "Shrek", &largeText, "the script of the movie 'Shrek'" },
+				{ "Shrek.{0,16}Donkey", "Shrek", &largeText, "the script of the movie 'Shrek'" },
+				{ manyGaps, "b", &manyWaysText, "a 'b' followed by 420 'a's" }
+			};
+
+			resultsFile << "Wildcards and Gaps\n\n";
+			std::vector<WildcardMatch> wildcardResults;
+			std::vector<size_t> literalResults;
+			for (const WildcardTest& test : tests)
+			{
+				WildcardPattern wildcard(test.pattern);
+				CompiledPattern literal(test.literal);
+				const std::string& text = *test.text;
+				std::cout << "\nSearching for how many matches of '" << test.pattern << "' are in " << test.textName << ".\n";
+
+				wildcardResults.clear();
+				wildcard.findAll(text.data(), text.length(), wildcardResults);
+				resultsFile << "Pattern, Position, Length\n";
+				if (wildcardResults.size() > largeResultSet)
+				{
+					resultsFile << "'" << test.pattern << "',too many to list\n";
+				}
+				else
+				{
+					for (const WildcardMatch& match : wildcardResults)
+					{
+						resultsFile << "'" << test.pattern << "'," << match.position << "," << match.length << "\n";
+					}
+				}
+				resultsFile << "Occurances:," << wildcardResults.size() << "\n";
+
+				startTime = the_clock::now();
+				for (int i = 0; i < y; i++)
+				{
+					wildcardResults.clear();
+					wildcard.findAll(text.data(), text.length(), wildcardResults);
+				}
+				endTime = the_clock::now();
+				auto wildcard_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+				startTime = the_clock::now();
+				for (int i = 0; i < y; i++)
+				{
+					literalResults.clear();
+					literal.findAll(text.data(), text.length(), literalResults);
+				}
+				endTime = the_clock::now();
+				auto literal_time = duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+				resultsFile << "Time taken to run " << y << " times:," << wildcard_time << ",us\nTime taken to search for '" << test.literal << "' " << y << " times:," << literal_time << ",us\n\n";
+				std::cout << wildcardResults.size() << " occurances.\nTime taken to run " << y << " times: " << wildcard_time << "us, against " << literal_time << "us for '" << test.literal << "' with Boyer-Moore.\n";
+			}
+			std::cout << "\n";
+		}
+
+		else if (x == 27) // If the user chose to test the search server's result cache...
+		{
+			// A dashboard asks for the same few hundred keywords over and over, some much more often than others. The keywords are the first 300 different words
+			// in the script, and each query picks one with the lower numbers more likely, so the popular ones are asked for far more often than the rest.
+			std::vector<std::string> dashboardWords;
+			std::string word;
+			for (size_t i = 0; i < largeText.length() && dashboardWords.size() < 300; i++)
+			{
+				if (isalpha((unsigned char)largeText[i]))
+				{
+					word += largeText[i];
+				}
+				else
+				{
+					if (word.length() >= 3 && std::find(dashboardWords.begin(), dashboardWords.end(), word) == dashboardWords.end())
+					{
+						dashboardWords.push_back(word);
+					}
+					word.clear();
+				}
+			}
+			if (dashboardWords.empty())
+			{
+				std::cout << "\nThere are no words in Shrek.txt to search for.\n\n";
+				continue;
+			}
+
+			std::mt19937 random(1);
+			std::uniform_real_distribution<double> pick(0, 1);
+			// A negative number of runs is taken as 0, the same as the other options, rather than as a huge number of batches.
+			std::vector<std::vector<SearchQuery>> batches(size_t(std::max(y, 0)));
+			for (std::vector<SearchQuery>& batch : batches)
+			{
+				for (int q = 0; q < 64; q++)
+				{
+					double u = pick(random);
+					batch.push_back({ 0, 0, dashboardWords[size_t(u * u * u * dashboardWords.size())] });
+				}
+			}
+			std::cout << "\nLong length text: Sending " << y << " batches of 64 queries for " << dashboardWords.size() << " different words in the script of the movie 'Shrek', with and without the result cache.\n";
+
+			resultsFile << "Search Server Result Cache\n\nCache, Queries, Time (ms), Queries per second, Hit rate, Entries, Memory (bytes)\n";
+			const char* cacheNames[] = { "Off", "On (64MB)" };
+			for (int setting = 0; setting < 2; setting++)
+			{
+				SearchServer server;
+				if (!server.addCorpus("shrek", "Shrek.txt"))
+				{
+					std::cout << "Couldn't map Shrek.txt.\n\n";
+					break;
+				}
+				server.setCacheBudget(setting == 0 ? 0 : size_t(64) << 20);
+
+				startTime = the_clock::now();
+				for (const std::vector<SearchQuery>& batch : batches)
+				{
+					server.answer(batch);
+				}
+				endTime = the_clock::now();
+				time_taken = duration_cast<milliseconds>(endTime - startTime).count();
+
+				CacheStats stats = server.getCacheStats();
+				double queriesPerSecond = time_taken > 0 ? 64.0 * y * 1000 / time_taken : 0;
+				resultsFile << cacheNames[setting] << "," << 64 * y << "," << time_taken << "," << queriesPerSecond << "," << stats.hitRate() << "," << stats.entries << "," << stats.bytes << "\n";
+				std::cout << "Cache " << cacheNames[setting] << ": " << time_taken << "ms, " << queriesPerSecond << " queries/s";
+				if (setting == 1)
+				{
+					std::cout << ", " << stats.hitRate() * 100 << "% hit rate, " << stats.entries << " entries in " << stats.bytes << " bytes";
+				}
+				std::cout << ".\n";
+			}
+
+			// Change a corpus's file without telling the server, to check that it notices and throws away the results cached for the old contents rather than giving them out again.
+			std::ofstream("cache_test.txt") << mediumText;
+			SearchServer server;
+			if (server.addCorpus("song", "cache_test.txt"))
+			{
+				std::vector<SearchQuery> query = { { 0, 0, "Never gonna" } };
+				uint64_t before = server.answer(query)[0].count;
+				server.answer(query);
+				std::ofstream("cache_test.txt") << mediumText << mediumText;
+				uint64_t after = server.answer(query)[0].count;
+				CacheStats stats = server.getCacheStats();
+
+				resultsFile << "Occurances before the file changed:," << before << "\nOccurances after the file changed:," << after << "\nEntries thrown away:," << stats.invalidations << "\n";
+				std::cout << "After doubling the song's file, 'Never gonna' went from " << before << " to " << after << " occurances, with " << stats.invalidations << " cached result thrown away.\n";
+			}
+			remove("cache_test.txt");
+			resultsFile << "\n";
+			std::cout << "\n";
 		}
 
 	} while (x != 5);
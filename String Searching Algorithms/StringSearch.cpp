@@ -1,5 +1,8 @@
 #include "StringSearch.h"
 #include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
 
 using std::chrono::duration_cast;
 using std::chrono::milliseconds;
@@ -11,6 +14,8 @@ StringSearch::StringSearch()
 {
 	// Algorithm text output is disabled by default.
 	textToggle = false;
+	teddyBuilt = false;
+	teddyIgnoreCase = false;
 }
 
 StringSearch::~StringSearch()
@@ -38,7 +43,7 @@ std::vector<int> StringSearch::searchBoyerMoore(std::string kw, std::string t)
 	// For each character in the keyword, change the lookup table's value to be true.
 	for (char c: keyword)
 	{
-		inKeyword[int(c)] = true;
+		inKeyword[(unsigned char)c] = true;
 	}
 
 	// If the character's not in the keyword, it can skip the whole word.
@@ -50,14 +55,15 @@ std::vector<int> StringSearch::searchBoyerMoore(std::string kw, std::string t)
 	// If the character is in the keyword, it can skip forward the rest of the keyword's length.
 	for (int i = 0; i < keyLength; i++)
 	{
-		skip[int(keyword[i])] = (keyLength - 1) - i;
+		skip[(unsigned char)keyword[i]] = (keyLength - 1) - i;
 	}
 
-	// Look for the keyword in the text
-	for (int i = 0; i < textLength - keyLength; i++)
+	// Look for the keyword in the text. The characters are looked up as unsigned, since a char above 127 would otherwise be a negative index.
+	// The last place the keyword can start is textLength - keyLength, so a match that ends on the last character is found too.
+	for (int i = 0; i <= textLength - keyLength; i++)
 	{
 		// Set s to the correct value in the skip lookup table.
-		int s = skip[int(text[i + keyLength - 1])];
+		int s = skip[(unsigned char)text[i + keyLength - 1]];
 
 		// If there isn't any matches, skip forwards.
 		if (s != 0)
@@ -67,7 +73,7 @@ std::vector<int> StringSearch::searchBoyerMoore(std::string kw, std::string t)
 		}
 
 		// If there isn't any matches in this part of the text, skip forward.
-		else if (!inKeyword[int(text[i + keyLength - 1])])
+		else if (!inKeyword[(unsigned char)text[i + keyLength - 1]])
 		{
 			i += keyLength - 1;
 			continue;
@@ -126,19 +132,16 @@ std::vector<int> StringSearch::searchRabinKarp(std::string kw, std::string t)
 	results.clear();
 	occurances = 0;
 
-	// Look for the keyword in the text
-	for (int i = 0; i < textLength - keyLength; i++)
+	// Look for the keyword in the text, up to and including the last place it can start.
+	for (int i = 0; i <= textLength - keyLength; i++)
 	{
-		a = hash(text[i]); // hash of the first letter being searched
-		b = hash(text[i + keyLength]); // hash of the letter after the last in the rolling hash
-		
 		//std::cout << keyword << " hash: " << keyHash << ". " << text.substr(i, keyLength) << " hash: " << rollingHash << ".\n";
 
 		// Check if hashes match
 		if (rollingHash == keyHash)
 		{
-			// If the substring matches the keyword, the keyword has been found
-			if (text.substr(i, keyLength) == keyword)
+			// If the substring matches the keyword, the keyword has been found. Comparing in place means a hash collision doesn't have to copy the substring out first.
+			if (text.compare(i, keyLength, keyword) == 0)
 			{
 				if (textToggle)
 				{
@@ -148,6 +151,14 @@ std::vector<int> StringSearch::searchRabinKarp(std::string kw, std::string t)
 			}
 		}
 
+		// There's no letter after the last place the keyword can start, so the hash only needs to roll before then.
+		if (i == textLength - keyLength)
+		{
+			break;
+		}
+
+		a = hash(text[i]); // hash of the first letter being searched
+		b = hash(text[i + keyLength]); // hash of the letter after the last in the rolling hash
 		rollingHash = rollingHash - a + b; // Calculate the new value of the rolling hash by subtracting the hash of the first letter and adding the hash of the next letter.
 	}
 
@@ -169,6 +180,223 @@ std::vector<int> StringSearch::searchRabinKarp(std::string kw, std::string t)
 	return results;
 }
 
+std::vector<MultiMatch> StringSearch::searchRabinKarp(const std::vector<std::string>& kws, const std::string& t)
+{
+	std::vector<MultiMatch> multiResults;
+	const char* data = t.data();
+	size_t length = t.length();
+
+	// Find each distinct keyword length. Keywords that are empty or longer than the text can never be found, so they are left out.
+	patternLengths.clear();
+	for (const std::string& k : kws)
+	{
+		if (!k.empty() && k.length() <= length)
+		{
+			patternLengths.push_back(k.length());
+		}
+	}
+	std::sort(patternLengths.begin(), patternLengths.end());
+	patternLengths.erase(std::unique(patternLengths.begin(), patternLengths.end()), patternLengths.end());
+
+	if (patternLengths.empty())
+	{
+		return multiResults;
+	}
+
+	// Fill a hash set for each length with the fingerprints of the keywords of that length.
+	size_t groups = patternLengths.size();
+	lengthSets.resize(groups);
+	lengthHashes.resize(groups);
+	std::vector<size_t> groupSizes(groups, 0);
+	for (const std::string& k : kws)
+	{
+		if (!k.empty() && k.length() <= length)
+		{
+			groupSizes[std::lower_bound(patternLengths.begin(), patternLengths.end(), k.length()) - patternLengths.begin()]++;
+		}
+	}
+	for (size_t g = 0; g < groups; g++)
+	{
+		lengthSets[g].reset(groupSizes[g]);
+		lengthHashes[g].setWindow(patternLengths[g]);
+		lengthHashes[g].init(data);
+	}
+	for (int p = 0; p < int(kws.size()); p++)
+	{
+		if (!kws[p].empty() && kws[p].length() <= length)
+		{
+			size_t g = std::lower_bound(patternLengths.begin(), patternLengths.end(), kws[p].length()) - patternLengths.begin();
+			lengthSets[g].insert(RollingHash::hashOf(kws[p].data(), kws[p].length()), p);
+		}
+	}
+
+	// Go through the text once. At each position, every length's rolling hash is checked against its set and then rolled forward by one character.
+	size_t last = length - patternLengths[0];
+	for (size_t i = 0; i <= last; i++)
+	{
+		for (size_t g = 0; g < groups; g++)
+		{
+			size_t keyLen = patternLengths[g];
+
+			// Lengths are sorted, so if this window runs off the end of the text, so will all the longer ones.
+			if (i + keyLen > length)
+			{
+				break;
+			}
+
+			// A matching fingerprint might be a collision, so the text is compared against every keyword that has it.
+			for (int p = lengthSets[g].find(lengthHashes[g].value()); p != -1; p = lengthSets[g].next(p))
+			{
+				if (memcmp(data + i, kws[p].data(), keyLen) == 0)
+				{
+					if (textToggle)
+					{
+						std::cout << "Found " << kws[p] << "!\n";
+					}
+					multiResults.push_back({ i, p });
+				}
+			}
+
+			if (i + keyLen < length)
+			{
+				lengthHashes[g].roll(data[i], data[i + keyLen]);
+			}
+		}
+	}
+
+	if (textToggle)
+	{
+		// Display how many times the keywords were found.
+		std::cout << "\n" << kws.size() << " keyword(s) were found " << multiResults.size() << " time(s).\n\n";
+	}
+
+	return multiResults;
+}
+
+std::vector<MultiMatch> StringSearch::searchMultiple(const std::vector<std::string>& kws, const std::string& t, MultiStrategy strategy)
+{
+	std::vector<MultiMatch> multiResults;
+
+	if (strategy == MultiStrategy::Teddy)
+	{
+		if (!teddyBuilt || teddyIgnoreCase || teddyKeywords != kws)
+		{
+			teddyKeywords = kws;
+			teddyIgnoreCase = false;
+			teddyBuilt = teddy.build(kws);
+		}
+
+		// Teddy only works for small sets of keywords, so anything bigger goes to the automaton instead.
+		if (teddyBuilt)
+		{
+			teddy.search(t.data(), t.length(), multiResults);
+			return multiResults;
+		}
+		strategy = MultiStrategy::AhoCorasick;
+	}
+
+	if (strategy == MultiStrategy::RabinKarp)
+	{
+		return searchRabinKarp(kws, t);
+	}
+
+	if (automaton.getKeywordCount() == 0 || automatonKeywords != kws)
+	{
+		automatonKeywords = kws;
+		automaton.build(kws);
+
+		// The automaton only reports the first copy of a keyword that is in the list more than once, so keep a chain of the other copies to add them back in.
+		automatonDuplicates.assign(kws.size(), -1);
+		std::unordered_map<std::string, int> lastCopy;
+		for (int p = 0; p < int(kws.size()); p++)
+		{
+			auto found = lastCopy.find(kws[p]);
+			if (found != lastCopy.end())
+			{
+				automatonDuplicates[found->second] = p;
+				found->second = p;
+			}
+			else
+			{
+				lastCopy[kws[p]] = p;
+			}
+		}
+	}
+	automaton.search(t.data(), t.length(), multiResults);
+
+	size_t found = multiResults.size();
+	for (size_t i = 0; i < found; i++)
+	{
+		for (int p = automatonDuplicates[multiResults[i].pattern]; p != -1; p = automatonDuplicates[p])
+		{
+			multiResults.push_back({ multiResults[i].position, p });
+		}
+	}
+
+	// The automaton finds matches in the order they end, so shorter keywords can come out before longer ones that started earlier.
+	std::sort(multiResults.begin(), multiResults.end(), [](const MultiMatch& x, const MultiMatch& y)
+	{
+		return x.position != y.position ? x.position < y.position : x.pattern < y.pattern;
+	});
+	return multiResults;
+}
+
+std::vector<int> StringSearch::searchBoyerMooreIgnoreCase(const std::string& kw, const std::string& t)
+{
+	results.clear();
+
+	// The skip table has both cases of each letter in the keyword, so the text is folded one character at a time as it is compared.
+	caselessPattern.compile(kw, true);
+	for (size_t i = caselessPattern.find(t.data(), t.length()); i != CompiledPattern::npos; i = caselessPattern.find(t.data(), t.length(), i + 1))
+	{
+		if (textToggle)
+		{
+			std::cout << "Found " << t.substr(i, kw.length()) << "!\n";
+		}
+		results.push_back(int(i));
+	}
+
+	if (textToggle)
+	{
+		std::cout << "\n'" << kw << "' was found " << results.size() << " time(s) ignoring case.\n\n";
+	}
+
+	return results;
+}
+
+std::vector<MultiMatch> StringSearch::searchTeddyIgnoreCase(const std::vector<std::string>& kws, const std::string& t)
+{
+	std::vector<MultiMatch> multiResults;
+
+	if (!teddyBuilt || !teddyIgnoreCase || teddyKeywords != kws)
+	{
+		teddyKeywords = kws;
+		teddyIgnoreCase = true;
+		teddyBuilt = teddy.build(kws, true);
+	}
+
+	if (teddyBuilt)
+	{
+		teddy.search(t.data(), t.length(), multiResults);
+		return multiResults;
+	}
+
+	// Too many keywords for Teddy, so search for each one with the case-insensitive Boyer-Moore instead.
+	for (int p = 0; p < int(kws.size()); p++)
+	{
+		CompiledPattern pattern(kws[p], true);
+		for (size_t i = pattern.find(t.data(), t.length()); i != CompiledPattern::npos; i = pattern.find(t.data(), t.length(), i + 1))
+		{
+			multiResults.push_back({ i, p });
+		}
+	}
+	std::sort(multiResults.begin(), multiResults.end(), [](const MultiMatch& x, const MultiMatch& y)
+	{
+		return x.position != y.position ? x.position < y.position : x.pattern < y.pattern;
+	});
+	return multiResults;
+}
+
 int StringSearch::hash(std::string s) // Polynomial rolling hash. Should be O(n) complexity where n is length of the string. When rolling the hash, you're just adding and taking away 1 letter, which is O(1). Implementation of formula 'H = c1a^k-1 + c2a^k-2 + c3a^k-3 ... + cka^0'. 
 {
 	int h = 0;
@@ -3,6 +3,20 @@
 #include <list>
 #include <vector>
 #include <cmath>
+#include "SearchTypes.h"
+#include "RollingHash.h"
+#include "FingerprintSet.h"
+#include "DoubleArrayTrie.h"
+#include "TeddyPrefilter.h"
+#include "CompiledPattern.h"
+
+// The algorithms that can be used when searching for several keywords at once.
+enum class MultiStrategy
+{
+	RabinKarp,		// One rolling hash per keyword length. Suits thousands of keywords with only a few different lengths.
+	AhoCorasick,	// Double-array automaton. Suits very large dictionaries.
+	Teddy			// SIMD nibble-mask prefilter. Suits up to 64 short keywords.
+};
 
 // This class contains both the Boyer-Moore and Rabin-Karp algorithms.
 class StringSearch
@@ -16,6 +30,19 @@ public:
 	std::vector<int> searchBoyerMoore(std::string kw, std::string t);
 	std::vector<int> searchRabinKarp(std::string kw, std::string t);
 
+	// Multi-pattern version of Rabin-Karp for searching for thousands of keywords in one pass through the text.
+	// Keywords are grouped by length, and each distinct length has its own rolling hash that is looked up in a hash set of that length's keyword fingerprints.
+	std::vector<MultiMatch> searchRabinKarp(const std::vector<std::string>& kws, const std::string& t);
+
+	// Case-insensitive (ASCII) versions of Boyer-Moore and Teddy. Case is folded inside the skip table and the comparisons, so the text isn't copied.
+	// For a text that is searched case-insensitively over and over, FoldedText keeps a lower case copy instead.
+	std::vector<int> searchBoyerMooreIgnoreCase(const std::string& kw, const std::string& t);
+	std::vector<MultiMatch> searchTeddyIgnoreCase(const std::vector<std::string>& kws, const std::string& t);
+
+	// Searches for several keywords at once using the chosen strategy. The results are in the order that the keywords start in the text.
+	// The automaton and the Teddy tables are only rebuilt when the keywords change. Teddy falls back to Aho-Corasick for more than 64 keywords.
+	std::vector<MultiMatch> searchMultiple(const std::vector<std::string>& kws, const std::string& t, MultiStrategy strategy);
+
 	// Hashing algorithms for hashing a specified string or char. Only used in the Rabin-Karp algorithm.
 	int hash(std::string s);
 	int hash(char c);
@@ -43,6 +70,24 @@ protected:
 	int a;
 	int b;
 
+	// Used by the multi-pattern Rabin-Karp search. Each distinct keyword length has a hash set of the fingerprints of the keywords with that length.
+	// They are kept between searches so that the tables don't have to be allocated again each time.
+	std::vector<size_t> patternLengths;
+	std::vector<FingerprintSet> lengthSets;
+	std::vector<RollingHash> lengthHashes;
+
+	// The other multi-pattern strategies, and the keywords they were last built for.
+	DoubleArrayTrie automaton;
+	std::vector<std::string> automatonKeywords;
+	std::vector<int> automatonDuplicates;
+	TeddyPrefilter teddy;
+	std::vector<std::string> teddyKeywords;
+	bool teddyBuilt;
+	bool teddyIgnoreCase;
+
+	// Used by the case-insensitive Boyer-Moore search.
+	CompiledPattern caselessPattern;
+
 	// LookUp tables used in the Boyer-Moore algorithm. Arrays were used as they have a fixed size and we are only interested in looking at 256 characters. Using a fixed-size structure also means we know exactly how much memory has been allocated to it and each element in the array will be next to each other in memory allowing for quicker access.
 	bool inKeyword[256];
 	int skip[256];
@@ -0,0 +1,246 @@
+#include "TeddyPrefilter.h"
+#include <algorithm>
+#include <cstring>
+#include "CaseFolding.h"
+
+// The SIMD scan needs SSSE3 for the shuffle instruction (pshufb). Visual Studio allows the intrinsics anywhere, while GCC and Clang
+// need the function to be marked as using SSSE3, and the CPU is checked when the program runs before it is called.
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define TEDDY_SIMD 1
+#define TEDDY_TARGET
+#include <intrin.h>
+#include <tmmintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TEDDY_SIMD 1
+#define TEDDY_TARGET __attribute__((target("ssse3")))
+#include <tmmintrin.h>
+#else
+#define TEDDY_SIMD 0
+#endif
+
+// Index of the lowest set bit.
+static inline int lowestBit(unsigned x)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return int(index);
+#else
+	return __builtin_ctz(x);
+#endif
+}
+
+TeddyPrefilter::TeddyPrefilter()
+{
+	prefixLength = 0;
+	caseless = false;
+	memset(lowMasks, 0, sizeof(lowMasks));
+	memset(highMasks, 0, sizeof(highMasks));
+}
+
+TeddyPrefilter::~TeddyPrefilter()
+{
+}
+
+bool TeddyPrefilter::usingSIMD()
+{
+#if TEDDY_SIMD && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 9)) != 0;
+#elif TEDDY_SIMD
+	return __builtin_cpu_supports("ssse3") != 0;
+#else
+	return false;
+#endif
+}
+
+bool TeddyPrefilter::build(const std::vector<std::string>& kws, bool ignoreCase)
+{
+	keywords = kws;
+	caseless = ignoreCase;
+	for (int b = 0; b < 8; b++)
+	{
+		buckets[b].clear();
+	}
+	memset(lowMasks, 0, sizeof(lowMasks));
+	memset(highMasks, 0, sizeof(highMasks));
+	prefixLength = 0;
+
+	// Empty keywords can't be found, so they are left out.
+	std::vector<int> order;
+	for (int i = 0; i < int(kws.size()); i++)
+	{
+		if (!kws[i].empty())
+		{
+			order.push_back(i);
+		}
+	}
+	if (order.empty() || int(order.size()) > maxKeywords)
+	{
+		return false;
+	}
+
+	// Only the characters that every keyword has can go in the tables, and more than 3 doesn't cut the candidates down much further.
+	prefixLength = 3;
+	for (int k : order)
+	{
+		prefixLength = std::min(prefixLength, int(kws[k].length()));
+	}
+
+	// Sorting first puts keywords with the same start in the same bucket, so they share bits in the tables and cause fewer false candidates.
+	std::sort(order.begin(), order.end(), [&](int x, int y) { return kws[x] < kws[y]; });
+	size_t perBucket = (order.size() + 7) / 8;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		int b = int(i / perBucket);
+		int k = order[i];
+		buckets[b].push_back(k);
+
+		for (int j = 0; j < prefixLength; j++)
+		{
+			unsigned char c = (unsigned char)kws[k][j];
+			lowMasks[j][c & 0x0F] |= uint8_t(1 << b);
+			highMasks[j][c >> 4] |= uint8_t(1 << b);
+
+			// The two cases of a letter differ in their high nibble, so each one needs its own bits.
+			if (caseless)
+			{
+				unsigned char o = otherCase(c);
+				lowMasks[j][o & 0x0F] |= uint8_t(1 << b);
+				highMasks[j][o >> 4] |= uint8_t(1 << b);
+			}
+		}
+	}
+
+	// Keep the keywords in each bucket in pattern order so that matches at the same position come out in a predictable order.
+	for (int b = 0; b < 8; b++)
+	{
+		std::sort(buckets[b].begin(), buckets[b].end());
+	}
+
+	return true;
+}
+
+void TeddyPrefilter::verify(const char* t, size_t length, size_t position, unsigned candidates, std::vector<MultiMatch>& results) const
+{
+	while (candidates != 0)
+	{
+		int b = lowestBit(candidates);
+		candidates &= candidates - 1;
+
+		for (int k : buckets[b])
+		{
+			const std::string& kw = keywords[k];
+			if (position + kw.length() > length)
+			{
+				continue;
+			}
+
+			bool found;
+			if (caseless)
+			{
+				found = true;
+				for (size_t j = 0; j < kw.length(); j++)
+				{
+					if (foldCase((unsigned char)t[position + j]) != foldCase((unsigned char)kw[j]))
+					{
+						found = false;
+						break;
+					}
+				}
+			}
+			else
+			{
+				found = memcmp(t + position, kw.data(), kw.length()) == 0;
+			}
+
+			if (found)
+			{
+				results.push_back({ position, k });
+			}
+		}
+	}
+}
+
+#if TEDDY_SIMD
+TEDDY_TARGET size_t TeddyPrefilter::searchSIMD(const char* t, size_t length, std::vector<MultiMatch>& results) const
+{
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i low[3];
+	__m128i high[3];
+	for (int j = 0; j < prefixLength; j++)
+	{
+		low[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(lowMasks[j]));
+		high[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(highMasks[j]));
+	}
+
+	alignas(16) uint8_t candidates[16];
+	size_t i = 0;
+
+	// Each pass looks at 16 starting positions. The load for the j'th character is shifted along by j, so lane k of every result lines up with position i + k.
+	while (i + 16 + prefixLength - 1 <= length)
+	{
+		__m128i result = _mm_set1_epi8(-1);
+		for (int j = 0; j < prefixLength; j++)
+		{
+			__m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + i + j));
+			__m128i lowNibbles = _mm_and_si128(text, nibbleMask);
+			__m128i highNibbles = _mm_and_si128(_mm_srli_epi16(text, 4), nibbleMask);
+			__m128i buckets = _mm_and_si128(_mm_shuffle_epi8(low[j], lowNibbles), _mm_shuffle_epi8(high[j], highNibbles));
+			result = _mm_and_si128(result, buckets);
+		}
+
+		// Any lane that isn't zero is a candidate. Most of the time there are none and we move straight on.
+		unsigned lanes = ~unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(result, zero))) & 0xFFFF;
+		if (lanes != 0)
+		{
+			_mm_store_si128(reinterpret_cast<__m128i*>(candidates), result);
+			while (lanes != 0)
+			{
+				int k = lowestBit(lanes);
+				lanes &= lanes - 1;
+				verify(t, length, i + k, candidates[k], results);
+			}
+		}
+
+		i += 16;
+	}
+
+	return i;
+}
+#else
+size_t TeddyPrefilter::searchSIMD(const char*, size_t, std::vector<MultiMatch>&) const
+{
+	return 0;
+}
+#endif
+
+void TeddyPrefilter::search(const char* t, size_t length, std::vector<MultiMatch>& results) const
+{
+	if (prefixLength == 0 || length < size_t(prefixLength))
+	{
+		return;
+	}
+
+	// The CPU check is only done once.
+	static const bool simd = usingSIMD();
+
+	size_t i = 0;
+	if (simd)
+	{
+		i = searchSIMD(t, length, results);
+	}
+
+	// Finish off the positions that are too close to the end for a full 16 byte load, or the whole text if SIMD isn't available.
+	const unsigned char* text = reinterpret_cast<const unsigned char*>(t);
+	for (; i + prefixLength <= length; i++)
+	{
+		unsigned candidates = scalarBuckets(text + i);
+		if (candidates != 0)
+		{
+			verify(t, length, i, candidates, results);
+		}
+	}
+}
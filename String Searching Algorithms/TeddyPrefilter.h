@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "SearchTypes.h"
+
+// A SIMD prefilter for small sets of keywords (up to 64), in the style of the "Teddy" algorithm from Intel's Hyperscan.
+// The keywords are split into 8 buckets, and each bucket is one bit in a byte. For each of the first few characters of the keywords there are two 16-entry tables,
+// one for the low 4 bits (nibble) of a character and one for the high nibble, holding the buckets that have a keyword with that nibble in that place.
+// A single shuffle instruction looks up 16 characters of text in one of these tables at once, and ANDing the results together leaves a bit set only where
+// a keyword in that bucket could start. Those candidate positions are then checked exactly against the keywords in the bucket.
+class TeddyPrefilter
+{
+public:
+	// The most keywords that can be handled at once. More keywords than this fill the buckets and most positions become candidates.
+	static const int maxKeywords = 64;
+
+	// Constructor and destructor.
+	TeddyPrefilter();
+	~TeddyPrefilter();
+
+	// Builds the nibble tables for the keywords. Returns false if there are no usable keywords or more than maxKeywords of them.
+	// If ignoreCase is set, both cases of each letter are put in the tables and candidates are compared case-insensitively, so the text is never folded or copied.
+	bool build(const std::vector<std::string>& keywords, bool ignoreCase = false);
+
+	// Finds every occurance of every keyword, in the order they start in the text.
+	void search(const char* t, size_t length, std::vector<MultiMatch>& results) const;
+
+	// Whether the SIMD version of the scan is being used on this machine, rather than the plain C++ fallback.
+	static bool usingSIMD();
+
+protected:
+	// Checks the keywords in the buckets set in 'buckets' against the text at a candidate position.
+	void verify(const char* t, size_t length, size_t position, unsigned buckets, std::vector<MultiMatch>& results) const;
+
+	// Works out the candidate buckets for a single position without SIMD. Used for the end of the text and on machines without SSSE3.
+	unsigned scalarBuckets(const unsigned char* t) const
+	{
+		unsigned b = 0xFF;
+		for (int j = 0; j < prefixLength; j++)
+		{
+			b &= lowMasks[j][t[j] & 0x0F] & highMasks[j][t[j] >> 4];
+		}
+		return b;
+	}
+
+	// The SSSE3 version of the main loop. Returns the position that the scalar loop should carry on from.
+	size_t searchSIMD(const char* t, size_t length, std::vector<MultiMatch>& results) const;
+
+	// The keywords, and the keywords in each bucket.
+	std::vector<std::string> keywords;
+	std::vector<int> buckets[8];
+	bool caseless;
+
+	// How many leading characters are in the tables. This is the length of the shortest keyword, up to 3.
+	int prefixLength;
+
+	// The nibble tables for each of the leading characters. 16 bytes each so that they fit in an SSE register.
+	alignas(16) uint8_t lowMasks[3][16];
+	alignas(16) uint8_t highMasks[3][16];
+};
@@ -0,0 +1,232 @@
+#include "TextEncoding.h"
+
+TextEncoding detectEncoding(const char* data, size_t length, size_t& bomLength)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+	// Check for a byte order mark first.
+	if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+	{
+		bomLength = 3;
+		return TextEncoding::UTF8;
+	}
+	if (length >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+	{
+		bomLength = 2;
+		return TextEncoding::UTF16LE;
+	}
+	if (length >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+	{
+		bomLength = 2;
+		return TextEncoding::UTF16BE;
+	}
+
+	// Without a BOM, mostly-English UTF-16 has a zero in every other byte. Zero bytes at odd positions mean little-endian, and at even positions big-endian.
+	bomLength = 0;
+	size_t sample = length < 4096 ? length : 4096;
+	size_t evenZeros = 0;
+	size_t oddZeros = 0;
+	for (size_t i = 0; i < sample; i++)
+	{
+		if (bytes[i] == 0)
+		{
+			if (i % 2 == 0)
+			{
+				evenZeros++;
+			}
+			else
+			{
+				oddZeros++;
+			}
+		}
+	}
+	if (oddZeros > sample / 4 && oddZeros > evenZeros * 4)
+	{
+		return TextEncoding::UTF16LE;
+	}
+	if (evenZeros > sample / 4 && evenZeros > oddZeros * 4)
+	{
+		return TextEncoding::UTF16BE;
+	}
+	return TextEncoding::UTF8;
+}
+
+const char* encodingName(TextEncoding encoding)
+{
+	switch (encoding)
+	{
+	case TextEncoding::UTF16LE:
+		return "UTF-16LE";
+	case TextEncoding::UTF16BE:
+		return "UTF-16BE";
+	default:
+		return "UTF-8";
+	}
+}
+
+EncodedSearch::EncodedSearch()
+{
+	encoding = TextEncoding::UTF8;
+	for (int i = 0; i < 256; i++)
+	{
+		unitSkip[i] = 0;
+	}
+}
+
+EncodedSearch::~EncodedSearch()
+{
+}
+
+void EncodedSearch::compile(const std::string& utf8Keyword, TextEncoding e)
+{
+	encoding = e;
+	utf8Pattern.compile(utf8Keyword);
+
+	// Convert the keyword from UTF-8 to UTF-16 code units. Anything that isn't valid UTF-8 becomes the replacement character U+FFFD.
+	units.clear();
+	const unsigned char* k = reinterpret_cast<const unsigned char*>(utf8Keyword.data());
+	size_t n = utf8Keyword.length();
+	for (size_t i = 0; i < n; )
+	{
+		uint32_t codePoint = 0xFFFD;
+		size_t extra = 0;
+		if (k[i] < 0x80)
+		{
+			codePoint = k[i];
+		}
+		else if ((k[i] & 0xE0) == 0xC0)
+		{
+			codePoint = k[i] & 0x1F;
+			extra = 1;
+		}
+		else if ((k[i] & 0xF0) == 0xE0)
+		{
+			codePoint = k[i] & 0x0F;
+			extra = 2;
+		}
+		else if ((k[i] & 0xF8) == 0xF0)
+		{
+			codePoint = k[i] & 0x07;
+			extra = 3;
+		}
+
+		size_t j = 1;
+		for (; j <= extra; j++)
+		{
+			if (i + j >= n || (k[i + j] & 0xC0) != 0x80)
+			{
+				codePoint = 0xFFFD;
+				break;
+			}
+			codePoint = (codePoint << 6) | (k[i + j] & 0x3F);
+		}
+		i += j;
+
+		// Code points above the 16-bit range are stored as a pair of surrogates.
+		if (codePoint >= 0x10000)
+		{
+			codePoint -= 0x10000;
+			units.push_back(uint16_t(0xD800 + (codePoint >> 10)));
+			units.push_back(uint16_t(0xDC00 + (codePoint & 0x3FF)));
+		}
+		else
+		{
+			units.push_back(uint16_t(codePoint));
+		}
+	}
+
+	// Build the skip table over code units, the same way as the byte version.
+	size_t m = units.size();
+	for (int i = 0; i < 256; i++)
+	{
+		unitSkip[i] = m;
+	}
+	for (size_t i = 0; i + 1 < m; i++)
+	{
+		unitSkip[units[i] & 0xFF] = (m - 1) - i;
+	}
+}
+
+std::vector<EncodedMatch> EncodedSearch::search(const char* data, size_t length) const
+{
+	size_t bomLength = 0;
+	TextEncoding found = detectEncoding(data, length, bomLength);
+
+	// A BOM that disagrees with the compiled encoding means the keyword would never match, so it's only skipped if it's the right one.
+	if (found != encoding)
+	{
+		bomLength = 0;
+	}
+
+	if (encoding == TextEncoding::UTF8)
+	{
+		return searchUTF8(data, length, bomLength);
+	}
+	return searchUTF16(data, length, bomLength);
+}
+
+std::vector<EncodedMatch> EncodedSearch::searchUTF8(const char* data, size_t length, size_t bomLength) const
+{
+	std::vector<EncodedMatch> matches;
+	const char* text = data + bomLength;
+	size_t textLength = length - bomLength;
+
+	// Characters are counted between one match and the next, so the whole text is only counted once. Continuation bytes (10xxxxxx) aren't the start of a character.
+	size_t counted = 0;
+	size_t chars = 0;
+	for (size_t i = utf8Pattern.find(text, textLength); i != CompiledPattern::npos; i = utf8Pattern.find(text, textLength, i + 1))
+	{
+		for (; counted < i; counted++)
+		{
+			if ((text[counted] & 0xC0) != 0x80)
+			{
+				chars++;
+			}
+		}
+		matches.push_back({ bomLength + i, chars });
+	}
+	return matches;
+}
+
+std::vector<EncodedMatch> EncodedSearch::searchUTF16(const char* data, size_t length, size_t bomLength) const
+{
+	std::vector<EncodedMatch> matches;
+	const unsigned char* text = reinterpret_cast<const unsigned char*>(data + bomLength);
+	size_t textUnits = (length - bomLength) / 2;
+	size_t m = units.size();
+	if (m == 0 || textUnits < m)
+	{
+		return matches;
+	}
+
+	size_t counted = 0;
+	size_t chars = 0;
+	size_t last = m - 1;
+	for (size_t i = 0; i <= textUnits - m; )
+	{
+		uint16_t u = unitAt(text, i + last);
+		if (u == units[last])
+		{
+			size_t j = 0;
+			while (j < last && unitAt(text, i + j) == units[j])
+			{
+				j++;
+			}
+			if (j == last)
+			{
+				// Low surrogates (DC00 to DFFF) are the second half of a character, so they aren't counted.
+				for (; counted < i; counted++)
+				{
+					uint16_t c = unitAt(text, counted);
+					if (c < 0xDC00 || c > 0xDFFF)
+					{
+						chars++;
+					}
+				}
+				matches.push_back({ bomLength + 2 * i, chars });
+			}
+		}
+		i += unitSkip[u & 0xFF];
+	}
+	return matches;
+}
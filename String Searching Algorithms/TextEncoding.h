@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "CompiledPattern.h"
+
+// The encodings that text files are checked for. Plain ASCII is treated as UTF-8, since it's a subset of it.
+enum class TextEncoding
+{
+	UTF8,
+	UTF16LE,
+	UTF16BE
+};
+
+// Works out the encoding of a file's contents from its byte order mark (BOM), or by looking at where the zero bytes are if there isn't one.
+// bomLength is set to the number of bytes taken up by the BOM, so that the text itself starts at data + bomLength.
+TextEncoding detectEncoding(const char* data, size_t length, size_t& bomLength);
+
+// Gives the name of an encoding for displaying to the user.
+const char* encodingName(TextEncoding encoding);
+
+// A match found by EncodedSearch. byteOffset is where the match starts in the data that was searched, including the BOM,
+// and charOffset is how many characters (Unicode code points) come before it in the text, not counting the BOM.
+struct EncodedMatch
+{
+	size_t byteOffset;
+	size_t charOffset;
+};
+
+// Searches UTF-8 or UTF-16 text for a keyword by working directly on the text's own code units, so the file never needs to be converted first.
+// The keyword is given as UTF-8 and is converted to the text's encoding once, when it's compiled.
+class EncodedSearch
+{
+public:
+	// Constructor and destructor.
+	EncodedSearch();
+	~EncodedSearch();
+
+	// Prepares a keyword for searching text in the given encoding.
+	void compile(const std::string& utf8Keyword, TextEncoding encoding);
+
+	// Finds every match in the data. 'data' should be the whole file, including any BOM, so that the encoding can be checked against it.
+	std::vector<EncodedMatch> search(const char* data, size_t length) const;
+	std::vector<EncodedMatch> search(const std::string& data) const { return search(data.data(), data.length()); };
+
+	TextEncoding getEncoding() const { return encoding; };
+
+protected:
+	// The UTF-8 search, using the normal byte-wise Boyer-Moore. UTF-8 is self-synchronising, so a byte match of a whole keyword always starts on a character boundary.
+	std::vector<EncodedMatch> searchUTF8(const char* data, size_t length, size_t bomLength) const;
+
+	// The UTF-16 search. It's Boyer-Moore (Horspool) over 16-bit code units, only ever looking at positions on a code unit boundary.
+	std::vector<EncodedMatch> searchUTF16(const char* data, size_t length, size_t bomLength) const;
+
+	// Reads the i'th code unit of UTF-16 text in the compiled byte order.
+	uint16_t unitAt(const unsigned char* text, size_t i) const
+	{
+		return encoding == TextEncoding::UTF16LE ? uint16_t(text[2 * i] | (text[2 * i + 1] << 8)) : uint16_t((text[2 * i] << 8) | text[2 * i + 1]);
+	}
+
+	TextEncoding encoding;
+
+	// The keyword as UTF-8 bytes and as UTF-16 code units.
+	CompiledPattern utf8Pattern;
+	std::vector<uint16_t> units;
+
+	// Skip table for the UTF-16 search. There are 65536 possible code units, so the table is indexed by the low byte of the unit,
+	// and units that share a low byte use the smallest skip of any of them, which is always safe.
+	size_t unitSkip[256];
+};
@@ -0,0 +1,209 @@
+#include "TextReplacer.h"
+#include <algorithm>
+
+TextReplacer::TextReplacer()
+{
+	longestKeyword = 0;
+	total = 0;
+	written = 0;
+	replacements = 0;
+}
+
+TextReplacer::~TextReplacer()
+{
+}
+
+void TextReplacer::compile(const std::string& keyword, const std::string& replacement)
+{
+	compile(std::vector<std::string>(1, keyword), std::vector<std::string>(1, replacement));
+}
+
+void TextReplacer::compile(const std::vector<std::string>& kws, const std::vector<std::string>& reps)
+{
+	keywords = kws;
+	replacementText = reps;
+	replacementText.resize(keywords.size());
+	longestKeyword = 0;
+	for (const std::string& kw : keywords)
+	{
+		longestKeyword = std::max(longestKeyword, kw.length());
+	}
+
+	if (keywords.size() == 1)
+	{
+		pattern.compile(keywords[0]);
+	}
+	else
+	{
+		automaton.build(keywords);
+	}
+}
+
+void TextReplacer::sortMatches(std::vector<MultiMatch>& matches) const
+{
+	std::sort(matches.begin(), matches.end(), [&](const MultiMatch& a, const MultiMatch& b)
+	{
+		if (a.position != b.position)
+		{
+			return a.position < b.position;
+		}
+		return keywords[a.pattern].length() > keywords[b.pattern].length();
+	});
+}
+
+size_t TextReplacer::replaceAll(const char* t, size_t length, std::vector<OutputSlice>& out) const
+{
+	out.clear();
+	size_t count = 0;
+	size_t copied = 0;
+	if (longestKeyword == 0)
+	{
+		out.push_back(OutputSlice{ t, length });
+		return 0;
+	}
+
+	if (keywords.size() == 1)
+	{
+		// With one keyword, carrying on the search from the end of each match skips the overlapping ones without looking at them.
+		size_t keyLength = pattern.length();
+		for (size_t i = pattern.find(t, length); i != CompiledPattern::npos; i = pattern.find(t, length, i + keyLength))
+		{
+			out.push_back(OutputSlice{ t + copied, i - copied });
+			out.push_back(OutputSlice{ replacementText[0].data(), replacementText[0].length() });
+			copied = i + keyLength;
+			count++;
+		}
+	}
+	else
+	{
+		std::vector<MultiMatch> matches;
+		automaton.search(t, length, matches);
+		sortMatches(matches);
+		for (const MultiMatch& m : matches)
+		{
+			if (m.position < copied)
+			{
+				continue;
+			}
+			out.push_back(OutputSlice{ t + copied, m.position - copied });
+			out.push_back(OutputSlice{ replacementText[m.pattern].data(), replacementText[m.pattern].length() });
+			copied = m.position + keywords[m.pattern].length();
+			count++;
+		}
+	}
+
+	out.push_back(OutputSlice{ t + copied, length - copied });
+	return count;
+}
+
+bool TextReplacer::replaceToFile(const char* t, size_t length, const std::string& filename)
+{
+	replacements = replaceAll(t, length, slices);
+	if (!writer.open(filename))
+	{
+		return false;
+	}
+	bool ok = writer.write(slices);
+	writer.close();
+	return ok;
+}
+
+bool TextReplacer::begin(const std::string& filename)
+{
+	pending.clear();
+	held.clear();
+	total = 0;
+	written = 0;
+	replacements = 0;
+
+	if (keywords.size() == 1)
+	{
+		stream.start(keywords[0], IncrementalMode::BoyerMoore);
+	}
+	else
+	{
+		stream.start(keywords);
+	}
+	return writer.open(filename);
+}
+
+void TextReplacer::addRange(const char* chunk, uint64_t chunkStart, uint64_t from, uint64_t to)
+{
+	// The held back bytes cover everything from 'written' up to the start of the current part.
+	if (from < chunkStart)
+	{
+		uint64_t end = std::min(to, chunkStart);
+		slices.push_back(OutputSlice{ held.data() + (from - written), size_t(end - from) });
+		from = end;
+	}
+	if (from < to)
+	{
+		slices.push_back(OutputSlice{ chunk + (from - chunkStart), size_t(to - from) });
+	}
+}
+
+bool TextReplacer::feed(const char* data, size_t length)
+{
+	uint64_t chunkStart = total;
+	stream.feed(data, length, pending);
+	total += length;
+
+	// A match that starts before the last longestKeyword - 1 bytes has already been found, so everything before there can be settled now.
+	uint64_t keep = longestKeyword > 0 ? longestKeyword - 1 : 0;
+	return flush(data, chunkStart, total > keep ? total - keep : 0);
+}
+
+bool TextReplacer::finish()
+{
+	bool ok = flush(nullptr, total, total);
+	writer.close();
+	return ok;
+}
+
+bool TextReplacer::flush(const char* chunk, uint64_t chunkStart, uint64_t safeEnd)
+{
+	// Carry on from where the last flush stopped writing, which is where the held back bytes begin.
+	uint64_t from = written;
+	slices.clear();
+	sortMatches(pending);
+	std::vector<MultiMatch> later;
+	for (const MultiMatch& m : pending)
+	{
+		if (m.position < from)
+		{
+			continue;
+		}
+		if (m.position >= safeEnd)
+		{
+			later.push_back(m);
+			continue;
+		}
+		addRange(chunk, chunkStart, from, m.position);
+		slices.push_back(OutputSlice{ replacementText[m.pattern].data(), replacementText[m.pattern].length() });
+		from = m.position + keywords[m.pattern].length();
+		replacements++;
+	}
+	if (from < safeEnd)
+	{
+		addRange(chunk, chunkStart, from, safeEnd);
+		from = safeEnd;
+	}
+	pending.swap(later);
+
+	bool ok = writer.write(slices);
+
+	// Hold back whatever hasn't been written. It's never more than longestKeyword - 1 bytes, so copying it is cheap.
+	std::string next;
+	if (from < chunkStart)
+	{
+		next.assign(held, size_t(from - written), std::string::npos);
+	}
+	uint64_t copyFrom = std::max(from, chunkStart);
+	if (copyFrom < total)
+	{
+		next.append(chunk + (copyFrom - chunkStart), size_t(total - copyFrom));
+	}
+	held.swap(next);
+	written = from;
+	return ok;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "SearchTypes.h"
+#include "CompiledPattern.h"
+#include "DoubleArrayTrie.h"
+#include "IncrementalSearch.h"
+#include "ScatterWriter.h"
+
+// Replaces every occurance of one or more keywords, for example to blank out names in a transcript.
+// The output is never built up as a new string. Instead it's a list of slices: the unchanged parts point into the original text and the replacements point at
+// the replacement strings, and the list is written out by ScatterWriter in one go. One keyword is found with the Boyer-Moore search and several with the Aho-Corasick automaton.
+// Where matches overlap, the one that starts first is replaced, and between matches that start at the same place, the longest.
+//
+// Text that arrives in parts, such as a file read in blocks, can be replaced as it comes in with begin(), feed() and finish().
+// Each part is written out before feed() returns, apart from the last few bytes, which are held back in case a keyword carries on into the next part.
+class TextReplacer
+{
+public:
+	// Constructor and destructor.
+	TextReplacer();
+	~TextReplacer();
+
+	// Sets the keyword to look for and what to replace it with.
+	void compile(const std::string& keyword, const std::string& replacement);
+
+	// Sets several keywords, each with its own replacement.
+	void compile(const std::vector<std::string>& keywords, const std::vector<std::string>& replacements);
+
+	// Fills 'slices' with the output for a whole text and returns the number of replacements. The slices point into the text and into this object, so both
+	// have to stay as they are until the slices have been written.
+	size_t replaceAll(const char* t, size_t length, std::vector<OutputSlice>& slices) const;
+
+	// Replaces a text and writes the result to a file. Returns false if the file couldn't be written.
+	bool replaceToFile(const char* t, size_t length, const std::string& filename);
+
+	// Starts replacing a text that arrives in parts, writing the output to a file. Returns false if the file couldn't be created.
+	bool begin(const std::string& filename);
+
+	// Replaces the next part of the text and writes it out. The part doesn't need to be kept after feed() returns.
+	bool feed(const char* data, size_t length);
+
+	// Writes out the bytes that were held back and closes the file.
+	bool finish();
+
+	// The number of replacements made by the last replaceToFile() or streamed text.
+	size_t getReplacements() const { return replacements; };
+
+protected:
+	// Writes out everything before 'safeEnd' that can no longer be part of a match that isn't known about yet, and keeps the rest for next time.
+	bool flush(const char* chunk, uint64_t chunkStart, uint64_t safeEnd);
+
+	// Adds the original text between two positions to the slices. The range can start in the held back bytes and finish in the current part.
+	void addRange(const char* chunk, uint64_t chunkStart, uint64_t from, uint64_t to);
+
+	// Sorts matches by where they start, and the longest first between matches that start at the same place, which is the order they're taken in.
+	void sortMatches(std::vector<MultiMatch>& matches) const;
+
+	std::vector<std::string> keywords;
+	std::vector<std::string> replacementText;
+	size_t longestKeyword;
+
+	// The searchers for whole texts.
+	CompiledPattern pattern;
+	DoubleArrayTrie automaton;
+
+	// Streaming: the search that carries on between parts, the matches that haven't been written yet, how many bytes have been fed in,
+	// and how many have been written out. The bytes held back from the last part start where the written ones finish.
+	IncrementalSearch stream;
+	std::vector<MultiMatch> pending;
+	std::string held;
+	uint64_t total;
+	uint64_t written;
+
+	ScatterWriter writer;
+	std::vector<OutputSlice> slices;
+	size_t replacements;
+};
@@ -0,0 +1,118 @@
+#include "ThreadArena.h"
+#include <algorithm>
+#include <cstdint>
+
+ThreadArena::ThreadArena(size_t firstBlock, size_t retain)
+{
+	current = 0;
+	offset = 0;
+	usedBefore = 0;
+	firstBlockSize = std::max<size_t>(firstBlock, 64);
+	retainLimit = retain;
+}
+
+ThreadArena::~ThreadArena()
+{
+}
+
+ThreadArena& ThreadArena::local()
+{
+	static thread_local ThreadArena arena;
+	return arena;
+}
+
+// The first position at or after 'offset' in a block that is lined up to 'alignment'.
+static size_t alignedOffset(const char* data, size_t offset, size_t alignment)
+{
+	uintptr_t address = reinterpret_cast<uintptr_t>(data + offset);
+	return offset + size_t((alignment - address % alignment) % alignment);
+}
+
+void* ThreadArena::allocate(size_t bytes, size_t alignment)
+{
+	// Try the block being used, then any blocks after it that were kept from before, and make a new one if none of them have room.
+	while (current < blocks.size())
+	{
+		Block& block = blocks[current];
+		size_t start = alignedOffset(block.data.get(), offset, alignment);
+		if (start + bytes <= block.size)
+		{
+			offset = start + bytes;
+			return block.data.get() + start;
+		}
+		usedBefore += offset;
+		current++;
+		offset = 0;
+	}
+
+	// Each new block is at least twice the size of the last, so a query that keeps growing only needs a few of them.
+	size_t size = blocks.empty() ? firstBlockSize : blocks.back().size * 2;
+	size = std::max(size, bytes + alignment);
+	Block block;
+	block.data.reset(new char[size]);
+	block.size = size;
+	blocks.push_back(std::move(block));
+	current = blocks.size() - 1;
+
+	size_t start = alignedOffset(blocks[current].data.get(), 0, alignment);
+	offset = start + bytes;
+	return blocks[current].data.get() + start;
+}
+
+void ThreadArena::reset()
+{
+	size_t total = getCapacity();
+	if (total > retainLimit)
+	{
+		// Don't keep the memory of one huge query for good. The next query starts again from the first block size.
+		blocks.clear();
+	}
+	else if (blocks.size() > 1)
+	{
+		blocks.clear();
+		Block block;
+		block.data.reset(new char[total]);
+		block.size = total;
+		blocks.push_back(std::move(block));
+	}
+	current = 0;
+	offset = 0;
+	usedBefore = 0;
+}
+
+std::vector<size_t>* ThreadArena::takeBuffer()
+{
+	if (freeBuffers.empty())
+	{
+		buffers.emplace_back(new std::vector<size_t>());
+		return buffers.back().get();
+	}
+	std::vector<size_t>* buffer = freeBuffers.back();
+	freeBuffers.pop_back();
+	return buffer;
+}
+
+void ThreadArena::giveBack(std::vector<size_t>* buffer)
+{
+	buffer->clear();
+	if (buffer->capacity() * sizeof(size_t) > retainLimit)
+	{
+		std::vector<size_t>().swap(*buffer);
+	}
+	freeBuffers.push_back(buffer);
+}
+
+size_t ThreadArena::getCapacity() const
+{
+	size_t total = 0;
+	for (const Block& block : blocks)
+	{
+		total += block.size;
+	}
+	return total;
+}
+
+size_t ThreadArena::getUsed() const
+{
+	return usedBefore + offset;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// Memory for the match lists and scratch space of one query at a time, kept by each thread so that a busy server doesn't have to go to the global allocator
+// (and its locks) for every query. It's a monotonic arena: allocate() just moves a pointer along a block, nothing is given back one allocation at a time,
+// and reset() between queries makes the whole lot free again at once. The blocks are kept after a reset, so once a thread's arena has grown to the size
+// its biggest query needed, it never needs to allocate again. That's only up to a limit, though: if one unusually big query grows it past the limit,
+// reset() gives the blocks back rather than holding on to that much memory for the rest of the thread's life.
+//
+// It also keeps a pool of match lists that are handed out empty but with the room they had last time, for code that needs a plain std::vector<size_t>.
+class ThreadArena
+{
+public:
+	// Constructor and destructor. The first block is made when it's first needed.
+	ThreadArena(size_t firstBlock = 64 * 1024, size_t retainLimit = size_t(16) << 20);
+	~ThreadArena();
+
+	// The arena for the thread that calls it, made the first time that thread asks for it.
+	static ThreadArena& local();
+
+	// Hands out memory that lasts until the next reset().
+	void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+	// Makes all of the arena's memory free again. If the last query needed more than one block, they're replaced by a single block big enough for all of it,
+	// so the next query of that size fits without moving between blocks. If the blocks add up to more than the retain limit, they're all freed instead.
+	void reset();
+
+	// The most memory the arena keeps between queries, and the most room a match list keeps when it's given back to the pool.
+	void setRetainLimit(size_t bytes) { retainLimit = bytes; };
+	size_t getRetainLimit() const { return retainLimit; };
+
+	// Takes an empty match list from the pool, or makes a new one if they're all in use, and gives one back to the pool.
+	std::vector<size_t>* takeBuffer();
+	void giveBack(std::vector<size_t>* buffer);
+
+	// The number of bytes in the blocks, and the number handed out since the last reset().
+	size_t getCapacity() const;
+	size_t getUsed() const;
+
+private:
+	// Copying would free the blocks twice, so it isn't allowed.
+	ThreadArena(const ThreadArena&);
+	ThreadArena& operator=(const ThreadArena&);
+
+	struct Block
+	{
+		std::unique_ptr<char[]> data;
+		size_t size;
+	};
+
+	// The blocks, the one being used and how far into it the next allocation goes, and the total used in the blocks before it.
+	std::vector<Block> blocks;
+	size_t current;
+	size_t offset;
+	size_t usedBefore;
+	size_t firstBlockSize;
+	size_t retainLimit;
+
+	// Every match list the pool has made, and the ones that aren't in use.
+	std::vector<std::unique_ptr<std::vector<size_t>>> buffers;
+	std::vector<std::vector<size_t>*> freeBuffers;
+};
+
+// An allocator that takes its memory from a ThreadArena, so that a standard container can be used for scratch space. Freeing does nothing,
+// since the memory comes back when the arena is reset, so the container mustn't be used after that.
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator(ThreadArena& a) : arena(&a) {};
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.getArena()) {};
+
+	T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); };
+	void deallocate(T*, size_t) {};
+
+	ThreadArena* getArena() const { return arena; };
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.getArena(); };
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.getArena(); };
+
+private:
+	ThreadArena* arena;
+};
+
+// A vector that grows in a ThreadArena.
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Takes a match list from the calling thread's pool and gives it back when it goes out of scope.
+class PooledBuffer
+{
+public:
+	PooledBuffer() : arena(ThreadArena::local()), buffer(arena.takeBuffer()) {};
+	~PooledBuffer() { arena.giveBack(buffer); };
+
+	std::vector<size_t>& operator*() const { return *buffer; };
+	std::vector<size_t>* operator->() const { return buffer; };
+
+private:
+	PooledBuffer(const PooledBuffer&);
+	PooledBuffer& operator=(const PooledBuffer&);
+
+	ThreadArena& arena;
+	std::vector<size_t>* buffer;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Variable length integers (LEB128). Each byte holds 7 bits of the number, and the top bit is set if more bytes follow,
+// so small numbers like the gap between two nearby matches only take one or two bytes instead of eight.
+
+// Adds a number to the end of a buffer.
+inline void appendVarint(std::string& out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out += char((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	out += char(value);
+}
+
+// Reads a number from a buffer, moving 'position' past it. Returns false if the buffer ends in the middle of the number.
+inline bool readVarint(const char* data, size_t length, size_t& position, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && position < length; shift += 7)
+	{
+		unsigned char byte = (unsigned char)data[position++];
+		value |= uint64_t(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
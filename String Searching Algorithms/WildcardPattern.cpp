@@ -0,0 +1,309 @@
+#include "WildcardPattern.h"
+#include "CaseFolding.h"
+#include <cstring>
+#include <cctype>
+
+// A character of the pattern once it has been read: either a particular character, or any character for a '?'.
+struct PatternElement
+{
+	bool any;
+	unsigned char c;
+};
+
+// Reads a number at 'i' for a gap, moving 'i' past it. Returns false if there isn't one.
+static bool readNumber(const std::string& p, size_t& i, size_t& value)
+{
+	size_t start = i;
+	value = 0;
+	while (i < p.length() && isdigit((unsigned char)p[i]) && value <= WildcardPattern::maxGap)
+	{
+		value = value * 10 + size_t(p[i] - '0');
+		i++;
+	}
+	return i > start && (i >= p.length() || !isdigit((unsigned char)p[i]));
+}
+
+WildcardPattern::WildcardPattern()
+{
+	compile("");
+}
+
+WildcardPattern::WildcardPattern(const std::string& p, bool ignoreCase)
+{
+	compile(p, ignoreCase);
+}
+
+WildcardPattern::~WildcardPattern()
+{
+}
+
+bool WildcardPattern::compile(const std::string& p, bool ignoreCase)
+{
+	pattern = p;
+	parts.clear();
+	for (int c = 0; c < 256; c++)
+	{
+		masks[c] = 0;
+	}
+	firstBits = 0;
+	lastBits = 0;
+	firstCharacter = -1;
+	minLength = 0;
+	maxLength = 0;
+
+	// Split the pattern into parts at the gaps. Gaps next to each other are added together, and a gap of exactly 0 doesn't split anything.
+	std::vector<std::vector<PatternElement>> elements;
+	std::vector<std::pair<size_t, size_t>> gaps;
+	size_t gapMin = 0;
+	size_t gapMax = 0;
+	size_t characters = 0;
+	for (size_t i = 0; i < p.length(); )
+	{
+		if (p[i] == '.' && i + 1 < p.length() && p[i + 1] == '{')
+		{
+			size_t low, high;
+			i += 2;
+			if (!readNumber(p, i, low))
+			{
+				return false;
+			}
+			high = low;
+			if (i < p.length() && p[i] == ',')
+			{
+				i++;
+				if (!readNumber(p, i, high))
+				{
+					return false;
+				}
+			}
+			if (i >= p.length() || p[i] != '}' || high < low)
+			{
+				return false;
+			}
+			i++;
+			gapMin += low;
+			gapMax += high;
+			continue;
+		}
+
+		PatternElement element;
+		element.any = p[i] == '?';
+		element.c = (unsigned char)p[i];
+		if (p[i] == '\\')
+		{
+			if (i + 1 >= p.length())
+			{
+				return false;
+			}
+			element.c = (unsigned char)p[i + 1];
+			i++;
+		}
+		i++;
+
+		if (elements.empty() || gapMax > 0)
+		{
+			// A pattern can't start with a gap, since it would match anywhere the rest does.
+			if (elements.empty() && gapMax > 0)
+			{
+				return false;
+			}
+			elements.push_back(std::vector<PatternElement>());
+			gaps.push_back(std::make_pair(gapMin, gapMax));
+			gapMin = 0;
+			gapMax = 0;
+		}
+		elements.back().push_back(element);
+		characters++;
+	}
+
+	// A gap at the end wouldn't change where the rest matches either.
+	if (elements.empty() || gapMax > 0 || characters > maxCharacters)
+	{
+		return false;
+	}
+	for (const std::pair<size_t, size_t>& gap : gaps)
+	{
+		if (gap.second > maxGap)
+		{
+			return false;
+		}
+	}
+
+	// Give each part its bits, and set the bit of each character in the masks of every character it matches.
+	unsigned int bit = 0;
+	for (size_t k = 0; k < elements.size(); k++)
+	{
+		Part part;
+		part.first = bit;
+		part.length = (unsigned int)elements[k].size();
+		part.minGap = gaps[k].first;
+		part.maxGap = gaps[k].second;
+		part.windowBits = part.maxGap >= 63 ? ~uint64_t(0) : (uint64_t(2) << part.maxGap) - 1;
+		part.gapBits = part.windowBits & ~((uint64_t(1) << part.minGap) - 1);
+
+		for (const PatternElement& element : elements[k])
+		{
+			uint64_t mask = uint64_t(1) << bit;
+			if (element.any)
+			{
+				for (int c = 0; c < 256; c++)
+				{
+					masks[c] |= mask;
+				}
+			}
+			else
+			{
+				masks[element.c] |= mask;
+				if (ignoreCase)
+				{
+					masks[otherCase(element.c)] |= mask;
+				}
+			}
+			bit++;
+		}
+
+		firstBits |= uint64_t(1) << part.first;
+		lastBits |= uint64_t(1) << (part.first + part.length - 1);
+		minLength += part.minGap + part.length;
+		maxLength += part.maxGap + part.length;
+		parts.push_back(part);
+	}
+
+	const PatternElement& first = elements[0][0];
+	if (!first.any && (!ignoreCase || otherCase(first.c) == first.c))
+	{
+		firstCharacter = first.c;
+	}
+	return true;
+}
+
+template <typename Found>
+void WildcardPattern::scan(const char* t, size_t length, Found found) const
+{
+	if (parts.empty())
+	{
+		return;
+	}
+
+	// For every part but the last, bit j of its history is set if it finished j characters before the one about to be read, which is a gap of j before the next part.
+	// Bits for gaps longer than the next part allows are cleared, so the history goes back to 0 once it's too late for the next part to start.
+	uint64_t history[maxCharacters];
+	size_t partCount = parts.size();
+	for (size_t k = 0; k < partCount; k++)
+	{
+		history[k] = 0;
+	}
+	uint64_t lastBit = uint64_t(1) << (parts.back().first + parts.back().length - 1);
+	uint64_t state = 0;
+	uint64_t waiting = 0;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		// If nothing is part way through matching, nothing can match before the next place the first character appears.
+		if (state == 0 && waiting == 0 && firstCharacter >= 0)
+		{
+			const void* next = memchr(t + i, firstCharacter, length - i);
+			if (next == nullptr)
+			{
+				break;
+			}
+			i = size_t(static_cast<const char*>(next) - t);
+		}
+
+		// The first part can start anywhere. The others can only start where the part before them finished the right distance back.
+		uint64_t starts = 1;
+		for (size_t k = 1; k < partCount; k++)
+		{
+			if ((history[k - 1] & parts[k].gapBits) != 0)
+			{
+				starts |= uint64_t(1) << parts[k].first;
+			}
+		}
+
+		// Move every part along one character. Shifting would carry the end of one part into the start of the next, so the first bits only come from 'starts'.
+		state = (((state << 1) & ~firstBits) | starts) & masks[(unsigned char)t[i]];
+
+		waiting = 0;
+		for (size_t k = 0; k + 1 < partCount; k++)
+		{
+			uint64_t finished = (state >> (parts[k].first + parts[k].length - 1)) & 1;
+			history[k] = ((history[k] << 1) | finished) & parts[k + 1].windowBits;
+			waiting |= history[k];
+		}
+
+		if ((state & lastBit) != 0)
+		{
+			found(i);
+		}
+	}
+}
+
+bool WildcardPattern::partMatchesAt(const char* t, const Part& part) const
+{
+	for (unsigned int i = 0; i < part.length; i++)
+	{
+		if (((masks[(unsigned char)t[i]] >> (part.first + i)) & 1) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool WildcardPattern::findStart(const char* t, size_t end, size_t part, size_t& start, std::vector<size_t>& failed) const
+{
+	const Part& p = parts[part];
+	if (end + 1 < p.length)
+	{
+		return false;
+	}
+
+	// The places a part is tried at never go back more than maxLength from the end of a match, and the matches are found in order, so a slot is only
+	// reused once the place it held can't come up again.
+	size_t& slot = failed[part * (maxLength + 1) + end % (maxLength + 1)];
+	if (slot == end + 1)
+	{
+		return false;
+	}
+
+	size_t partStart = end + 1 - p.length;
+	if (partMatchesAt(t + partStart, p))
+	{
+		if (part == 0)
+		{
+			start = partStart;
+			return true;
+		}
+
+		for (size_t gap = p.minGap; gap <= p.maxGap && gap < partStart; gap++)
+		{
+			if (findStart(t, partStart - 1 - gap, part - 1, start, failed))
+			{
+				return true;
+			}
+		}
+	}
+	slot = end + 1;
+	return false;
+}
+
+void WildcardPattern::findAll(const char* t, size_t length, std::vector<WildcardMatch>& results) const
+{
+	std::vector<size_t> failed(parts.size() * (maxLength + 1), 0);
+	scan(t, length, [&](size_t end)
+	{
+		size_t start;
+		if (findStart(t, end, parts.size() - 1, start, failed))
+		{
+			WildcardMatch match = { start, end + 1 - start };
+			results.push_back(match);
+		}
+	});
+}
+
+size_t WildcardPattern::count(const char* t, size_t length) const
+{
+	size_t matches = 0;
+	scan(t, length, [&](size_t) { matches++; });
+	return matches;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "SearchTypes.h"
+
+// A keyword with "don't care" characters and gaps, searched for with the bit-parallel Shift-And algorithm in a single pass over the text, without a regex engine.
+//
+//     ?        matches any one character, so "N?ver g?nna" finds "Never gonna" and "Nover ganna".
+//     .{m,n}   matches between m and n characters of anything, so "ERROR.{0,16}timeout" finds a timeout up to 16 characters after an error. ".{n}" is exactly n.
+//     \        makes the next character an ordinary one, for a literal '?', '.' or '\'. A '.' that isn't followed by '{' is already an ordinary character.
+//
+// The gaps split the keyword into parts. Each part has its own range of bits in a single 64-bit state, and Shift-And moves every part along one character at a time,
+// with a '?' matching by having its bit set for every character. The parts are linked by remembering, for the last 64 characters, where each part finished:
+// the next part is only allowed to start where the one before it finished the right distance back. So the whole pattern, gaps and all, is found in one scan.
+// When nothing is part way through matching, the scan jumps straight to the next place the first character appears, like a literal search.
+//
+// The parts can have up to 64 characters between them, not counting the gaps, and each gap can be up to 63 characters long.
+class WildcardPattern
+{
+public:
+	// The most characters in all of the parts together, and the longest gap.
+	static const size_t maxCharacters = 64;
+	static const size_t maxGap = 63;
+
+	// Constructors and destructor.
+	WildcardPattern();
+	WildcardPattern(const std::string& p, bool ignoreCase = false);
+	~WildcardPattern();
+
+	// Builds the bit masks for a pattern. Returns false if the pattern is empty, too long, starts or ends with a gap, or has a gap that isn't written properly.
+	bool compile(const std::string& p, bool ignoreCase = false);
+	bool isValid() const { return !parts.empty(); };
+
+	// Adds a match to the results for every position in the text that a match ends at. If more than one match ends at the same place, the one with the
+	// shortest gaps is given, starting from the last gap.
+	void findAll(const char* t, size_t length, std::vector<WildcardMatch>& results) const;
+
+	// The number of positions a match ends at, without working out where each one starts.
+	size_t count(const char* t, size_t length) const;
+
+	const std::string& getPattern() const { return pattern; };
+
+	// The shortest and longest text a match can be.
+	size_t getMinLength() const { return minLength; };
+	size_t getMaxLength() const { return maxLength; };
+
+protected:
+	// One part of the pattern between gaps: its first bit in the state, its length, and the gap that comes before it.
+	// gapBits has bits minGap to maxGap set, for checking where the part before it finished, and windowBits has every bit up to maxGap set.
+	struct Part
+	{
+		unsigned int first;
+		unsigned int length;
+		size_t minGap;
+		size_t maxGap;
+		uint64_t gapBits;
+		uint64_t windowBits;
+	};
+
+	// The scan used by both findAll() and count(). Calls found() with the position of the last character of each match.
+	template <typename Found>
+	void scan(const char* t, size_t length, Found found) const;
+
+	// Works out where a match that ends at 'end' starts, by checking each part from the last one back and trying the shortest gaps first.
+	// Without remembering where a part has already failed, a pattern with many gaps can try the same places again and again, exponentially. So 'failed' has
+	// a slot for each part and each of the last maxLength + 1 places it could end, holding the place plus one if the part can't end there.
+	// Whether a part can end somewhere doesn't depend on the match, so the slots are kept from one match to the next.
+	bool findStart(const char* t, size_t end, size_t part, size_t& start, std::vector<size_t>& failed) const;
+
+	// Checks whether a part matches the text starting at a position.
+	bool partMatchesAt(const char* t, const Part& part) const;
+
+	std::string pattern;
+	std::vector<Part> parts;
+
+	// The Shift-And masks: bit i of masks[c] is set if character i of the pattern matches c.
+	uint64_t masks[256];
+
+	// The first and last bit of every part.
+	uint64_t firstBits;
+	uint64_t lastBits;
+
+	// The first character of the pattern, if it's a single character that can be searched for with memchr(), or -1 if it isn't.
+	int firstCharacter;
+
+	size_t minLength;
+	size_t maxLength;
+};
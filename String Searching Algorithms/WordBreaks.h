@@ -0,0 +1,23 @@
+#pragma once
+
+// Which characters count as part of a word, for the word counter and the word index. Letters and digits count, and so does any byte above 127,
+// so that UTF-8 letters stay inside their words. It's looked up in a table since it's checked for every character of the text.
+struct WordCharacters
+{
+	bool isWord[256];
+
+	WordCharacters()
+	{
+		for (int c = 0; c < 256; c++)
+		{
+			isWord[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+		}
+	}
+};
+
+static const WordCharacters wordCharacters;
+
+inline bool isWordCharacter(unsigned char c)
+{
+	return wordCharacters.isWord[c];
+}
@@ -0,0 +1,376 @@
+#include "WordIndex.h"
+#include <algorithm>
+#include "CaseFolding.h"
+#include "CompiledPattern.h"
+#include "Varint.h"
+#include "WordBreaks.h"
+
+// SSE2 is part of every 64-bit x86 CPU, so the intersection can use it without checking the CPU first.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INDEX_SSE2 1
+#include <emmintrin.h>
+#else
+#define INDEX_SSE2 0
+#endif
+
+// When one list is this many times longer than the other, galloping through it beats comparing every number.
+static const size_t gallopRatio = 32;
+
+WordIndex::WordIndex(bool ignoreCase)
+{
+	caseless = ignoreCase;
+	text = nullptr;
+	textLength = 0;
+}
+
+WordIndex::~WordIndex()
+{
+}
+
+void WordIndex::build(const char* t, size_t length, char separator)
+{
+	text = t;
+	textLength = length;
+	vocabulary.clear();
+	terms.clear();
+	tokenOffsets.clear();
+	documentTokens.assign(1, 0);
+	documentOffsets.assign(1, 0);
+
+	// While building, the lists are kept as plain numbers and compressed at the end.
+	std::vector<std::vector<uint32_t>> documentLists;
+	std::vector<std::vector<uint32_t>> positionLists;
+	uint32_t document = 0;
+	std::string word;
+
+	for (size_t i = 0; i < length; )
+	{
+		unsigned char c = (unsigned char)t[i];
+		if (c == (unsigned char)separator)
+		{
+			i++;
+			document++;
+			documentTokens.push_back(uint32_t(tokenOffsets.size()));
+			documentOffsets.push_back(i);
+			continue;
+		}
+		if (!isWordCharacter(c))
+		{
+			i++;
+			continue;
+		}
+
+		size_t start = i;
+		word.clear();
+		while (i < length && isWordCharacter((unsigned char)t[i]))
+		{
+			word += caseless ? char(foldCase((unsigned char)t[i])) : t[i];
+			i++;
+		}
+
+		auto found = vocabulary.find(word);
+		uint32_t id;
+		if (found == vocabulary.end())
+		{
+			id = uint32_t(terms.size());
+			vocabulary[word] = id;
+			terms.push_back(Term{ std::string(), std::string(), 0, 0 });
+			documentLists.emplace_back();
+			positionLists.emplace_back();
+		}
+		else
+		{
+			id = found->second;
+		}
+
+		if (documentLists[id].empty() || documentLists[id].back() != document)
+		{
+			documentLists[id].push_back(document);
+		}
+		positionLists[id].push_back(uint32_t(tokenOffsets.size()));
+		tokenOffsets.push_back(start);
+	}
+
+	// Store each list as the gaps between its numbers.
+	for (size_t id = 0; id < terms.size(); id++)
+	{
+		Term& term = terms[id];
+		uint32_t previous = 0;
+		for (uint32_t d : documentLists[id])
+		{
+			appendVarint(term.documents, d - previous);
+			previous = d;
+		}
+		previous = 0;
+		for (uint32_t p : positionLists[id])
+		{
+			appendVarint(term.positions, p - previous);
+			previous = p;
+		}
+		term.documentCount = uint32_t(documentLists[id].size());
+		term.positionCount = uint32_t(positionLists[id].size());
+		term.documents.shrink_to_fit();
+		term.positions.shrink_to_fit();
+
+		// Free each plain list as soon as it's been compressed, so that the two copies are never all in memory at once.
+		std::vector<uint32_t>().swap(documentLists[id]);
+		std::vector<uint32_t>().swap(positionLists[id]);
+	}
+}
+
+std::vector<std::string> WordIndex::tokenise(const std::string& query) const
+{
+	std::vector<std::string> words;
+	std::string word;
+	for (size_t i = 0; i <= query.length(); i++)
+	{
+		if (i < query.length() && isWordCharacter((unsigned char)query[i]))
+		{
+			word += caseless ? char(foldCase((unsigned char)query[i])) : query[i];
+		}
+		else if (!word.empty())
+		{
+			words.push_back(word);
+			word.clear();
+		}
+	}
+	return words;
+}
+
+const WordIndex::Term* WordIndex::findTerm(const std::string& word) const
+{
+	auto found = vocabulary.find(word);
+	return found == vocabulary.end() ? nullptr : &terms[found->second];
+}
+
+void WordIndex::decode(const std::string& packed, uint32_t count, std::vector<uint32_t>& out)
+{
+	out.resize(count);
+	size_t position = 0;
+	uint64_t gap;
+	uint32_t value = 0;
+	for (uint32_t i = 0; i < count && readVarint(packed.data(), packed.length(), position, gap); i++)
+	{
+		value += uint32_t(gap);
+		out[i] = value;
+	}
+}
+
+uint32_t WordIndex::documentOf(uint32_t token) const
+{
+	// The last document that starts at or before the token. Empty documents start at the same token as the next one, so the last of them is the right one.
+	return uint32_t(std::upper_bound(documentTokens.begin(), documentTokens.end(), token) - documentTokens.begin() - 1);
+}
+
+void WordIndex::intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<uint32_t>& out)
+{
+	const std::vector<uint32_t>& small = a.size() <= b.size() ? a : b;
+	const std::vector<uint32_t>& large = a.size() <= b.size() ? b : a;
+	if (large.size() > small.size() * gallopRatio)
+	{
+		intersectGalloping(small, large, out);
+	}
+	else
+	{
+		intersectSIMD(a, b, out);
+	}
+}
+
+void WordIndex::intersectGalloping(const std::vector<uint32_t>& small, const std::vector<uint32_t>& large, std::vector<uint32_t>& out)
+{
+	out.clear();
+	size_t low = 0;
+	for (uint32_t x : small)
+	{
+		// Take steps of 1, 2, 4, 8... until a number at least as big as x is passed, then binary search the last step.
+		size_t step = 1;
+		while (low + step < large.size() && large[low + step] < x)
+		{
+			step *= 2;
+		}
+		size_t high = std::min(low + step + 1, large.size());
+		low = size_t(std::lower_bound(large.begin() + low, large.begin() + high, x) - large.begin());
+		if (low == large.size())
+		{
+			break;
+		}
+		if (large[low] == x)
+		{
+			out.push_back(x);
+		}
+	}
+}
+
+void WordIndex::intersectSIMD(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<uint32_t>& out)
+{
+	out.clear();
+	size_t i = 0;
+	size_t j = 0;
+
+#if INDEX_SSE2
+	// Compare 4 numbers from a with 4 from b, by comparing a with b rotated round 0, 1, 2 and 3 places. Every number of a that equals any number of b ends up with its lane set.
+	// Whichever block has the smaller last number can't match anything further on in the other list, so that one moves on (or both, if they're equal).
+	while (i + 4 <= a.size() && j + 4 <= b.size())
+	{
+		__m128i blockA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&a[i]));
+		__m128i blockB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&b[j]));
+		__m128i equal = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi32(blockA, blockB), _mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, _MM_SHUFFLE(0, 3, 2, 1)))),
+			_mm_or_si128(_mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, _MM_SHUFFLE(1, 0, 3, 2))), _mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, _MM_SHUFFLE(2, 1, 0, 3)))));
+		int lanes = _mm_movemask_ps(_mm_castsi128_ps(equal));
+		for (int k = 0; k < 4; k++)
+		{
+			if (lanes & (1 << k))
+			{
+				out.push_back(a[i + k]);
+			}
+		}
+
+		uint32_t lastA = a[i + 3];
+		uint32_t lastB = b[j + 3];
+		if (lastA <= lastB)
+		{
+			i += 4;
+		}
+		if (lastB <= lastA)
+		{
+			j += 4;
+		}
+	}
+#endif
+
+	// Merge whatever is left one number at a time.
+	while (i < a.size() && j < b.size())
+	{
+		if (a[i] < b[j])
+		{
+			i++;
+		}
+		else if (b[j] < a[i])
+		{
+			j++;
+		}
+		else
+		{
+			out.push_back(a[i]);
+			i++;
+			j++;
+		}
+	}
+}
+
+PhraseMatches WordIndex::phrase(const std::string& query) const
+{
+	PhraseMatches matches;
+	matches.firstExact = npos;
+	std::vector<std::string> words = tokenise(query);
+	if (words.empty())
+	{
+		return matches;
+	}
+
+	// Move each word's positions back by its place in the phrase, so that a phrase starting at token p shows up as p in every list.
+	std::vector<std::vector<uint32_t>> lists(words.size());
+	for (size_t w = 0; w < words.size(); w++)
+	{
+		const Term* term = findTerm(words[w]);
+		if (term == nullptr)
+		{
+			return matches;
+		}
+		std::vector<uint32_t> positions;
+		decode(term->positions, term->positionCount, positions);
+		lists[w].reserve(positions.size());
+		for (uint32_t p : positions)
+		{
+			if (p >= w)
+			{
+				lists[w].push_back(uint32_t(p - w));
+			}
+		}
+	}
+
+	// Start with the rarest word, so the list being carried along is as short as possible.
+	std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>& x, const std::vector<uint32_t>& y) { return x.size() < y.size(); });
+	std::vector<uint32_t> starts = lists[0];
+	std::vector<uint32_t> next;
+	for (size_t w = 1; w < lists.size() && !starts.empty(); w++)
+	{
+		intersect(starts, lists[w], next);
+		starts.swap(next);
+	}
+
+	// A phrase can't carry on from one document into the next.
+	uint32_t lastWord = uint32_t(words.size() - 1);
+	for (uint32_t p : starts)
+	{
+		if (documentOf(p) == documentOf(p + lastWord))
+		{
+			matches.offsets.push_back(tokenOffsets[p]);
+		}
+	}
+
+	// The index ignores what's between the words, so check the occurances against the query itself with Boyer-Moore until one matches exactly.
+	CompiledPattern pattern(query, caseless);
+	for (size_t offset : matches.offsets)
+	{
+		if (offset + pattern.length() <= textLength && pattern.matchesAt(text + offset))
+		{
+			matches.firstExact = offset;
+			break;
+		}
+	}
+	return matches;
+}
+
+std::vector<uint32_t> WordIndex::allWords(const std::string& query) const
+{
+	std::vector<uint32_t> documents;
+	std::vector<std::string> words = tokenise(query);
+	if (words.empty())
+	{
+		return documents;
+	}
+
+	std::vector<std::vector<uint32_t>> lists(words.size());
+	for (size_t w = 0; w < words.size(); w++)
+	{
+		const Term* term = findTerm(words[w]);
+		if (term == nullptr)
+		{
+			return documents;
+		}
+		decode(term->documents, term->documentCount, lists[w]);
+	}
+
+	std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>& x, const std::vector<uint32_t>& y) { return x.size() < y.size(); });
+	documents = lists[0];
+	std::vector<uint32_t> next;
+	for (size_t w = 1; w < lists.size() && !documents.empty(); w++)
+	{
+		intersect(documents, lists[w], next);
+		documents.swap(next);
+	}
+	return documents;
+}
+
+size_t WordIndex::postingsSize() const
+{
+	size_t total = 0;
+	for (const Term& term : terms)
+	{
+		total += term.documents.capacity() + term.positions.capacity();
+	}
+	return total;
+}
+
+size_t WordIndex::memoryUsage() const
+{
+	size_t total = postingsSize() + terms.capacity() * sizeof(Term);
+	for (const auto& entry : vocabulary)
+	{
+		total += entry.first.capacity() + sizeof(entry);
+	}
+	total += tokenOffsets.capacity() * sizeof(size_t) + documentTokens.capacity() * sizeof(uint32_t) + documentOffsets.capacity() * sizeof(size_t);
+	return total;
+}
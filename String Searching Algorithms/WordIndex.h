@@ -0,0 +1,94 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// The answer to a phrase query: where each occurance of the phrase starts in the text, and the first of those where the text is exactly the same as the query,
+// which is checked with the Boyer-Moore search since the index only knows about the words and not the spaces and punctuation between them.
+struct PhraseMatches
+{
+	std::vector<size_t> offsets;
+	size_t firstExact;
+};
+
+// An inverted index of the words in a text, so that a phrase like "Never gonna" can be looked up instead of searching the whole text again.
+// The text is split into documents (lines by default), and the words into numbered tokens. For every different word the index keeps which documents it's in,
+// and the number of every token where it appears, both stored as the gaps between one number and the next in variable length integers so they take a byte or two each.
+//
+// A phrase query looks for tokens where the first word is followed by the second, and so on, by intersecting the position lists of the words.
+// An AND query intersects the document lists. When one list is much shorter than the other the longer one is galloped through (skipping ahead in growing steps),
+// and otherwise four numbers from each list are compared at once with SSE2.
+//
+// Like FrequencyCounter, the index keeps a pointer to the text rather than a copy, so the text has to stay in memory while the index is used.
+class WordIndex
+{
+public:
+	// Returned in PhraseMatches::firstExact when no occurance matches the query exactly.
+	static const size_t npos = size_t(-1);
+
+	// Constructor and destructor. With ignoreCase, words that only differ in case are treated as the same word.
+	WordIndex(bool ignoreCase = true);
+	~WordIndex();
+
+	// Indexes a text, with a new document starting after each separator character.
+	void build(const char* t, size_t length, char separator = '\n');
+	void build(const std::string& t, char separator = '\n') { build(t.data(), t.length(), separator); };
+
+	// Finds every occurance of the words of the query, one after another in the same document.
+	PhraseMatches phrase(const std::string& query) const;
+
+	// Finds every document that has all of the words of the query in it, in any order.
+	std::vector<uint32_t> allWords(const std::string& query) const;
+
+	// Where a document starts in the text.
+	size_t getDocumentOffset(uint32_t document) const { return documentOffsets[document]; };
+
+	size_t getDocumentCount() const { return documentOffsets.size(); };
+	size_t getTermCount() const { return terms.size(); };
+	size_t getTokenCount() const { return tokenOffsets.size(); };
+
+	// The number of bytes used by the postings, and by the whole index.
+	size_t postingsSize() const;
+	size_t memoryUsage() const;
+
+	// Puts the numbers that are in both sorted lists into 'out', choosing galloping or SSE2 depending on how different the lengths are.
+	static void intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<uint32_t>& out);
+	static void intersectGalloping(const std::vector<uint32_t>& small, const std::vector<uint32_t>& large, std::vector<uint32_t>& out);
+	static void intersectSIMD(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<uint32_t>& out);
+
+protected:
+	// The compressed lists for one word.
+	struct Term
+	{
+		std::string documents;
+		std::string positions;
+		uint32_t documentCount;
+		uint32_t positionCount;
+	};
+
+	// Splits a query into words, in the same way as the text.
+	std::vector<std::string> tokenise(const std::string& query) const;
+
+	// Looks up a word, returning its term or nullptr if it isn't in the text.
+	const Term* findTerm(const std::string& word) const;
+
+	// Unpacks a compressed list of gaps back into the numbers.
+	static void decode(const std::string& packed, uint32_t count, std::vector<uint32_t>& out);
+
+	// The document that a token is in.
+	uint32_t documentOf(uint32_t token) const;
+
+	std::unordered_map<std::string, uint32_t> vocabulary;
+	std::vector<Term> terms;
+
+	// Where each token starts in the text, and the first token and first byte of each document.
+	std::vector<size_t> tokenOffsets;
+	std::vector<uint32_t> documentTokens;
+	std::vector<size_t> documentOffsets;
+
+	const char* text;
+	size_t textLength;
+	bool caseless;
+};
@@ -0,0 +1,88 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool()
+{
+	stopping = false;
+	unfinished = 0;
+}
+
+WorkerPool::~WorkerPool()
+{
+	stop();
+}
+
+void WorkerPool::start(int threadCount)
+{
+	if (!threads.empty())
+	{
+		return;
+	}
+	stopping = false;
+
+	// Thread function that waits for a task, takes it off the queue while holding the mutex, then runs it and deletes it outside the lock.
+	// The empty check is made while holding the mutex, so two threads can never both take the last task.
+	auto threadFunction = [this]()
+	{
+		while (true)
+		{
+			Task* task;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				taskAdded.wait(lock, [this]() { return stopping || !taskQueue.empty(); });
+				if (taskQueue.empty())
+				{
+					return;
+				}
+				task = taskQueue.front();
+				taskQueue.pop();
+			}
+			task->run();
+			delete task;
+
+			std::lock_guard<std::mutex> lock(queueMutex);
+			unfinished--;
+			if (unfinished == 0)
+			{
+				allFinished.notify_all();
+			}
+		}
+	};
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		threads.push_back(new std::thread(threadFunction));
+	}
+}
+
+void WorkerPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	taskAdded.notify_all();
+
+	// Wait for all of the threads to finish, and then delete them.
+	for (std::thread* t : threads)
+	{
+		t->join();
+		delete t;
+	}
+	threads.clear();
+}
+
+void WorkerPool::add_task(Task *task)
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		taskQueue.push(task);
+		unfinished++;
+	}
+	taskAdded.notify_one();
+}
+
+void WorkerPool::wait()
+{
+	std::unique_lock<std::mutex> lock(queueMutex);
+	allFinished.wait(lock, [this]() { return unfinished == 0; });
+}
@@ -0,0 +1,51 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include "task.h"
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+/** A set of threads that stay running and take tasks from a shared queue.
+    Unlike a farm that is run once, tasks can be added at any time, which suits a server that gets new work with every request. */
+class WorkerPool {
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	/** Start the threads. Does nothing if the pool is already running. */
+	void start(int threadCount);
+
+	/** Finish the tasks that are already queued, then stop and join the threads. */
+	void stop();
+
+	/** Add a task to the queue.
+	    The task will be deleted once it has been run. */
+	void add_task(Task *task);
+
+	/** Wait until every task that has been added has finished running. */
+	void wait();
+
+	// Number of threads in the pool.
+	int size() const
+	{
+		return int(threads.size());
+	}
+private:
+	// A queue for holding the tasks, with a mutex so that only one thread uses it at a time, and a condition variable that wakes a thread up when a task is added.
+	std::queue<Task*> taskQueue;
+	std::mutex queueMutex;
+	std::condition_variable taskAdded;
+	bool stopping;
+
+	// The number of tasks that have been added but haven't finished yet, and a condition variable that is signalled when it gets to zero.
+	int unfinished;
+	std::condition_variable allFinished;
+
+	// The threads that run the tasks.
+	std::vector<std::thread*> threads;
+};
+
+#endif